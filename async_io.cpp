@@ -0,0 +1,62 @@
+#include "async_io.h"
+
+#include <exception> // For std::exception
+
+// --- Thread Pool Page Reader ---
+
+ThreadPoolPageReader::ThreadPoolPageReader(const PageFile &file, size_t threads, PageReadCompletion completion)
+    : file_(file), completion_(std::move(completion))
+{
+    for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i)
+    {
+        workers_.emplace_back(&ThreadPoolPageReader::work, this);
+    }
+}
+
+ThreadPoolPageReader::~ThreadPoolPageReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+void ThreadPoolPageReader::submit(const std::vector<PageRead> &batch)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.insert(queue_.end(), batch.begin(), batch.end());
+    }
+    work_ready_.notify_all();
+}
+
+void ThreadPoolPageReader::work()
+{
+    while (true)
+    {
+        PageRead request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&]
+                             { return stopping_ || !queue_.empty(); });
+            if (queue_.empty())
+                return; // Stopping, and nothing left to read
+            request = queue_.front();
+            queue_.pop_front();
+        }
+
+        bool ok = true;
+        try
+        {
+            file_.read(request.id, request.page);
+        }
+        catch (const std::exception &)
+        {
+            ok = false;
+        }
+        completion_(request, ok);
+    }
+}
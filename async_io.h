@@ -0,0 +1,49 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include "paged_rtree.h"
+
+#include <vector>
+#include <deque>
+#include <functional>         // For the completion callback
+#include <mutex>              // Guards the request queue
+#include <condition_variable> // Wakes the workers
+#include <thread>
+
+// --- Asynchronous Page Reads ---
+// A fixed set of threads performing blocking preads, so batches of pages are
+// read without blocking the caller. Each request names a page, the buffer to
+// read it into and a caller-defined tag; completion is reported through a
+// callback, which runs on a reader thread.
+
+struct PageRead
+{
+    PageId id = 0;
+    char *page = nullptr; // Destination, page_size bytes
+    size_t tag = 0;       // Passed back to the completion callback
+};
+
+using PageReadCompletion = std::function<void(const PageRead &request, bool ok)>;
+
+class ThreadPoolPageReader
+{
+public:
+    ThreadPoolPageReader(const PageFile &file, size_t threads, PageReadCompletion completion);
+    ~ThreadPoolPageReader(); // Finishes queued reads, then joins
+
+    // Starts reading every page of the batch; returns immediately
+    void submit(const std::vector<PageRead> &batch);
+
+private:
+    void work();
+
+    const PageFile &file_;
+    PageReadCompletion completion_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::deque<PageRead> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+#endif // ASYNC_IO_H
@@ -0,0 +1,815 @@
+#include "rtree.h"
+#include "lsm_rtree.h"
+#include "durable_rtree.h"
+#include "paged_rtree.h"
+#include "compressed_rtree.h"
+#include "snapshot_diff.h"
+#include "temporal_rtree.h"
+#include "tpr_tree.h"
+#include "standing_queries.h"
+#include "query_index.h"
+#include "index_backends.h"
+#include "grid_forest.h"
+#include "fanout_tuning.h"
+#include <chrono> // For timing
+#include <random> // For reproducible synthetic data
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip> // For std::setw, std::setprecision
+#include <span>    // For batch slices
+#include <cmath>  // For rounding coordinates to CSV-like precision
+#include <filesystem> // For the durable store's scratch directory
+#include <sstream>    // For splitting the backend list
+
+// --- Benchmark Configuration ---
+// Usage: ./rtree_benchmark [item_count] [query_count] [backends]
+// backends is a comma-separated list of spatial_index_names() (default: all)
+// The default item count builds a tree well beyond typical last-level cache sizes.
+const size_t default_item_count = 2000000;
+const size_t default_query_count = 2000;
+
+// --- Helper Functions ---
+
+// Random small boxes scattered over the world extent (fixed seed for repeatable runs)
+std::vector<DataItem> make_random_items(size_t count, unsigned seed = 42)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> lon(-180.0, 179.0);
+    std::uniform_real_distribution<double> lat(-90.0, 89.0);
+    std::uniform_real_distribution<double> extent(0.001, 0.05);
+    std::uniform_int_distribution<long> population(0, 20000000);
+
+    std::vector<DataItem> items;
+    items.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        double x = lon(rng), y = lat(rng);
+        items.emplace_back(static_cast<int>(i), "", population(rng), Rectangle(x, y, x + extent(rng), y + extent(rng)));
+    }
+    return items;
+}
+
+// Random query windows of the given size (in degrees)
+std::vector<Rectangle> make_random_queries(size_t count, double size, unsigned seed = 7)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> lon(-180.0, 180.0 - size);
+    std::uniform_real_distribution<double> lat(-90.0, 90.0 - size);
+
+    std::vector<Rectangle> queries;
+    queries.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        double x = lon(rng), y = lat(rng);
+        queries.emplace_back(x, y, x + size, y + size);
+    }
+    return queries;
+}
+
+// Runs fn() and returns elapsed wall-clock milliseconds
+template <typename Fn>
+double time_ms(Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// --- Benchmarks ---
+
+// Query throughput with software prefetching disabled and at several distances
+void bench_prefetch_distance(RTree &tree, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Prefetch Distance (count queries) ---\n";
+    std::cout << std::setw(12) << "distance" << std::setw(14) << "total ms" << std::setw(14) << "us/query" << std::setw(14) << "hits" << "\n";
+    for (size_t distance : {0, 1, 2, 4, 8, 16})
+    {
+        tree.set_prefetch_distance(distance);
+        size_t hits = 0;
+        double ms = time_ms([&]
+                            {
+                                for (const auto &query : queries)
+                                    hits += tree.count(query); });
+        std::cout << std::setw(12) << distance << std::setw(14) << std::fixed << std::setprecision(1) << ms
+                  << std::setw(14) << std::setprecision(3) << ms * 1000.0 / queries.size() << std::setw(14) << hits << "\n";
+    }
+}
+
+// Ingest throughput: per-item insert vs insert_batch in fixed-size batches
+void bench_batch_insert(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Batch Insert ---\n";
+    std::cout << std::setw(12) << "batch size" << std::setw(14) << "build ms" << std::setw(14) << "query ms" << std::setw(14) << "hits" << "\n";
+    for (size_t batch_size : {1, 1000, 10000, 100000})
+    {
+        RTree tree(4, 16);
+        double build_ms = time_ms([&]
+                                  {
+                                      std::span<const DataItem> all(items);
+                                      for (size_t start = 0; start < items.size(); start += batch_size)
+                                      {
+                                          auto batch = all.subspan(start, std::min(batch_size, items.size() - start));
+                                          if (batch_size == 1)
+                                              tree.insert(batch[0]);
+                                          else
+                                              tree.insert_batch(batch);
+                                      }
+                                      tree.tighten(); });
+        size_t hits = 0;
+        double query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += tree.count(query); });
+        std::cout << std::setw(12) << batch_size << std::setw(14) << std::fixed << std::setprecision(1) << build_ms
+                  << std::setw(14) << query_ms << std::setw(14) << hits << "\n";
+    }
+}
+
+// Sustained single-item ingest: direct descents vs buffer-tree mode
+void bench_buffered_insert(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Buffered Insert ---\n";
+    std::cout << std::setw(12) << "buffer" << std::setw(14) << "build ms" << std::setw(14) << "query ms" << std::setw(14) << "hits" << "\n";
+    for (size_t capacity : {0, 64, 256, 1024})
+    {
+        RTree tree(4, 16);
+        tree.set_insert_buffering(capacity);
+        double build_ms = time_ms([&]
+                                  {
+                                      for (const auto &item : items)
+                                          tree.insert(item);
+                                      tree.flush_buffers();
+                                      tree.tighten(); });
+        size_t hits = 0;
+        double query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += tree.count(query); });
+        std::cout << std::setw(12) << capacity << std::setw(14) << std::fixed << std::setprecision(1) << build_ms
+                  << std::setw(14) << query_ms << std::setw(14) << hits << "\n";
+    }
+}
+
+// Sustained single-item ingest into an LSM R-tree at several memtable sizes
+void bench_lsm_ingest(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- LSM Ingest ---\n";
+    std::cout << std::setw(12) << "memtable" << std::setw(14) << "build ms" << std::setw(14) << "query ms" << std::setw(14) << "hits" << std::setw(8) << "runs" << "\n";
+    for (size_t capacity : {4096, 65536, 262144})
+    {
+        LsmRTree index(capacity);
+        double build_ms = time_ms([&]
+                                  {
+                                      for (const auto &item : items)
+                                          index.insert(item); });
+        size_t hits = 0;
+        double query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += index.count(query); });
+        std::cout << std::setw(12) << capacity << std::setw(14) << std::fixed << std::setprecision(1) << build_ms
+                  << std::setw(14) << query_ms << std::setw(14) << hits << std::setw(8) << index.run_count() << "\n";
+    }
+}
+
+// Logged ingest at several group-commit sizes, then restart (recovery) time.
+// Fsync latency dominates small groups, so this uses at most 100k items.
+void bench_durable_ingest(const std::vector<DataItem> &items)
+{
+    const std::string directory = (std::filesystem::temp_directory_path() / "rtree_benchmark_store").string();
+    const size_t count = std::min<size_t>(items.size(), 100000);
+    std::cout << "\n--- Durable Ingest (" << count << " items) ---\n";
+    std::cout << std::setw(12) << "group" << std::setw(14) << "build ms" << std::setw(14) << "reopen ms" << std::setw(14) << "replayed" << "\n";
+    for (size_t group : {16, 256, 4096})
+    {
+        std::filesystem::remove_all(directory);
+        double build_ms = time_ms([&]
+                                  {
+                                      DurableRTree store(directory, group, count / 3);
+                                      for (size_t i = 0; i < count; ++i)
+                                          store.insert(items[i]); });
+        size_t replayed = 0;
+        double reopen_ms = time_ms([&]
+                                   {
+                                       DurableRTree store(directory, group, count / 3);
+                                       replayed = store.recovered_records(); });
+        std::cout << std::setw(12) << group << std::setw(14) << std::fixed << std::setprecision(1) << build_ms
+                  << std::setw(14) << reopen_ms << std::setw(14) << replayed << "\n";
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// Disk-resident tree: query cost and page reads per query at several pool
+// sizes, reading pages synchronously or prefetching children asynchronously.
+// The OS page cache is dropped before each run, so the first visits are cold.
+void bench_paged_tree(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "rtree_benchmark.pages").string();
+    double build_ms = time_ms([&]
+                              { PagedRTree::build(path, items, 8192); });
+    std::cout << "\n--- Paged Tree (8 KiB pages, built in " << std::fixed << std::setprecision(1) << build_ms << " ms) ---\n";
+    std::cout << std::setw(12) << "pool pages" << std::setw(12) << "io threads" << std::setw(14) << "query ms" << std::setw(14) << "reads/query" << std::setw(14) << "hits" << "\n";
+    for (size_t pool_pages : {16, 256, 4096})
+    {
+        for (size_t io_threads : {0, 4})
+        {
+            PageFile(path, 8192, false).drop_os_cache();
+            PagedRTree tree(path, pool_pages, io_threads);
+            size_t hits = 0;
+            double query_ms = time_ms([&]
+                                      {
+                                          for (const auto &query : queries)
+                                              hits += tree.count(query); });
+            std::cout << std::setw(12) << pool_pages << std::setw(12) << io_threads << std::setw(14) << std::setprecision(1) << query_ms
+                      << std::setw(14) << std::setprecision(2) << double(tree.pool().reads()) / queries.size() << std::setw(14) << hits << "\n";
+        }
+    }
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".names");
+}
+
+// Compressed leaves vs a packed RTree: resident bytes per item and query time,
+// for full-precision coordinates and for coordinates with 4 decimals (as read from CSV)
+void bench_compressed_leaves(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::vector<DataItem> rounded = items;
+    for (auto &item : rounded)
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            item.bounds.min_corner[i] = std::round(item.bounds.min_corner[i] * 1e4) / 1e4;
+            item.bounds.max_corner[i] = std::round(item.bounds.max_corner[i] * 1e4) / 1e4;
+        }
+    }
+
+    std::cout << "\n--- Compressed Leaves ---\n";
+    std::cout << std::setw(12) << "data" << std::setw(12) << "tree" << std::setw(14) << "bytes/item" << std::setw(14) << "query ms" << std::setw(14) << "hits" << "\n";
+    auto report = [&](const char *label, const char *tree_name, double bytes, size_t count, auto &tree)
+    {
+        size_t hits = 0;
+        double query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += tree.search(query).size(); });
+        std::cout << std::setw(12) << label << std::setw(12) << tree_name << std::setw(14) << std::setprecision(1) << bytes / count
+                  << std::setw(14) << query_ms << std::setw(14) << hits << "\n";
+    };
+    auto compare = [&](const char *label, const std::vector<DataItem> &data)
+    {
+        RTree packed(4, 16);
+        packed.bulk_load(data);
+        packed.tighten();
+        // Leaf payload only: each entry's box plus its DataItem
+        report(label, "RTree", double(data.size() * (sizeof(Rectangle) + sizeof(DataItem))), data.size(), packed);
+        CompressedRTree compressed(data);
+        report(label, "compressed", double(compressed.memory_bytes()), data.size(), compressed);
+    };
+    compare("full", items);
+    compare("4 places", rounded);
+}
+
+// Full snapshot vs delta size after updating a small share of the items
+void bench_snapshot_delta(const std::vector<DataItem> &items)
+{
+    std::cout << "\n--- Snapshot Deltas ---\n";
+    std::cout << std::setw(12) << "changed" << std::setw(14) << "full KiB" << std::setw(14) << "delta KiB" << std::setw(14) << "apply ms" << "\n";
+    BucketSnapshot base(items, 1);
+    std::vector<char> full = base.serialize();
+    for (size_t changed : {10, 1000, 10000})
+    {
+        // Population updates spread over the dataset, one in ten also moves
+        std::vector<DataItem> next = items;
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<size_t> pick(0, next.size() - 1);
+        for (size_t i = 0; i < changed; ++i)
+        {
+            DataItem &item = next[pick(rng)];
+            item.population += 1;
+            if (i % 10 == 0)
+                item.bounds = Rectangle(item.bounds.min_corner[0] / 2, item.bounds.min_corner[1] / 2,
+                                        item.bounds.min_corner[0] / 2 + 0.01, item.bounds.min_corner[1] / 2 + 0.01);
+        }
+        std::vector<char> delta = base.diff(BucketSnapshot(next, 2));
+
+        BucketSnapshot replica = BucketSnapshot::deserialize(full);
+        double apply_ms = time_ms([&]
+                                  { replica.apply(delta); });
+        std::cout << std::setw(12) << changed << std::setw(14) << std::setprecision(1) << full.size() / 1024.0
+                  << std::setw(14) << delta.size() / 1024.0 << std::setw(14) << apply_ms << "\n";
+    }
+}
+
+// Point-in-time versions: update cost and retained nodes for 8 kept versions
+void bench_versions(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Versioned Snapshots (8 retained) ---\n";
+    std::cout << std::setw(12) << "changes/ver" << std::setw(14) << "update ms" << std::setw(14) << "nodes" << std::setw(14) << "vs 1 tree"
+              << std::setw(14) << "old query ms" << "\n";
+    for (size_t changes : {100, 1000, 10000})
+    {
+        RTree tree(4, 16);
+        tree.bulk_load(items);
+        size_t single_tree_nodes = tree.retained_node_count();
+        tree.set_version_retention(8);
+        std::uint64_t oldest = tree.commit_version();
+
+        // Each version moves `changes` random items a little
+        std::vector<DataItem> current = items;
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<size_t> pick(0, current.size() - 1);
+        double update_ms = 0;
+        for (int version = 1; version < 8; ++version)
+        {
+            update_ms += time_ms([&]
+                                 {
+                                     for (size_t i = 0; i < changes; ++i)
+                                     {
+                                         DataItem &item = current[pick(rng)];
+                                         tree.remove(item);
+                                         item.bounds = Rectangle(item.bounds.min_corner[0] + 0.01, item.bounds.min_corner[1],
+                                                                 item.bounds.max_corner[0] + 0.01, item.bounds.max_corner[1]);
+                                         tree.insert(item);
+                                     } });
+            tree.commit_version();
+        }
+        size_t hits = 0;
+        double query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += tree.count(query, oldest); });
+        std::cout << std::setw(12) << changes << std::setw(14) << std::setprecision(1) << update_ms
+                  << std::setw(14) << tree.retained_node_count() << std::setw(13) << std::setprecision(2)
+                  << double(tree.retained_node_count()) / single_tree_nodes << "x" << std::setw(14) << std::setprecision(1) << query_ms << "\n";
+    }
+}
+
+// Time-slice queries over 10 yearly versions: one temporal index vs a tree per year
+void bench_temporal(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Temporal Index (10 yearly versions, up to 200k items) ---\n";
+    std::cout << std::setw(16) << "index" << std::setw(14) << "build ms" << std::setw(14) << "query ms" << std::setw(14) << "hits" << "\n";
+    const int years = 10;
+    auto population = [](const DataItem &item, int year)
+    { return item.population + year * (item.id % 7); };
+
+    // Every item gets a new figure each year (at most 200k items, so ten
+    // copies of the data fit in memory)
+    std::span<const DataItem> base = std::span<const DataItem>(items).first(std::min<size_t>(items.size(), 200000));
+    std::vector<TemporalDataItem> versions;
+    versions.reserve(base.size() * years);
+    for (int year = 0; year < years; ++year)
+    {
+        for (const auto &item : base)
+            versions.emplace_back(item.id, item.name, population(item, year), item.bounds, 2000.0 + year,
+                                  year + 1 < years ? 2001.0 + year : TemporalDataItem::forever);
+    }
+    TemporalRTree temporal;
+    double temporal_build_ms = time_ms([&]
+                                       { temporal.insert_batch(versions); });
+    size_t temporal_hits = 0;
+    double temporal_query_ms = time_ms([&]
+                                       {
+                                           for (size_t i = 0; i < queries.size(); ++i)
+                                               temporal_hits += temporal.count_at(queries[i], 2000.5 + i % years); });
+
+    std::vector<std::unique_ptr<RTree>> per_year;
+    double per_year_build_ms = time_ms([&]
+                                       {
+                                           for (int year = 0; year < years; ++year)
+                                           {
+                                               std::vector<DataItem> year_items(base.begin(), base.end());
+                                               for (auto &item : year_items)
+                                                   item.population = population(item, year);
+                                               per_year.push_back(std::make_unique<RTree>(4, 16));
+                                               per_year.back()->bulk_load(year_items);
+                                           } });
+    size_t per_year_hits = 0;
+    double per_year_query_ms = time_ms([&]
+                                       {
+                                           for (size_t i = 0; i < queries.size(); ++i)
+                                               per_year_hits += per_year[i % years]->count(queries[i]); });
+
+    std::cout << std::setw(16) << "temporal" << std::setw(14) << std::setprecision(1) << temporal_build_ms
+              << std::setw(14) << temporal_query_ms << std::setw(14) << temporal_hits << "\n";
+    std::cout << std::setw(16) << "tree per year" << std::setw(14) << per_year_build_ms
+              << std::setw(14) << per_year_query_ms << std::setw(14) << per_year_hits << "\n";
+}
+
+// Moving objects: reinserting every position into an RTree each tick vs
+// updating a TPR-tree only when an object changes course (10% per tick)
+void bench_moving_objects(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Moving Objects (5 ticks, up to 100k objects) ---\n";
+    std::cout << std::setw(16) << "index" << std::setw(14) << "updates" << std::setw(14) << "update ms" << std::setw(14) << "query ms" << std::setw(14) << "hits" << "\n";
+    const int ticks = 5;
+    std::span<const DataItem> base = std::span<const DataItem>(items).first(std::min<size_t>(items.size(), 100000));
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> speed(-0.05, 0.05);
+    std::vector<MovingItem> objects;
+    objects.reserve(base.size());
+    for (const auto &item : base)
+        objects.emplace_back(item.id, item.name, item.population, item.bounds, Point(speed(rng), speed(rng)), 0.0);
+
+    // Course changes per tick, decided up front so both indexes see the same motion
+    std::vector<std::vector<MovingItem>> motions(ticks + 1, objects);
+    for (int tick = 1; tick <= ticks; ++tick)
+    {
+        motions[tick] = motions[tick - 1];
+        for (size_t i = tick % 10; i < objects.size(); i += 10)
+        {
+            MovingItem &object = motions[tick][i];
+            object = MovingItem(object.id, object.name, object.population, object.bounds_at(tick), Point(speed(rng), speed(rng)), tick);
+        }
+    }
+
+    RTree positions(4, 16);
+    size_t rtree_updates = 0;
+    double rtree_ms = time_ms([&]
+                              {
+                                  std::vector<DataItem> current(base.begin(), base.end());
+                                  positions.insert_batch(current);
+                                  for (int tick = 1; tick <= ticks; ++tick)
+                                  {
+                                      for (size_t i = 0; i < current.size(); ++i)
+                                      {
+                                          positions.remove(current[i]);
+                                          current[i].bounds = motions[tick][i].bounds_at(tick);
+                                          positions.insert(current[i]);
+                                          ++rtree_updates;
+                                      }
+                                  } });
+    size_t rtree_hits = 0;
+    double rtree_query_ms = time_ms([&]
+                                    {
+                                        for (const auto &query : queries)
+                                            rtree_hits += positions.count(query); });
+
+    TPRTree moving(ticks);
+    size_t tpr_updates = 0;
+    double tpr_ms = time_ms([&]
+                            {
+                                for (const auto &object : motions[0])
+                                    moving.update(object);
+                                for (int tick = 1; tick <= ticks; ++tick)
+                                {
+                                    for (size_t i = tick % 10; i < objects.size(); i += 10)
+                                    {
+                                        moving.update(motions[tick][i]);
+                                        ++tpr_updates;
+                                    }
+                                } });
+    size_t tpr_hits = 0;
+    double tpr_query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          tpr_hits += moving.count_at(query, ticks); });
+
+    std::cout << std::setw(16) << "RTree reinsert" << std::setw(14) << rtree_updates << std::setw(14) << std::setprecision(1) << rtree_ms
+              << std::setw(14) << rtree_query_ms << std::setw(14) << rtree_hits << "\n";
+    std::cout << std::setw(16) << "TPR-tree" << std::setw(14) << tpr_updates << std::setw(14) << tpr_ms
+              << std::setw(14) << tpr_query_ms << std::setw(14) << tpr_hits << "\n";
+}
+
+// Alerting: re-running every standing query after each batch of updates vs
+// maintaining their results incrementally from deltas
+void bench_standing_queries(const std::vector<DataItem> &items)
+{
+    std::cout << "\n--- Standing Queries (1000 queries, 10 polls of 1000 updates) ---\n";
+    std::cout << std::setw(16) << "method" << std::setw(14) << "total ms" << std::setw(14) << "changes" << "\n";
+    std::span<const DataItem> base = std::span<const DataItem>(items).first(std::min<size_t>(items.size(), 200000));
+    std::vector<Rectangle> query_rects = make_random_queries(1000, 2.0, 17);
+    const long min_population = 5000000;
+
+    // The same random population updates for both methods
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<size_t> pick(0, base.size() - 1);
+    std::uniform_int_distribution<long> population(0, 20000000);
+    std::vector<DataItem> updates;
+    for (int i = 0; i < 10000; ++i)
+    {
+        DataItem item = base[pick(rng)];
+        item.population = population(rng);
+        updates.push_back(item);
+    }
+
+    RTree tree(4, 16);
+    tree.insert_batch(base);
+    size_t rerun_changes = 0;
+    double rerun_ms = time_ms([&]
+                              {
+                                  std::vector<size_t> previous(query_rects.size(), 0);
+                                  for (size_t poll = 0; poll < 10; ++poll)
+                                  {
+                                      for (size_t i = poll * 1000; i < (poll + 1) * 1000; ++i)
+                                      {
+                                          tree.remove(updates[i]);
+                                          tree.insert(updates[i]);
+                                      }
+                                      for (size_t q = 0; q < query_rects.size(); ++q)
+                                      {
+                                          size_t hits = tree.search_with_population(query_rects[q], min_population).size();
+                                          rerun_changes += hits != previous[q];
+                                          previous[q] = hits;
+                                      }
+                                  } });
+
+    MonitoredRTree monitored(4, 16);
+    monitored.insert_batch(base);
+    for (const auto &rect : query_rects)
+        monitored.register_query(rect, min_population);
+    size_t delta_count = 0;
+    double delta_ms = time_ms([&]
+                              {
+                                  for (size_t poll = 0; poll < 10; ++poll)
+                                  {
+                                      for (size_t i = poll * 1000; i < (poll + 1) * 1000; ++i)
+                                          monitored.insert(updates[i]);
+                                      delta_count += monitored.drain_deltas().size();
+                                  } });
+
+    std::cout << std::setw(16) << "re-run queries" << std::setw(14) << std::setprecision(1) << rerun_ms << std::setw(14) << rerun_changes << " (queries whose count changed)\n";
+    std::cout << std::setw(16) << "deltas" << std::setw(14) << delta_ms << std::setw(14) << delta_count << " (deltas)\n";
+}
+
+// Geofencing: matching a stream of point events against up to 1M fences
+void bench_query_index(const std::vector<DataItem> &items)
+{
+    std::cout << "\n--- Reverse Query Index (up to 1M fences, 100k events) ---\n";
+    std::cout << std::setw(16) << "method" << std::setw(14) << "build ms" << std::setw(14) << "events/s" << std::setw(14) << "matches" << "\n";
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<double> fence_size(0.05, 0.5);
+    std::uniform_int_distribution<long> threshold(0, 20000000);
+    std::vector<Subscription> fences;
+    size_t fence_count = std::min<size_t>(items.size(), 1000000);
+    fences.reserve(fence_count);
+    for (size_t i = 0; i < fence_count; ++i)
+    {
+        const Rectangle &at = items[i].bounds;
+        double w = fence_size(rng), h = fence_size(rng);
+        long min_population = i % 4 == 0 ? threshold(rng) : std::numeric_limits<long>::min();
+        fences.push_back({static_cast<int>(i), Rectangle(at.min_corner.x, at.min_corner.y, at.min_corner.x + w, at.min_corner.y + h), min_population});
+    }
+    std::vector<DataItem> events;
+    for (const auto &query : make_random_queries(100000, 0.0, 29))
+        events.emplace_back(0, "", threshold(rng), query);
+
+    QueryIndex index;
+    double build_ms = time_ms([&]
+                              { index.add_batch(fences); });
+    size_t matches = 0;
+    std::vector<int> ids;
+    double match_ms = time_ms([&]
+                              {
+                                  for (const auto &event : events)
+                                  {
+                                      ids.clear();
+                                      matches += index.match(event, ids);
+                                  } });
+
+    // A linear scan over all fences, timed on the first 100 events only
+    const size_t scanned = std::min<size_t>(100, events.size());
+    size_t scan_matches = 0;
+    double scan_ms = time_ms([&]
+                             {
+                                 for (size_t e = 0; e < scanned; ++e)
+                                     for (const auto &fence : fences)
+                                         scan_matches += fence.matches(events[e]); });
+
+    std::cout << std::setw(16) << "QueryIndex" << std::setw(14) << std::setprecision(1) << build_ms << std::setw(14) << std::setprecision(0)
+              << events.size() / (match_ms / 1000.0) << std::setw(14) << matches << "\n";
+    std::cout << std::setw(16) << "linear scan" << std::setw(14) << "-" << std::setw(14) << scanned / (scan_ms / 1000.0)
+              << std::setw(14) << scan_matches << " (first " << scanned << " events)\n";
+    std::cout << std::setprecision(1);
+}
+
+// Every SpatialIndex backend on the same items and queries: batch build time,
+// then small windows, large windows and a population-filtered search
+void bench_backends(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries, const std::vector<std::string> &names)
+{
+    std::cout << "\n--- Spatial Index Backends ---\n";
+    std::cout << std::setw(12) << "backend" << std::setw(12) << "build ms" << std::setw(14) << "1deg q/s" << std::setw(14) << "10deg q/s"
+              << std::setw(14) << "pop q/s" << std::setw(12) << "hits" << "\n";
+    std::vector<Rectangle> large_queries = make_random_queries(std::max<size_t>(queries.size() / 10, 1), 10.0, 37);
+    for (const auto &name : names)
+    {
+        std::unique_ptr<SpatialIndex> index = make_spatial_index(name);
+        double build_ms = time_ms([&]
+                                  { index->insert_batch(items); });
+        size_t hits = 0;
+        double small_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += index->count(query); });
+        double large_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : large_queries)
+                                          hits += index->count(query); });
+        double population_ms = time_ms([&]
+                                       {
+                                           for (const auto &query : queries)
+                                               hits += index->search_with_population(query, 10000000).size(); });
+        std::cout << std::setw(12) << name << std::setw(12) << std::setprecision(1) << build_ms << std::setprecision(0)
+                  << std::setw(14) << queries.size() / (small_ms / 1000.0) << std::setw(14) << large_queries.size() / (large_ms / 1000.0)
+                  << std::setw(14) << queries.size() / (population_ms / 1000.0) << std::setw(12) << hits << "\n";
+    }
+    std::cout << std::setprecision(1);
+}
+
+// A pure point layer (item min corners) packed with point leaves, against the
+// same points stored as boxes of a tiny extent (regular box leaves)
+void bench_point_leaves(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Point Leaves (bulk-loaded points) ---\n";
+    std::cout << std::setw(16) << "leaf layout" << std::setw(14) << "leaf MB" << std::setw(14) << "query ms" << std::setw(14) << "hits" << "\n";
+    std::vector<DataItem> points, tiny_boxes;
+    points.reserve(items.size());
+    tiny_boxes.reserve(items.size());
+    for (const auto &item : items)
+    {
+        const Point &at = item.bounds.min_corner;
+        points.emplace_back(item.id, "", item.population, Rectangle(at.x, at.y, at.x, at.y));
+        tiny_boxes.emplace_back(item.id, "", item.population, Rectangle(at.x, at.y, at.x + 1e-9, at.y + 1e-9));
+    }
+    auto run = [&](const char *label, const std::vector<DataItem> &layer, size_t entry_bytes)
+    {
+        RTree tree(4, 16);
+        tree.bulk_load(layer);
+        tree.count(queries.front()); // Tighten outside the timed loop
+        size_t hits = 0;
+        double query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += tree.count(query); });
+        std::cout << std::setw(16) << label << std::setw(14) << std::setprecision(1) << layer.size() * entry_bytes / 1e6
+                  << std::setw(14) << query_ms << std::setw(14) << hits << "\n";
+    };
+    run("points", points, sizeof(Point));
+    run("boxes", tiny_boxes, sizeof(Rectangle));
+}
+
+// One packed RTree against a GridForest of packed per-cell trees, for small
+// windows (where the forest skips the upper levels) and whole-world counts
+void bench_grid_forest(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Grid Forest (both bulk-loaded) ---\n";
+    std::cout << std::setw(18) << "index" << std::setw(12) << "build ms" << std::setw(14) << "0.1deg q/s" << std::setw(14) << "1deg q/s"
+              << std::setw(14) << "world ms" << std::setw(12) << "hits" << "\n";
+    std::vector<Rectangle> tiny_queries = make_random_queries(queries.size() * 10, 0.1, 41);
+    auto run = [&](const std::string &label, auto &index, auto &&load)
+    {
+        double build_ms = time_ms(load);
+        index.count(queries.front()); // Tighten outside the timed loops
+        size_t hits = 0;
+        double tiny_ms = time_ms([&]
+                                 {
+                                     for (const auto &query : tiny_queries)
+                                         hits += index.count(query); });
+        double small_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += index.count(query); });
+        double world_ms = time_ms([&]
+                                  { hits += index.count(Rectangle(-180, -90, 180, 90)); });
+        std::cout << std::setw(18) << label << std::setw(12) << std::setprecision(1) << build_ms << std::setprecision(0)
+                  << std::setw(14) << tiny_queries.size() / (tiny_ms / 1000.0) << std::setw(14) << queries.size() / (small_ms / 1000.0)
+                  << std::setw(14) << std::setprecision(1) << world_ms << std::setw(12) << hits << "\n";
+    };
+    RTree tree(4, 16);
+    run("RTree", tree, [&]
+        { tree.bulk_load(items); });
+    for (size_t per_cell : {1024, 4096, 16384})
+    {
+        GridForest forest;
+        run("forest/" + std::to_string(per_cell), forest, [&]
+            { forest.bulk_load(items, per_cell); });
+    }
+}
+
+// Cell-covering queries over the sorted key array against the R-tree's
+// traversal, on the item boxes and on a point layer of their corners
+void bench_cell_cover(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    std::cout << "\n--- Cell Cover vs R-Tree Traversal (bulk-loaded) ---\n";
+    std::cout << std::setw(8) << "layer" << std::setw(8) << "window" << std::setw(14) << "RTree q/s" << std::setw(14) << "cover q/s"
+              << std::setw(14) << "ranges/q" << std::setw(12) << "hits" << "\n";
+    std::vector<DataItem> points;
+    points.reserve(items.size());
+    for (const auto &item : items)
+        points.emplace_back(item.id, "", item.population, Rectangle(item.bounds.min_corner, item.bounds.min_corner));
+
+    for (const auto &[layer, data] : {std::pair<const char *, const std::vector<DataItem> *>{"boxes", &items}, {"points", &points}})
+    {
+        RTree tree(4, 16);
+        tree.bulk_load(*data);
+        CellCoverIndex cover;
+        cover.insert_batch(*data);
+        for (double window : {0.1, 1.0, 10.0})
+        {
+            std::vector<Rectangle> windows = make_random_queries(window < 1 ? queries.size() * 10 : window > 1 ? queries.size() / 10 : queries.size(), window, 43);
+            size_t tree_hits = 0, cover_hits = 0, ranges = 0;
+            tree.count(windows.front()); // Tighten outside the timed loop
+            double tree_ms = time_ms([&]
+                                     {
+                                         for (const auto &query : windows)
+                                             tree_hits += tree.count(query); });
+            double cover_ms = time_ms([&]
+                                      {
+                                          for (const auto &query : windows)
+                                              cover_hits += cover.count(query); });
+            for (const auto &query : windows)
+                ranges += cover.cell_ranges(query).size();
+            std::cout << std::setw(8) << layer << std::setw(8) << std::setprecision(1) << window << std::setprecision(0)
+                      << std::setw(14) << windows.size() / (tree_ms / 1000.0) << std::setw(14) << windows.size() / (cover_ms / 1000.0)
+                      << std::setw(14) << std::setprecision(1) << static_cast<double>(ranges) / windows.size()
+                      << std::setw(12) << (tree_hits == cover_hits ? std::to_string(cover_hits) : "MISMATCH") << "\n";
+        }
+    }
+}
+
+// Fixed node capacities against the ones tune_fan_out measures on a 100k
+// sample of the items (all trees bulk-loaded with the full data)
+void bench_fan_out(const std::vector<DataItem> &items, const std::vector<Rectangle> &queries)
+{
+    CacheInfo cache = detect_cache_info();
+    std::cout << "\n--- Fan-Out Tuning (line " << cache.line_size << " B, L1d " << cache.l1_data_size / 1024 << " KiB, L2 "
+              << cache.l2_size / 1024 << " KiB) ---\n";
+    FanOutTuning tuning;
+    double tuning_ms = time_ms([&]
+                               { tuning = tune_fan_out(items, queries); });
+    std::cout << std::setw(12) << "internal" << std::setw(12) << "leaf" << std::setw(16) << "sample ms\n";
+    for (const auto &trial : tuning.trials)
+        std::cout << std::setw(12) << trial.fan_out.max_entries << std::setw(12) << trial.fan_out.max_leaf_entries << std::setw(14)
+                  << std::setprecision(2) << trial.query_ms << "\n";
+    std::cout << "Tuning took " << std::setprecision(1) << tuning_ms << " ms\n";
+
+    std::cout << std::setw(16) << "fan-out" << std::setw(14) << "build ms" << std::setw(14) << "query ms" << std::setw(14) << "hits" << "\n";
+    auto run = [&](const std::string &label, const FanOut &fan_out)
+    {
+        RTree tree(fan_out);
+        double build_ms = time_ms([&]
+                                  { tree.bulk_load(items); });
+        tree.count(queries.front()); // Tighten outside the timed loop
+        size_t hits = 0;
+        double query_ms = time_ms([&]
+                                  {
+                                      for (const auto &query : queries)
+                                          hits += tree.count(query); });
+        std::cout << std::setw(16) << label << std::setw(14) << build_ms << std::setw(14) << query_ms << std::setw(14) << hits << "\n";
+    };
+    run("2/4 (default)", FanOut{2, 4, 2, 4});
+    run("4/16", FanOut{4, 16, 4, 16});
+    run("tuned " + std::to_string(tuning.best.max_entries) + "/" + std::to_string(tuning.best.max_leaf_entries), tuning.best);
+}
+
+// --- Main Function ---
+int main(int argc, char *argv[])
+{
+    size_t item_count = argc > 1 ? std::stoul(argv[1]) : default_item_count;
+    size_t query_count = argc > 2 ? std::stoul(argv[2]) : default_query_count;
+    std::vector<std::string> backends = spatial_index_names();
+    if (argc > 3)
+    {
+        backends.clear();
+        std::stringstream list(argv[3]);
+        std::string name;
+        while (std::getline(list, name, ','))
+            backends.push_back(name);
+    }
+
+    std::cout << "===== R-Tree Benchmarks =====\n";
+    std::cout << "Items: " << item_count << ", Queries: " << query_count << "\n";
+
+    std::vector<DataItem> items = make_random_items(item_count);
+    std::vector<Rectangle> queries = make_random_queries(query_count, 1.0);
+
+    RTree tree(4, 16);
+    double build_ms = time_ms([&]
+                              {
+                                  for (const auto &item : items)
+                                      tree.insert(item); });
+    std::cout << "Built tree by repeated insert in " << std::fixed << std::setprecision(1) << build_ms << " ms\n";
+
+    bench_prefetch_distance(tree, queries);
+    bench_batch_insert(items, queries);
+    bench_buffered_insert(items, queries);
+    bench_lsm_ingest(items, queries);
+    bench_durable_ingest(items);
+    bench_paged_tree(items, queries);
+    bench_compressed_leaves(items, queries);
+    bench_snapshot_delta(items);
+    bench_versions(items, queries);
+    bench_temporal(items, queries);
+    bench_moving_objects(items, queries);
+    bench_standing_queries(items);
+    bench_query_index(items);
+    bench_backends(items, queries, backends);
+    bench_point_leaves(items, queries);
+    bench_grid_forest(items, queries);
+    bench_cell_cover(items, queries);
+    bench_fan_out(items, queries);
+
+    std::cout << "\n===== Benchmarks Completed =====\n";
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "compressed_rtree.h"
+
+#include <limits> // For the "no population filter" value
+
+// --- Construction ---
+
+CompressedRTree::CompressedRTree(std::span<const DataItem> items, size_t leaf_size, size_t fanout)
+    : item_count_(items.size())
+{
+    leaf_size = std::max<size_t>(leaf_size, 1);
+    fanout = std::max<size_t>(fanout, 2);
+    if (items.empty())
+        return;
+
+    // Order the items along the Hilbert curve
+    auto keyed = curve_order(items, [](const DataItem &item)
+                             { return item.bounds; });
+
+    // Leaves of (up to) leaf_size consecutive items
+    std::vector<DataItem> block;
+    for (size_t begin = 0; begin < keyed.size(); begin += leaf_size)
+    {
+        size_t end = std::min(keyed.size(), begin + leaf_size);
+        block.clear();
+        Rectangle bounds = Rectangle::empty();
+        for (size_t k = begin; k < end; ++k)
+        {
+            block.push_back(items[keyed[k].second]);
+            bounds.expand(items[keyed[k].second].bounds);
+        }
+        leaves_.push_back(CompressedLeaf::encode(block));
+        leaf_bounds_.push_back(bounds);
+    }
+
+    // Internal levels until one branch covers everything
+    std::span<const Rectangle> below(leaf_bounds_);
+    std::vector<Rectangle> level_bounds;
+    do
+    {
+        std::vector<Branch> level;
+        for (size_t begin = 0; begin < below.size(); begin += fanout)
+        {
+            size_t end = std::min(below.size(), begin + fanout);
+            Branch branch{combine_all(below.subspan(begin, end - begin)), static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end - begin)};
+            level.push_back(branch);
+        }
+        level_bounds.clear();
+        for (const auto &branch : level)
+            level_bounds.push_back(branch.bounds);
+        levels_.push_back(std::move(level));
+        below = std::span<const Rectangle>(level_bounds);
+    } while (levels_.back().size() > 1);
+}
+
+size_t CompressedRTree::memory_bytes() const
+{
+    size_t total = leaves_.capacity() * sizeof(CompressedLeaf) + leaf_bounds_.capacity() * sizeof(Rectangle);
+    for (const auto &leaf : leaves_)
+        total += leaf.memory_bytes();
+    for (const auto &level : levels_)
+        total += level.capacity() * sizeof(Branch);
+    return total;
+}
+
+// --- Queries ---
+
+template <typename Visit>
+void CompressedRTree::traverse(const Rectangle &query_rect, long min_population, Visit &&visit) const
+{
+    if (levels_.empty())
+        return;
+
+    // (level, index) pairs; level -1 denotes a leaf
+    std::vector<std::pair<int, std::uint32_t>> pending;
+    for (std::uint32_t i = 0; i < levels_.back().size(); ++i)
+        pending.emplace_back(static_cast<int>(levels_.size()) - 1, i);
+    std::vector<std::uint32_t> matches;
+    while (!pending.empty())
+    {
+        auto [level, index] = pending.back();
+        pending.pop_back();
+        if (level < 0)
+        {
+            matches.clear();
+            leaves_[index].scan(query_rect, min_population, matches);
+            for (std::uint32_t entry : matches)
+                visit(leaves_[index], entry);
+            continue;
+        }
+        const Branch &branch = levels_[level][index];
+        if (!branch.bounds.intersects(query_rect))
+            continue;
+        // Reverse order keeps the depth-first visit in curve order
+        for (std::uint32_t child = branch.first + branch.count; child-- > branch.first;)
+        {
+            const Rectangle &child_bounds = level == 0 ? leaf_bounds_[child] : levels_[level - 1][child].bounds;
+            if (child_bounds.intersects(query_rect))
+                pending.emplace_back(level - 1, child);
+        }
+    }
+}
+
+std::vector<DataItem> CompressedRTree::search_with_population(const Rectangle &query_rect, long min_population) const
+{
+    std::vector<DataItem> results;
+    traverse(query_rect, min_population, [&](const CompressedLeaf &leaf, std::uint32_t entry)
+             { results.push_back(leaf.item(entry)); });
+    return results;
+}
+
+std::vector<DataItem> CompressedRTree::search(const Rectangle &query_rect) const
+{
+    return search_with_population(query_rect, std::numeric_limits<long>::min());
+}
+
+size_t CompressedRTree::count(const Rectangle &query_rect) const
+{
+    size_t total = 0;
+    traverse(query_rect, std::numeric_limits<long>::min(), [&](const CompressedLeaf &, std::uint32_t)
+             { ++total; });
+    return total;
+}
@@ -0,0 +1,51 @@
+#ifndef COMPRESSED_RTREE_H
+#define COMPRESSED_RTREE_H
+
+#include "rtree.h"
+#include "leaf_codec.h"
+
+#include <vector>
+#include <cstdint>
+#include <span>
+
+// --- Compressed R-Tree ---
+// A read-only, bulk-loaded R-Tree whose leaves are CompressedLeaf blocks.
+// Items are packed along the Hilbert curve into leaves of leaf_size entries
+// (larger leaves compress better, since neighbours share their high bits);
+// internal levels are flat arrays of (bounds, first child, child count).
+// Meant for data that is built once and queried many times, e.g. snapshots
+// of a live RTree. Queries are const and keep no state, so concurrent
+// queries are safe.
+class CompressedRTree
+{
+public:
+    explicit CompressedRTree(std::span<const DataItem> items, size_t leaf_size = 64, size_t fanout = 16);
+
+    std::vector<DataItem> search(const Rectangle &query_rect) const;
+    std::vector<DataItem> search_with_population(const Rectangle &query_rect, long min_population) const;
+    size_t count(const Rectangle &query_rect) const;
+
+    size_t size() const { return item_count_; }
+    size_t leaf_count() const { return leaves_.size(); }
+    // Bytes held by leaves and internal levels
+    size_t memory_bytes() const;
+
+private:
+    struct Branch
+    {
+        Rectangle bounds;
+        std::uint32_t first; // First child in the level below (or first leaf)
+        std::uint32_t count;
+    };
+
+    // Calls visit(leaf, entry) for every entry matching the query
+    template <typename Visit>
+    void traverse(const Rectangle &query_rect, long min_population, Visit &&visit) const;
+
+    std::vector<CompressedLeaf> leaves_;
+    std::vector<Rectangle> leaf_bounds_;
+    std::vector<std::vector<Branch>> levels_; // levels_[0] groups leaves; levels_.back() holds the root
+    size_t item_count_ = 0;
+};
+
+#endif // COMPRESSED_RTREE_H
@@ -0,0 +1,94 @@
+#include "durable_rtree.h"
+
+#include <limits>     // For the all-covering rectangle
+#include <filesystem> // For creating the store directory
+
+// Node fan-out of the in-memory tree
+static const size_t durable_min_entries = 4;
+static const size_t durable_max_entries = 16;
+
+// Creates the directory before the log member opens its file inside it
+static std::string store_file(const std::string &directory, const char *name)
+{
+    std::filesystem::create_directories(directory);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+// --- Construction and Recovery ---
+
+DurableRTree::DurableRTree(const std::string &directory, size_t group_commit_records, size_t checkpoint_records)
+    : snapshot_path_(store_file(directory, "snapshot.bin")),
+      wal_(store_file(directory, "wal.log"), group_commit_records),
+      checkpoint_records_(std::max<size_t>(checkpoint_records, 1)),
+      tree_(std::make_unique<RTree>(durable_min_entries, durable_max_entries))
+{
+    std::uint64_t snapshot_lsn = 0;
+    std::vector<DataItem> items;
+    if (read_snapshot(snapshot_path_, snapshot_lsn, items))
+    {
+        tree_->bulk_load(items);
+        for (const auto &item : items)
+        {
+            bounds_[item.id] = item.bounds;
+        }
+    }
+
+    // Records up to snapshot_lsn are already in the snapshot (the log may
+    // still hold them if we crashed between writing it and emptying the log)
+    wal_.recover(snapshot_lsn, [&](const WalRecord &record)
+                 {
+                     if (record.lsn <= snapshot_lsn)
+                         return;
+                     apply(record.op, record.item);
+                     ++recovered_records_; });
+    records_since_checkpoint_ = recovered_records_;
+}
+
+// --- Modifications ---
+
+void DurableRTree::apply(WalOp op, const DataItem &item)
+{
+    auto existing = bounds_.find(item.id);
+    if (existing != bounds_.end())
+    {
+        tree_->remove(DataItem(item.id, "", 0, existing->second));
+        bounds_.erase(existing);
+    }
+    if (op != WalOp::remove)
+    {
+        tree_->insert(item);
+        bounds_.emplace(item.id, item.bounds);
+    }
+}
+
+void DurableRTree::insert(const DataItem &item)
+{
+    WalOp op = bounds_.count(item.id) ? WalOp::update : WalOp::insert;
+    wal_.append(op, item);
+    apply(op, item);
+    if (++records_since_checkpoint_ >= checkpoint_records_)
+        checkpoint();
+}
+
+bool DurableRTree::remove(int id)
+{
+    auto existing = bounds_.find(id);
+    if (existing == bounds_.end())
+        return false;
+    DataItem item(id, "", 0, existing->second);
+    wal_.append(WalOp::remove, item);
+    apply(WalOp::remove, item);
+    if (++records_since_checkpoint_ >= checkpoint_records_)
+        checkpoint();
+    return true;
+}
+
+// --- Checkpoints ---
+
+void DurableRTree::checkpoint()
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    write_snapshot(snapshot_path_, wal_.last_lsn(), tree_->search(Rectangle(-inf, -inf, inf, inf)));
+    wal_.reset();
+    records_since_checkpoint_ = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef DURABLE_RTREE_H
+#define DURABLE_RTREE_H
+
+#include "rtree.h"
+#include "wal.h"
+
+#include <string>
+#include <memory>
+#include <unordered_map> // Bounds of stored ids (needed to update/remove them)
+
+// --- Durable R-Tree ---
+// An RTree whose modifications survive crashes. Every insert, update and
+// remove is appended to a write-ahead log (committed in groups, see
+// WriteAheadLog) before it is applied to the in-memory tree. Every
+// checkpoint_records operations the whole tree is written to a binary
+// snapshot and the log is emptied. Reopening the directory loads the newest
+// snapshot with a bulk load and replays only the log records after it, so
+// restart time is bounded by the snapshot size plus checkpoint_records.
+//
+// Like RTree, this class is not thread-safe.
+class DurableRTree
+{
+public:
+    // Opens (or creates) a store in directory and recovers its contents
+    explicit DurableRTree(const std::string &directory, size_t group_commit_records = 64, size_t checkpoint_records = 1000000);
+
+    DurableRTree(const DurableRTree &) = delete;
+    DurableRTree &operator=(const DurableRTree &) = delete;
+    ~DurableRTree() = default; // The log commits pending records on destruction
+
+    // Insert item, or update the stored item with the same id
+    void insert(const DataItem &item);
+
+    // Remove the item with the given id; returns false if it is not stored
+    bool remove(int id);
+
+    // Make every operation so far durable
+    void sync() { wal_.commit(); }
+
+    // Write a snapshot of the tree and empty the log
+    void checkpoint();
+
+    // Queries go directly to the in-memory tree
+    const RTree &tree() const { return *tree_; }
+    size_t size() const { return bounds_.size(); }
+
+    std::uint64_t last_lsn() const { return wal_.last_lsn(); }
+    std::uint64_t durable_lsn() const { return wal_.durable_lsn(); }
+
+    // Log records replayed on open (those not covered by the snapshot)
+    size_t recovered_records() const { return recovered_records_; }
+
+private:
+    // Apply an operation to the in-memory tree only
+    void apply(WalOp op, const DataItem &item);
+
+    std::string snapshot_path_;
+    WriteAheadLog wal_;
+    size_t checkpoint_records_;
+    size_t records_since_checkpoint_ = 0;
+    size_t recovered_records_ = 0;
+    std::unique_ptr<RTree> tree_;
+    std::unordered_map<int, Rectangle> bounds_;
+};
+
+#endif // DURABLE_RTREE_H
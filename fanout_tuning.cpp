@@ -0,0 +1,130 @@
+#include "fanout_tuning.h"
+
+#include <algorithm> // For std::all_of, std::min
+#include <chrono>    // For timing the trials
+#include <unistd.h>  // For sysconf
+
+// --- Cache Sizes ---
+
+CacheInfo detect_cache_info()
+{
+    CacheInfo cache;
+    // sysconf returns 0 or -1 for values the platform does not report
+    auto query = [](int name, size_t &value)
+    {
+        long reported = sysconf(name);
+        if (reported > 0)
+            value = static_cast<size_t>(reported);
+    };
+#ifdef _SC_LEVEL1_DCACHE_LINESIZE
+    query(_SC_LEVEL1_DCACHE_LINESIZE, cache.line_size);
+    query(_SC_LEVEL1_DCACHE_SIZE, cache.l1_data_size);
+    query(_SC_LEVEL2_CACHE_SIZE, cache.l2_size);
+    query(_SC_LEVEL3_CACHE_SIZE, cache.l3_size);
+#endif
+    return cache;
+}
+
+std::vector<size_t> fan_out_candidates(const CacheInfo &cache, size_t entry_bytes)
+{
+    std::vector<size_t> candidates;
+    size_t limit = std::max(cache.l1_data_size / 8, 4 * cache.line_size);
+    for (size_t bytes = 2 * cache.line_size; bytes <= limit; bytes *= 2)
+    {
+        candidates.push_back(std::max<size_t>(bytes / entry_bytes, 4));
+    }
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+// --- Fan-Out Tuning ---
+
+static FanOut with_minimums(size_t max_entries, size_t max_leaf_entries)
+{
+    return FanOut{std::max<size_t>(2, max_entries * 2 / 5), max_entries, std::max<size_t>(2, max_leaf_entries * 2 / 5), max_leaf_entries};
+}
+
+// Bulk-loads the sample with fan_out and returns the best of a few timed passes over queries
+static double time_queries(std::span<const DataItem> sample, std::span<const Rectangle> queries, const FanOut &fan_out)
+{
+    const int passes = 3;
+    RTree tree(fan_out);
+    tree.bulk_load(sample);
+    size_t hits = tree.count(queries.front()); // Tighten (and warm up) outside the timed passes
+    double best_ms = 0;
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &query : queries)
+            hits += tree.count(query);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best_ms = pass == 0 ? ms : std::min(best_ms, ms);
+    }
+    // Keep the counts observable so the passes cannot be optimized away
+    volatile size_t sink = hits;
+    (void)sink;
+    return best_ms;
+}
+
+FanOutTuning tune_fan_out(std::span<const DataItem> items, std::span<const Rectangle> queries, size_t sample_size, const CacheInfo &cache)
+{
+    const size_t default_internal = 16;
+    FanOutTuning tuning;
+    tuning.best = with_minimums(default_internal, default_internal);
+    if (items.empty() || queries.empty())
+        return tuning;
+
+    // Every k-th item, so the sample spans the whole extent
+    std::vector<DataItem> sample;
+    size_t stride = std::max<size_t>(1, items.size() / std::max<size_t>(sample_size, 1));
+    for (size_t i = 0; i < items.size(); i += stride)
+        sample.push_back(items[i]);
+    queries = queries.first(std::min<size_t>(queries.size(), 1000));
+
+    // Point layers are packed into point leaves, which store half the bytes per entry
+    bool points = std::all_of(sample.begin(), sample.end(), [](const DataItem &item)
+                              { return item.bounds.is_point(); });
+    std::vector<size_t> leaf_candidates = fan_out_candidates(cache, points ? sizeof(Point) : sizeof(Rectangle));
+    std::vector<size_t> internal_candidates = fan_out_candidates(cache, sizeof(Rectangle));
+
+    auto measure = [&](const FanOut &fan_out)
+    {
+        double ms = time_queries(sample, queries, fan_out);
+        tuning.trials.push_back({fan_out, ms});
+        return ms;
+    };
+    double best_ms = 0;
+    size_t best_leaf = leaf_candidates.front();
+    for (size_t leaf : leaf_candidates)
+    {
+        double ms = measure(with_minimums(default_internal, leaf));
+        if (tuning.trials.size() == 1 || ms < best_ms)
+        {
+            best_ms = ms;
+            best_leaf = leaf;
+        }
+    }
+    size_t best_internal = default_internal;
+    for (size_t internal : internal_candidates)
+    {
+        if (internal == default_internal)
+            continue; // Measured in the leaf sweep
+        double ms = measure(with_minimums(internal, best_leaf));
+        if (ms < best_ms)
+        {
+            best_ms = ms;
+            best_internal = internal;
+        }
+    }
+    tuning.best = with_minimums(best_internal, best_leaf);
+    return tuning;
+}
+
+TunedRTree bulk_load_tuned(std::span<const DataItem> items, std::span<const Rectangle> queries, size_t sample_size)
+{
+    TunedRTree tuned;
+    tuned.tuning = tune_fan_out(items, queries, sample_size);
+    tuned.tree = std::make_unique<RTree>(tuned.tuning.best);
+    tuned.tree->bulk_load(items);
+    return tuned;
+}
@@ -0,0 +1,62 @@
+#ifndef FANOUT_TUNING_H
+#define FANOUT_TUNING_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <span>
+#include <memory> // For std::unique_ptr (RTree is neither copyable nor movable)
+
+// --- Cache Sizes ---
+struct CacheInfo
+{
+    size_t line_size = 64;
+    size_t l1_data_size = 32 * 1024;
+    size_t l2_size = 1024 * 1024;
+    size_t l3_size = 8 * 1024 * 1024;
+};
+
+// Cache sizes reported by sysconf; sizes it does not report keep the defaults above
+CacheInfo detect_cache_info();
+
+// Max-entry candidates for nodes with entry_bytes per entry box: capacities
+// whose entry array fills 2, 4, 8, ... whole cache lines, up to an eighth of
+// the L1 data cache (so a node scan never evicts the path above it)
+std::vector<size_t> fan_out_candidates(const CacheInfo &cache, size_t entry_bytes);
+
+// --- Fan-Out Tuning ---
+// Picks node capacities by measurement instead of guesswork: a sample of the
+// items is bulk-loaded once per candidate and the sample queries are timed
+// (best of several runs). Leaf capacities are swept first, with a fixed
+// internal fan-out, then internal capacities with the best leaf; minimums
+// are 40% of each maximum, as in the R*-tree. The sample keeps the data's
+// distribution but not its density, so queries hit fewer items than on the
+// full data; a larger sample gives a closer estimate at a higher tuning cost.
+
+struct FanOutTrial
+{
+    FanOut fan_out;
+    double query_ms; // Best time for one pass over the sample queries
+};
+
+struct FanOutTuning
+{
+    FanOut best;
+    std::vector<FanOutTrial> trials; // In the order they were measured
+};
+
+FanOutTuning tune_fan_out(std::span<const DataItem> items, std::span<const Rectangle> queries,
+                          size_t sample_size = 100000, const CacheInfo &cache = detect_cache_info());
+
+struct TunedRTree
+{
+    std::unique_ptr<RTree> tree; // Holds every item, packed under tuning.best
+    FanOutTuning tuning;
+};
+
+// Tunes on items and queries, then packs items once into a new tree with the
+// winning fan-out
+TunedRTree bulk_load_tuned(std::span<const DataItem> items, std::span<const Rectangle> queries,
+                           size_t sample_size = 100000);
+
+#endif // FANOUT_TUNING_H
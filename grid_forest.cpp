@@ -0,0 +1,188 @@
+#include "grid_forest.h"
+
+#include <algorithm> // For std::max, std::min
+#include <cmath>     // For std::sqrt, std::ceil
+#include <stdexcept> // For std::invalid_argument
+
+GridForest::GridForest(const Rectangle &extent, size_t cells_x, size_t cells_y, size_t min_entries, size_t max_entries)
+    : grid_(extent, cells_x, cells_y), min_entries_(min_entries), max_entries_(max_entries)
+{
+    if (!extent.is_valid())
+        throw std::invalid_argument("GridForest: invalid extent");
+    reset(extent, cells_x, cells_y);
+}
+
+void GridForest::reset(const Rectangle &extent, size_t cells_x, size_t cells_y)
+{
+    grid_ = GridCells(extent, cells_x, cells_y);
+    cells_.clear();
+    cells_.resize(grid_.size());
+    size_ = 0;
+}
+
+// --- Cells ---
+
+RTree &GridForest::cell_tree(size_t x, size_t y)
+{
+    auto &tree = cells_[grid_.index(x, y)];
+    if (!tree)
+        tree = std::make_unique<RTree>(min_entries_, max_entries_);
+    return *tree;
+}
+
+size_t GridForest::stored_entries() const
+{
+    size_t entries = 0;
+    for (const auto &tree : cells_)
+    {
+        if (tree)
+            entries += tree->size();
+    }
+    return entries;
+}
+
+// --- Loading and Updates ---
+
+void GridForest::bulk_load(std::span<const DataItem> items, size_t items_per_cell)
+{
+    Rectangle extent = Rectangle::empty();
+    for (const auto &item : items)
+        extent.expand(item.bounds);
+    if (items.empty())
+        extent = grid_.extent();
+
+    // About items_per_cell items per cell, with cells as square as the extent allows
+    double width = std::max(extent.max_corner.x - extent.min_corner.x, 1e-9);
+    double height = std::max(extent.max_corner.y - extent.min_corner.y, 1e-9);
+    double cells = std::max(1.0, static_cast<double>(items.size()) / std::max<size_t>(items_per_cell, 1));
+    double cells_x = std::clamp(std::sqrt(cells * width / height), 1.0, cells);
+    reset(extent, static_cast<size_t>(std::ceil(cells_x)), static_cast<size_t>(std::ceil(cells / cells_x)));
+    insert_batch(items);
+}
+
+// A single item goes straight into the trees of its cells, without routing
+void GridForest::insert(const DataItem &item)
+{
+    for (size_t y = grid_.cell_y(item.bounds.min_corner.y); y <= grid_.cell_y(item.bounds.max_corner.y); ++y)
+    {
+        for (size_t x = grid_.cell_x(item.bounds.min_corner.x); x <= grid_.cell_x(item.bounds.max_corner.x); ++x)
+        {
+            cell_tree(x, y).insert(item);
+        }
+    }
+    ++size_;
+}
+
+// Items are routed to their cells first, so each cell's tree receives its
+// share in one batch (packed if the cell was empty)
+void GridForest::insert_batch(std::span<const DataItem> items)
+{
+    std::vector<std::vector<DataItem>> routed(cells_.size());
+    for (const auto &item : items)
+    {
+        for (size_t y = grid_.cell_y(item.bounds.min_corner.y); y <= grid_.cell_y(item.bounds.max_corner.y); ++y)
+        {
+            for (size_t x = grid_.cell_x(item.bounds.min_corner.x); x <= grid_.cell_x(item.bounds.max_corner.x); ++x)
+            {
+                routed[grid_.index(x, y)].push_back(item);
+            }
+        }
+    }
+    for (size_t cell = 0; cell < routed.size(); ++cell)
+    {
+        if (routed[cell].empty())
+            continue;
+        RTree &tree = cell_tree(cell % grid_.cells_x(), cell / grid_.cells_x());
+        if (tree.empty())
+            tree.bulk_load(routed[cell]);
+        else
+            tree.insert_batch(routed[cell]);
+    }
+    size_ += items.size();
+}
+
+bool GridForest::remove(const DataItem &item)
+{
+    bool removed = false;
+    for (size_t y = grid_.cell_y(item.bounds.min_corner.y); y <= grid_.cell_y(item.bounds.max_corner.y); ++y)
+    {
+        for (size_t x = grid_.cell_x(item.bounds.min_corner.x); x <= grid_.cell_x(item.bounds.max_corner.x); ++x)
+        {
+            auto &tree = cells_[grid_.index(x, y)];
+            if (tree && tree->remove(item))
+                removed = true;
+        }
+    }
+    if (removed)
+        --size_;
+    return removed;
+}
+
+// --- Queries ---
+
+// Visits each item once (see GridCells::reports). Only the query's lower-left
+// cell needs no check at all, since no overlap corner can lie in an earlier
+// cell, so its tree goes to whole_cell(tree) instead, which can use the
+// tree's own queries. The rest of the first row and column check one axis.
+template <typename WholeCell, typename Visit>
+void GridForest::visit(const Rectangle &query_rect, WholeCell &&whole_cell, Visit &&visit_item) const
+{
+    if (!query_rect.is_valid())
+        return;
+    size_t x0 = grid_.cell_x(query_rect.min_corner.x), x1 = grid_.cell_x(query_rect.max_corner.x);
+    size_t y0 = grid_.cell_y(query_rect.min_corner.y), y1 = grid_.cell_y(query_rect.max_corner.y);
+    for (size_t y = y0; y <= y1; ++y)
+    {
+        for (size_t x = x0; x <= x1; ++x)
+        {
+            const auto &tree = cells_[grid_.index(x, y)];
+            if (!tree)
+                continue;
+            if (x == x0 && y == y0)
+            {
+                whole_cell(*tree);
+                continue;
+            }
+            tree->for_each_intersecting(query_rect, [&](const DataItem &item)
+                                        {
+                                            if (grid_.reports(item.bounds, query_rect, x, y, x0, y0))
+                                                visit_item(item); });
+        }
+    }
+}
+
+std::vector<DataItem> GridForest::search(const Rectangle &query_rect) const
+{
+    std::vector<DataItem> results;
+    visit(query_rect, [&](const RTree &tree)
+          {
+              std::vector<DataItem> found = tree.search(query_rect);
+              results.insert(results.end(), found.begin(), found.end()); },
+          [&](const DataItem &item)
+          { results.push_back(item); });
+    return results;
+}
+
+std::vector<DataItem> GridForest::search_with_population(const Rectangle &query_rect, long min_population) const
+{
+    std::vector<DataItem> results;
+    visit(query_rect, [&](const RTree &tree)
+          {
+              std::vector<DataItem> found = tree.search_with_population(query_rect, min_population);
+              results.insert(results.end(), found.begin(), found.end()); },
+          [&](const DataItem &item)
+          {
+              if (item.population >= min_population)
+                  results.push_back(item); });
+    return results;
+}
+
+size_t GridForest::count(const Rectangle &query_rect) const
+{
+    size_t matches = 0;
+    visit(query_rect, [&](const RTree &tree)
+          { matches += tree.count(query_rect); },
+          [&](const DataItem &)
+          { ++matches; });
+    return matches;
+}
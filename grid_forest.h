@@ -0,0 +1,68 @@
+#ifndef GRID_FOREST_H
+#define GRID_FOREST_H
+
+#include "rtree.h"
+#include "index_backends.h" // For GridCells
+
+#include <vector>
+#include <memory> // For std::unique_ptr
+#include <span>
+
+// --- Grid Forest ---
+// A uniform grid over the data extent whose cells each hold a small RTree,
+// replacing the upper levels of one big tree. A query visits only the trees
+// of the cells it overlaps, so a small window starts one or two levels above
+// the leaves instead of descending from a root whose entries all span huge
+// areas. An item is stored in the tree of every cell it overlaps; a cell
+// reports it only if it holds the lower-left corner of the item's overlap
+// with the query, so results contain each item once.
+// Items outside the extent are kept in the border cells.
+class GridForest final : public SpatialIndex
+{
+public:
+    static constexpr size_t default_items_per_cell = 4096;
+
+    // An empty forest with a fixed grid. Each cell's tree uses min/max entries.
+    explicit GridForest(const Rectangle &extent = Rectangle(-180, -90, 180, 90), size_t cells_x = 64, size_t cells_y = 32,
+                        size_t min_entries = 4, size_t max_entries = 16);
+
+    // Replace the contents with items on a grid fitted to their extent, with
+    // roughly items_per_cell items per cell (each cell packed with RTree::bulk_load)
+    void bulk_load(std::span<const DataItem> items, size_t items_per_cell = default_items_per_cell);
+
+    void insert(const DataItem &item) override;
+    void insert_batch(std::span<const DataItem> items) override;
+
+    // Remove the item with item.id from every cell item.bounds overlaps
+    bool remove(const DataItem &item);
+
+    std::vector<DataItem> search(const Rectangle &query_rect) const override;
+    std::vector<DataItem> search_with_population(const Rectangle &query_rect, long min_population) const override;
+    size_t count(const Rectangle &query_rect) const override;
+    size_t size() const override { return size_; }
+    bool empty() const override { return size_ == 0; }
+
+    const Rectangle &extent() const { return grid_.extent(); }
+    size_t cells_x() const { return grid_.cells_x(); }
+    size_t cells_y() const { return grid_.cells_y(); }
+
+    // Stored entries over all cells (items spanning k cells count k times)
+    size_t stored_entries() const;
+
+private:
+    // Size the grid over extent and drop all contents
+    void reset(const Rectangle &extent, size_t cells_x, size_t cells_y);
+
+    RTree &cell_tree(size_t x, size_t y); // Creates the cell's tree on first use
+
+    template <typename WholeCell, typename Visit>
+    void visit(const Rectangle &query_rect, WholeCell &&whole_cell, Visit &&visit_item) const;
+
+    GridCells grid_;
+    size_t min_entries_;
+    size_t max_entries_;
+    std::vector<std::unique_ptr<RTree>> cells_; // Indexed by grid_.index(x, y); null for cells never written
+    size_t size_ = 0;
+};
+
+#endif // GRID_FOREST_H
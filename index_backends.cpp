@@ -0,0 +1,577 @@
+#include "index_backends.h"
+#include "grid_forest.h"
+
+#include <algorithm> // For std::nth_element, std::sort, std::min, std::max
+#include <cmath>     // For std::abs
+#include <bit>       // For std::bit_width
+#include <array>
+#include <stdexcept> // For std::invalid_argument
+
+// --- Shared Helpers ---
+
+static Point center_of(const Rectangle &bounds)
+{
+    return Point(bounds.min_corner.x / 2 + bounds.max_corner.x / 2, bounds.min_corner.y / 2 + bounds.max_corner.y / 2);
+}
+
+// Grows a largest half-extent to cover bounds
+static void track_half_extent(Point &max_half_extent, const Rectangle &bounds)
+{
+    max_half_extent.x = std::max(max_half_extent.x, (bounds.max_corner.x - bounds.min_corner.x) / 2);
+    max_half_extent.y = std::max(max_half_extent.y, (bounds.max_corner.y - bounds.min_corner.y) / 2);
+}
+
+// The region holding the center of every item that intersects query_rect.
+// The small relative slack absorbs rounding in center_of.
+static Rectangle widened(const Rectangle &query_rect, const Point &max_half_extent)
+{
+    auto slack = [](double value)
+    { return 1e-9 * (1 + std::abs(value)); };
+    const Point &lo = query_rect.min_corner, &hi = query_rect.max_corner;
+    return Rectangle(lo.x - max_half_extent.x - slack(lo.x), lo.y - max_half_extent.y - slack(lo.y),
+                     hi.x + max_half_extent.x + slack(hi.x), hi.y + max_half_extent.y + slack(hi.y));
+}
+
+// Sorted-part size below which the rebuilding backends always re-sort
+static const size_t min_rebuild_tail = 64;
+
+// --- VisitingIndex ---
+
+template <typename Backend>
+std::vector<DataItem> VisitingIndex<Backend>::search(const Rectangle &query_rect) const
+{
+    std::vector<DataItem> results;
+    static_cast<const Backend &>(*this).visit(query_rect, [&](const DataItem &item)
+                                              { results.push_back(item); });
+    return results;
+}
+
+template <typename Backend>
+std::vector<DataItem> VisitingIndex<Backend>::search_with_population(const Rectangle &query_rect, long min_population) const
+{
+    std::vector<DataItem> results;
+    static_cast<const Backend &>(*this).visit(query_rect, [&](const DataItem &item)
+                                              {
+                                                  if (item.population >= min_population)
+                                                      results.push_back(item); });
+    return results;
+}
+
+template <typename Backend>
+size_t VisitingIndex<Backend>::count(const Rectangle &query_rect) const
+{
+    size_t matches = 0;
+    static_cast<const Backend &>(*this).visit(query_rect, [&](const DataItem &)
+                                              { ++matches; });
+    return matches;
+}
+
+// --- GridCells ---
+
+GridCells::GridCells(const Rectangle &extent, size_t cells_x, size_t cells_y)
+    : extent_(extent), cells_x_(std::max<size_t>(cells_x, 1)), cells_y_(std::max<size_t>(cells_y, 1))
+{
+    cell_width_ = (extent.max_corner.x - extent.min_corner.x) / cells_x_;
+    cell_height_ = (extent.max_corner.y - extent.min_corner.y) / cells_y_;
+}
+
+size_t GridCells::cell_x(double x) const
+{
+    double cell = (x - extent_.min_corner.x) / cell_width_;
+    if (!(cell > 0)) // Also catches NaN and zero-width extents
+        return 0;
+    return cell >= static_cast<double>(cells_x_) ? cells_x_ - 1 : static_cast<size_t>(cell);
+}
+
+size_t GridCells::cell_y(double y) const
+{
+    double cell = (y - extent_.min_corner.y) / cell_height_;
+    if (!(cell > 0))
+        return 0;
+    return cell >= static_cast<double>(cells_y_) ? cells_y_ - 1 : static_cast<size_t>(cell);
+}
+
+// --- GridIndex ---
+
+GridIndex::GridIndex(const Rectangle &extent, size_t cells_x, size_t cells_y)
+    : grid_(extent, cells_x, cells_y)
+{
+    if (!extent.is_valid())
+        throw std::invalid_argument("GridIndex: invalid extent");
+    cells_.resize(grid_.size());
+}
+
+void GridIndex::insert(const DataItem &item)
+{
+    Entry entry{item.bounds, static_cast<std::uint32_t>(items_.size())};
+    items_.push_back(item);
+    for (size_t y = grid_.cell_y(item.bounds.min_corner.y); y <= grid_.cell_y(item.bounds.max_corner.y); ++y)
+    {
+        for (size_t x = grid_.cell_x(item.bounds.min_corner.x); x <= grid_.cell_x(item.bounds.max_corner.x); ++x)
+        {
+            cells_[grid_.index(x, y)].push_back(entry);
+        }
+    }
+}
+
+void GridIndex::insert_batch(std::span<const DataItem> items)
+{
+    items_.reserve(items_.size() + items.size());
+    for (const auto &item : items)
+        insert(item);
+}
+
+template <typename Visit>
+void GridIndex::visit(const Rectangle &query_rect, Visit &&visit_item) const
+{
+    if (!query_rect.is_valid())
+        return;
+    size_t x0 = grid_.cell_x(query_rect.min_corner.x), x1 = grid_.cell_x(query_rect.max_corner.x);
+    size_t y0 = grid_.cell_y(query_rect.min_corner.y), y1 = grid_.cell_y(query_rect.max_corner.y);
+    for (size_t y = y0; y <= y1; ++y)
+    {
+        for (size_t x = x0; x <= x1; ++x)
+        {
+            for (const Entry &entry : cells_[grid_.index(x, y)])
+            {
+                if (entry.bounds.intersects(query_rect) && grid_.reports(entry.bounds, query_rect, x, y, x0, y0))
+                    visit_item(items_[entry.item]);
+            }
+        }
+    }
+}
+
+// --- QuadtreeIndex ---
+
+QuadtreeIndex::QuadtreeIndex(const Rectangle &extent, size_t bucket_capacity, int max_depth)
+    : bucket_capacity_(std::max<size_t>(bucket_capacity, 1)), max_depth_(max_depth), root_(std::make_unique<Node>())
+{
+    if (!extent.is_valid())
+        throw std::invalid_argument("QuadtreeIndex: invalid extent");
+    root_->region = extent;
+}
+
+void QuadtreeIndex::insert(const DataItem &item)
+{
+    Entry entry{item.bounds, static_cast<std::uint32_t>(items_.size())};
+    items_.push_back(item);
+    track_half_extent(max_half_extent_, item.bounds);
+    insert_entry(root_.get(), entry, 0);
+}
+
+void QuadtreeIndex::insert_batch(std::span<const DataItem> items)
+{
+    items_.reserve(items_.size() + items.size());
+    for (const auto &item : items)
+        insert(item);
+}
+
+// Quadrants are numbered x-half + 2 * y-half; centers on a midline go to the upper half.
+// Centers outside the extent end up in the nearest border leaf, whose region
+// is widened to cover them so queries still find them.
+void QuadtreeIndex::insert_entry(Node *node, const Entry &entry, int depth)
+{
+    Point center = center_of(entry.bounds);
+    while (!node->is_leaf())
+    {
+        node->region.expand(Rectangle(center.x, center.y, center.x, center.y));
+        node = node->children[(center.x >= node->split.x) + 2 * (center.y >= node->split.y)].get();
+        ++depth;
+    }
+    node->region.expand(Rectangle(center.x, center.y, center.x, center.y));
+    node->entries.push_back(entry);
+    if (node->entries.size() <= bucket_capacity_ || depth >= max_depth_)
+        return;
+
+    // Split the bucket into four quadrants and redistribute it
+    const Rectangle &region = node->region;
+    Point mid = center_of(region);
+    node->split = mid;
+    for (int quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        auto child = std::make_unique<Node>();
+        child->region = Rectangle(quadrant & 1 ? mid.x : region.min_corner.x, quadrant & 2 ? mid.y : region.min_corner.y,
+                                  quadrant & 1 ? region.max_corner.x : mid.x, quadrant & 2 ? region.max_corner.y : mid.y);
+        node->children[quadrant] = std::move(child);
+    }
+    std::vector<Entry> entries = std::move(node->entries);
+    node->entries.clear();
+    for (const Entry &moved : entries)
+    {
+        insert_entry(node, moved, depth);
+    }
+}
+
+template <typename Visit>
+void QuadtreeIndex::visit(const Rectangle &query_rect, Visit &&visit_item) const
+{
+    Rectangle centers = widened(query_rect, max_half_extent_);
+    std::vector<const Node *> stack{root_.get()};
+    while (!stack.empty())
+    {
+        const Node *node = stack.back();
+        stack.pop_back();
+        if (!node->region.intersects(centers))
+            continue;
+        for (const Entry &entry : node->entries)
+        {
+            if (entry.bounds.intersects(query_rect))
+                visit_item(items_[entry.item]);
+        }
+        for (const auto &child : node->children)
+        {
+            if (child)
+                stack.push_back(child.get());
+        }
+    }
+}
+
+// --- KdTreeIndex ---
+
+// Ranges this small are scanned instead of split further
+static const size_t kd_leaf_size = 8;
+
+void KdTreeIndex::insert(const DataItem &item)
+{
+    insert_batch(std::span<const DataItem>(&item, 1));
+}
+
+void KdTreeIndex::insert_batch(std::span<const DataItem> items)
+{
+    items_.reserve(items_.size() + items.size());
+    for (const auto &item : items)
+    {
+        pending_.push_back({item.bounds, center_of(item.bounds), static_cast<std::uint32_t>(items_.size())});
+        items_.push_back(item);
+        track_half_extent(max_half_extent_, item.bounds);
+    }
+    rebuild_if_needed();
+}
+
+void KdTreeIndex::rebuild_if_needed()
+{
+    if (pending_.size() <= std::max(min_rebuild_tail, tree_.size() / 8))
+        return;
+    tree_.insert(tree_.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+    build(0, tree_.size(), 0);
+}
+
+void KdTreeIndex::build(size_t begin, size_t end, int axis)
+{
+    while (end - begin > kd_leaf_size)
+    {
+        size_t mid = begin + (end - begin) / 2;
+        std::nth_element(tree_.begin() + begin, tree_.begin() + mid, tree_.begin() + end, [axis](const Entry &a, const Entry &b)
+                         { return a.center[axis] < b.center[axis]; });
+        build(begin, mid, 1 - axis);
+        begin = mid + 1; // Continue with the upper half in place of a second call
+        axis = 1 - axis;
+    }
+}
+
+template <typename Visit>
+void KdTreeIndex::visit(const Rectangle &query_rect, Visit &&visit_item) const
+{
+    auto test = [&](const Entry &entry)
+    {
+        if (entry.bounds.intersects(query_rect))
+            visit_item(items_[entry.item]);
+    };
+    Rectangle centers = widened(query_rect, max_half_extent_);
+    struct Range
+    {
+        size_t begin, end;
+        int axis;
+    };
+    std::vector<Range> stack;
+    if (!tree_.empty())
+        stack.push_back({0, tree_.size(), 0});
+    while (!stack.empty())
+    {
+        Range range = stack.back();
+        stack.pop_back();
+        if (range.end - range.begin <= kd_leaf_size)
+        {
+            for (size_t i = range.begin; i < range.end; ++i)
+                test(tree_[i]);
+            continue;
+        }
+        // Lower half has centers <= split, upper half >= split
+        size_t mid = range.begin + (range.end - range.begin) / 2;
+        double split = tree_[mid].center[range.axis];
+        test(tree_[mid]);
+        if (centers.min_corner[range.axis] <= split)
+            stack.push_back({range.begin, mid, 1 - range.axis});
+        if (centers.max_corner[range.axis] >= split)
+            stack.push_back({mid + 1, range.end, 1 - range.axis});
+    }
+    for (const Entry &entry : pending_)
+        test(entry);
+}
+
+// --- HilbertArrayIndex ---
+
+HilbertArrayIndex::HilbertArrayIndex(size_t block_size)
+    : block_size_(std::max<size_t>(block_size, 2))
+{
+}
+
+void HilbertArrayIndex::insert(const DataItem &item)
+{
+    insert_batch(std::span<const DataItem>(&item, 1));
+}
+
+void HilbertArrayIndex::insert_batch(std::span<const DataItem> items)
+{
+    items_.reserve(items_.size() + items.size());
+    for (const auto &item : items)
+    {
+        pending_.push_back({item.bounds, static_cast<std::uint32_t>(items_.size())});
+        items_.push_back(item);
+    }
+    rebuild_if_needed();
+}
+
+void HilbertArrayIndex::rebuild_if_needed()
+{
+    if (pending_.size() <= std::max(min_rebuild_tail, sorted_.size() / 8))
+        return;
+    sorted_.insert(sorted_.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+
+    // Sort along the curve over the extent of all items
+    std::vector<Entry> unsorted = std::move(sorted_);
+    sorted_.clear();
+    sorted_.reserve(unsorted.size());
+    for (const auto &[key, position] : curve_order(unsorted, [](const Entry &entry)
+                                                   { return entry.bounds; }))
+        sorted_.push_back(unsorted[position]);
+
+    // Bounding boxes of each block, then of each group of blocks
+    block_bounds_.clear();
+    for (size_t begin = 0; begin < sorted_.size(); begin += block_size_)
+    {
+        Rectangle bounds = Rectangle::empty();
+        for (size_t i = begin; i < std::min(sorted_.size(), begin + block_size_); ++i)
+            bounds.expand(sorted_[i].bounds);
+        block_bounds_.push_back(bounds);
+    }
+    group_bounds_.clear();
+    std::span<const Rectangle> blocks(block_bounds_);
+    for (size_t begin = 0; begin < blocks.size(); begin += block_size_)
+    {
+        group_bounds_.push_back(combine_all(blocks.subspan(begin, std::min(block_size_, blocks.size() - begin))));
+    }
+}
+
+template <typename Visit>
+void HilbertArrayIndex::visit(const Rectangle &query_rect, Visit &&visit_item) const
+{
+    auto test = [&](const Entry &entry)
+    {
+        if (entry.bounds.intersects(query_rect))
+            visit_item(items_[entry.item]);
+    };
+    for (size_t group = 0; group < group_bounds_.size(); ++group)
+    {
+        if (!group_bounds_[group].intersects(query_rect))
+            continue;
+        size_t first_block = group * block_size_;
+        size_t last_block = std::min(block_bounds_.size(), first_block + block_size_);
+        for (size_t block = first_block; block < last_block; ++block)
+        {
+            if (!block_bounds_[block].intersects(query_rect))
+                continue;
+            size_t end = std::min(sorted_.size(), (block + 1) * block_size_);
+            for (size_t i = block * block_size_; i < end; ++i)
+                test(sorted_[i]);
+        }
+    }
+    for (const Entry &entry : pending_)
+        test(entry);
+}
+
+// --- CellCoverIndex ---
+
+// Key order of the curve (space_filling_key uses order 16 in 2D, so keys fit 32 bits)
+static constexpr unsigned cover_order = 16;
+
+// Keys per sample in the directory searched before keys_
+static const size_t key_sample_stride = 64;
+
+void CellCoverIndex::insert(const DataItem &item)
+{
+    insert_batch(std::span<const DataItem>(&item, 1));
+}
+
+void CellCoverIndex::insert_batch(std::span<const DataItem> items)
+{
+    for (const auto &item : items)
+    {
+        pending_.push_back(item);
+        track_half_extent(max_half_extent_, item.bounds);
+    }
+    rebuild_if_needed();
+}
+
+void CellCoverIndex::rebuild_if_needed()
+{
+    if (pending_.size() <= std::max(min_rebuild_tail, sorted_items_.size() / 8))
+        return;
+    std::vector<DataItem> all = std::move(sorted_items_);
+    all.insert(all.end(), std::make_move_iterator(pending_.begin()), std::make_move_iterator(pending_.end()));
+    pending_.clear();
+
+    // Re-key everything over the new extent
+    auto bounds_of = [](const DataItem &item)
+    { return item.bounds; };
+    extent_ = curve_extent(all, bounds_of);
+    auto order = curve_order(all, bounds_of, extent_); // (key, position in all)
+
+    keys_.resize(all.size());
+    bounds_.resize(all.size());
+    sorted_items_.clear();
+    sorted_items_.reserve(all.size());
+    key_samples_.clear();
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        keys_[i] = static_cast<std::uint32_t>(order[i].first);
+        if (i % key_sample_stride == 0)
+            key_samples_.push_back(keys_[i]);
+        bounds_[i] = all[order[i].second].bounds;
+        sorted_items_.push_back(std::move(all[order[i].second]));
+    }
+}
+
+// The covering descends the quadtree of curve cells from the whole extent.
+// A cell inside the query adds its whole key range (a Hilbert cell at level l
+// owns the 4^(16-l) keys sharing its top 2l bits); a cell crossing the
+// query's edge is refined down to a level whose cells are about a quarter of
+// the query's larger side, and added whole there (its items are tested exactly).
+std::vector<CellCoverIndex::KeyRange> CellCoverIndex::cell_ranges(const Rectangle &query_rect) const
+{
+    std::vector<KeyRange> ranges;
+    ranges.reserve(16);
+    if (sorted_items_.empty() || !query_rect.is_valid())
+        return ranges;
+
+    // Query in curve cells, widened to every center of an intersecting item
+    Rectangle centers = widened(query_rect, max_half_extent_);
+    if (!centers.intersects(extent_))
+        return ranges;
+    const std::uint32_t x0 = curve_cell(centers.min_corner.x, extent_.min_corner.x, extent_.max_corner.x, cover_order);
+    const std::uint32_t y0 = curve_cell(centers.min_corner.y, extent_.min_corner.y, extent_.max_corner.y, cover_order);
+    const std::uint32_t x1 = curve_cell(centers.max_corner.x, extent_.min_corner.x, extent_.max_corner.x, cover_order);
+    const std::uint32_t y1 = curve_cell(centers.max_corner.y, extent_.min_corner.y, extent_.max_corner.y, cover_order);
+    const std::uint32_t span = std::max(x1 - x0, y1 - y0) + 1;
+    const unsigned finest = static_cast<unsigned>(std::clamp(static_cast<int>(cover_order) - static_cast<int>(std::bit_width(span)) + 2, 0, static_cast<int>(cover_order)));
+
+    struct Cell
+    {
+        unsigned level;
+        std::uint32_t x, y;
+    };
+    // Depth-first, so the stack holds at most 3 pending siblings per level
+    std::array<Cell, 3 * cover_order + 4> stack;
+    size_t depth = 0;
+    stack[depth++] = {0, 0, 0};
+    while (depth > 0)
+    {
+        Cell cell = stack[--depth];
+        unsigned shift = cover_order - cell.level;
+        std::uint64_t lo_x = std::uint64_t(cell.x) << shift, lo_y = std::uint64_t(cell.y) << shift;
+        std::uint64_t hi_x = lo_x + (std::uint64_t(1) << shift) - 1, hi_y = lo_y + (std::uint64_t(1) << shift) - 1;
+        if (hi_x < x0 || lo_x > x1 || hi_y < y0 || lo_y > y1)
+            continue;
+        bool inside = lo_x >= x0 && hi_x <= x1 && lo_y >= y0 && hi_y <= y1;
+        if (inside || cell.level == finest)
+        {
+            std::uint64_t cell_keys = std::uint64_t(1) << (2 * shift);
+            std::uint64_t begin = hilbert_index(static_cast<std::uint32_t>(lo_x), static_cast<std::uint32_t>(lo_y), cover_order) & ~(cell_keys - 1);
+            ranges.push_back({begin, begin + cell_keys});
+            continue;
+        }
+        for (std::uint32_t child = 0; child < 4; ++child)
+            stack[depth++] = {cell.level + 1, 2 * cell.x + (child & 1), 2 * cell.y + (child >> 1)};
+    }
+
+    // Neighbouring cells are often neighbours on the curve: merge their ranges
+    std::sort(ranges.begin(), ranges.end(), [](const KeyRange &a, const KeyRange &b)
+              { return a.begin < b.begin; });
+    size_t merged = 0;
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        if (ranges[i].begin <= ranges[merged].end)
+            ranges[merged].end = std::max(ranges[merged].end, ranges[i].end);
+        else
+            ranges[++merged] = ranges[i];
+    }
+    ranges.resize(merged + 1);
+    return ranges;
+}
+
+// A binary search over all of keys_ misses the cache on most of its steps.
+// The samples narrow it to one stride of keys first.
+size_t CellCoverIndex::lower_bound(std::uint64_t key, size_t from) const
+{
+    size_t sample = std::lower_bound(key_samples_.begin() + from / key_sample_stride, key_samples_.end(), key) - key_samples_.begin();
+    // keys_[(sample - 1) * stride] < key <= keys_[sample * stride]
+    size_t begin = std::max(from, sample > 0 ? (sample - 1) * key_sample_stride : 0);
+    size_t end = std::min(keys_.size(), sample * key_sample_stride + 1);
+    return std::lower_bound(keys_.begin() + begin, keys_.begin() + std::max(begin, end), key) - keys_.begin();
+}
+
+template <typename Visit>
+void CellCoverIndex::visit(const Rectangle &query_rect, Visit &&visit_item) const
+{
+    size_t i = 0;
+    for (const KeyRange &range : cell_ranges(query_rect))
+    {
+        // Ranges ascend, so each search starts where the last scan stopped
+        i = lower_bound(range.begin, i);
+        for (; i < keys_.size() && keys_[i] < range.end; ++i)
+        {
+            if (bounds_[i].intersects(query_rect))
+                visit_item(sorted_items_[i]);
+        }
+    }
+    for (const auto &item : pending_)
+    {
+        if (item.bounds.intersects(query_rect))
+            visit_item(item);
+    }
+}
+
+template class VisitingIndex<GridIndex>;
+template class VisitingIndex<QuadtreeIndex>;
+template class VisitingIndex<KdTreeIndex>;
+template class VisitingIndex<HilbertArrayIndex>;
+template class VisitingIndex<CellCoverIndex>;
+
+// --- Backend Factory ---
+
+std::unique_ptr<SpatialIndex> make_spatial_index(const std::string &name)
+{
+    if (name == "rtree")
+        return std::make_unique<RTree>(4, 16);
+    if (name == "grid")
+        return std::make_unique<GridIndex>();
+    if (name == "quadtree")
+        return std::make_unique<QuadtreeIndex>();
+    if (name == "kdtree")
+        return std::make_unique<KdTreeIndex>();
+    if (name == "hilbert")
+        return std::make_unique<HilbertArrayIndex>();
+    if (name == "cover")
+        return std::make_unique<CellCoverIndex>();
+    if (name == "forest")
+        return std::make_unique<GridForest>();
+    throw std::invalid_argument("Unknown spatial index backend '" + name + "'");
+}
+
+const std::vector<std::string> &spatial_index_names()
+{
+    static const std::vector<std::string> names{"rtree", "grid", "quadtree", "kdtree", "hilbert", "cover", "forest"};
+    return names;
+}
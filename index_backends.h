@@ -0,0 +1,276 @@
+#ifndef INDEX_BACKENDS_H
+#define INDEX_BACKENDS_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <array>
+#include <memory> // For std::unique_ptr
+#include <string>
+#include <cstdint>
+
+// --- Alternative SpatialIndex Backends ---
+// Simpler structures behind the same API as RTree, for layers where they fit
+// better (see make_spatial_index). Items keep their full bounds, and every
+// backend returns exactly the items RTree would; they differ in how
+// candidates are found:
+//   GridIndex          fixed uniform grid; an item is listed in every cell it overlaps
+//   QuadtreeIndex      PR-quadtree over item centers, leaves split at a bucket size
+//   KdTreeIndex        balanced k-d tree over item centers (rebuilt as it grows)
+//   HilbertArrayIndex  items sorted along the Hilbert curve in one array, with
+//                      bounding boxes per block and per group of blocks (rebuilt as it grows)
+//   CellCoverIndex     items sorted by Hilbert key; queries scan the key ranges
+//                      of the curve cells covering them (rebuilt as it grows)
+// The center-based backends widen each query by the largest half-extent of
+// any stored item, so they suit points and small boxes; layers mixing large
+// and small items are better served by the grid or the R-tree.
+// The rebuilding backends collect inserts in a small unsorted tail that
+// queries scan, and re-sort once it exceeds an eighth of the sorted part.
+
+// The queries of SpatialIndex, written once over the backend's
+// visit(query_rect, visit_item), which calls visit_item for every stored
+// item intersecting query_rect exactly once. Defined in index_backends.cpp
+// for the backends below.
+template <typename Backend>
+class VisitingIndex : public SpatialIndex
+{
+public:
+    std::vector<DataItem> search(const Rectangle &query_rect) const override;
+    std::vector<DataItem> search_with_population(const Rectangle &query_rect, long min_population) const override;
+    size_t count(const Rectangle &query_rect) const override;
+};
+
+// Cell mapping of a uniform grid over a fixed extent; coordinates outside it
+// map to the border cells. Shared by GridIndex and GridForest.
+class GridCells
+{
+public:
+    GridCells(const Rectangle &extent, size_t cells_x, size_t cells_y);
+
+    size_t cell_x(double x) const;
+    size_t cell_y(double y) const;
+    size_t index(size_t x, size_t y) const { return y * cells_x_ + x; } // Row-major
+    size_t cells_x() const { return cells_x_; }
+    size_t cells_y() const { return cells_y_; }
+    size_t size() const { return cells_x_ * cells_y_; }
+    const Rectangle &extent() const { return extent_; }
+
+    // An item listed in several cells is reported only by the cell holding the
+    // lower-left corner of its overlap with the query. (x0, y0) is the query's
+    // lower-left cell; only axes on which (x, y) lies past it need a check.
+    bool reports(const Rectangle &bounds, const Rectangle &query_rect, size_t x, size_t y, size_t x0, size_t y0) const
+    {
+        if (x != x0 && cell_x(std::max(bounds.min_corner.x, query_rect.min_corner.x)) != x)
+            return false;
+        return y == y0 || cell_y(std::max(bounds.min_corner.y, query_rect.min_corner.y)) == y;
+    }
+
+private:
+    Rectangle extent_;
+    size_t cells_x_;
+    size_t cells_y_;
+    double cell_width_;
+    double cell_height_;
+};
+
+// Grid over a fixed extent. Items outside it are kept in the border cells.
+class GridIndex final : public VisitingIndex<GridIndex>
+{
+    friend class VisitingIndex<GridIndex>;
+
+public:
+    explicit GridIndex(const Rectangle &extent = Rectangle(-180, -90, 180, 90), size_t cells_x = 360, size_t cells_y = 180);
+
+    void insert(const DataItem &item) override;
+    void insert_batch(std::span<const DataItem> items) override;
+    size_t size() const override { return items_.size(); }
+    bool empty() const override { return items_.empty(); }
+
+private:
+    struct Entry
+    {
+        Rectangle bounds;
+        std::uint32_t item;
+    };
+
+    template <typename Visit>
+    void visit(const Rectangle &query_rect, Visit &&visit_item) const;
+
+    GridCells grid_;
+    std::vector<std::vector<Entry>> cells_; // Indexed by grid_.index(x, y)
+    std::vector<DataItem> items_;
+};
+
+// Point-region quadtree: each node covers a quadrant of its parent's region,
+// and a leaf splits into four once it holds more than bucket_capacity items
+// (unless max_depth is reached)
+class QuadtreeIndex final : public VisitingIndex<QuadtreeIndex>
+{
+    friend class VisitingIndex<QuadtreeIndex>;
+
+public:
+    explicit QuadtreeIndex(const Rectangle &extent = Rectangle(-180, -90, 180, 90), size_t bucket_capacity = 32, int max_depth = 24);
+
+    void insert(const DataItem &item) override;
+    void insert_batch(std::span<const DataItem> items) override;
+    size_t size() const override { return items_.size(); }
+    bool empty() const override { return items_.empty(); }
+
+private:
+    struct Entry
+    {
+        Rectangle bounds;
+        std::uint32_t item;
+    };
+
+    struct Node
+    {
+        Rectangle region;
+        Point split;                                // Center of region when it split
+        std::vector<Entry> entries;                 // Leaves only
+        std::array<std::unique_ptr<Node>, 4> children; // All null for a leaf
+        bool is_leaf() const { return !children[0]; }
+    };
+
+    void insert_entry(Node *node, const Entry &entry, int depth);
+
+    template <typename Visit>
+    void visit(const Rectangle &query_rect, Visit &&visit_item) const;
+
+    size_t bucket_capacity_;
+    int max_depth_;
+    std::unique_ptr<Node> root_;
+    Point max_half_extent_; // Largest half width / height of any item
+    std::vector<DataItem> items_;
+};
+
+// Static k-d tree in one array: the median item of each range (by center,
+// alternating x and y) splits it into its two halves
+class KdTreeIndex final : public VisitingIndex<KdTreeIndex>
+{
+    friend class VisitingIndex<KdTreeIndex>;
+
+public:
+    KdTreeIndex() = default;
+
+    void insert(const DataItem &item) override;
+    void insert_batch(std::span<const DataItem> items) override;
+    size_t size() const override { return items_.size(); }
+    bool empty() const override { return items_.empty(); }
+
+private:
+    struct Entry
+    {
+        Rectangle bounds;
+        Point center;
+        std::uint32_t item;
+    };
+
+    void rebuild_if_needed();
+    void build(size_t begin, size_t end, int axis);
+
+    template <typename Visit>
+    void visit(const Rectangle &query_rect, Visit &&visit_item) const;
+
+    std::vector<Entry> tree_;    // Implicit k-d tree
+    std::vector<Entry> pending_; // Inserted since the last rebuild
+    Point max_half_extent_;
+    std::vector<DataItem> items_;
+};
+
+// Items sorted along the Hilbert curve, scanned through two levels of block
+// bounding boxes (block_size items per block, block_size blocks per group)
+class HilbertArrayIndex final : public VisitingIndex<HilbertArrayIndex>
+{
+    friend class VisitingIndex<HilbertArrayIndex>;
+
+public:
+    explicit HilbertArrayIndex(size_t block_size = 64);
+
+    void insert(const DataItem &item) override;
+    void insert_batch(std::span<const DataItem> items) override;
+    size_t size() const override { return items_.size(); }
+    bool empty() const override { return items_.empty(); }
+
+private:
+    struct Entry
+    {
+        Rectangle bounds;
+        std::uint32_t item;
+    };
+
+    void rebuild_if_needed();
+
+    template <typename Visit>
+    void visit(const Rectangle &query_rect, Visit &&visit_item) const;
+
+    size_t block_size_;
+    std::vector<Entry> sorted_;
+    std::vector<Rectangle> block_bounds_;
+    std::vector<Rectangle> group_bounds_;
+    std::vector<Entry> pending_;
+    std::vector<DataItem> items_;
+};
+
+// Cell-covering query engine: items sorted by the Hilbert key of their center
+// (order 16 over the data extent) in contiguous arrays. A query is converted
+// into a few key ranges (the curve cells covering it, coarse inside and fine
+// along its edges), and each range is found by binary search and scanned
+// sequentially, with no pointer chasing. Center-based like the k-d tree.
+class CellCoverIndex final : public VisitingIndex<CellCoverIndex>
+{
+    friend class VisitingIndex<CellCoverIndex>;
+
+public:
+    // Key range [begin, end) along the curve
+    struct KeyRange
+    {
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    CellCoverIndex() = default;
+
+    void insert(const DataItem &item) override;
+    void insert_batch(std::span<const DataItem> items) override;
+    size_t size() const override { return sorted_items_.size() + pending_.size(); }
+    bool empty() const override { return size() == 0; }
+
+    // The sorted, merged key ranges a query scans (the pending tail is scanned as well)
+    std::vector<KeyRange> cell_ranges(const Rectangle &query_rect) const;
+
+private:
+    void rebuild_if_needed();
+
+    // Position of the first key >= key, searching from position from on
+    size_t lower_bound(std::uint64_t key, size_t from) const;
+
+    template <typename Visit>
+    void visit(const Rectangle &query_rect, Visit &&visit_item) const;
+
+    Rectangle extent_ = Rectangle::empty(); // Extent of the sorted items, which the keys divide
+    std::vector<std::uint32_t> keys_;       // Sorted; keys_[i] belongs to sorted_items_[i]
+    std::vector<std::uint32_t> key_samples_; // Every key_sample_stride-th key: a cache-resident first search level
+    std::vector<Rectangle> bounds_;         // bounds_[i] of sorted_items_[i], scanned before touching the item
+    std::vector<DataItem> sorted_items_;
+    std::vector<DataItem> pending_; // Inserted since the last rebuild
+    Point max_half_extent_;
+};
+
+extern template class VisitingIndex<GridIndex>;
+extern template class VisitingIndex<QuadtreeIndex>;
+extern template class VisitingIndex<KdTreeIndex>;
+extern template class VisitingIndex<HilbertArrayIndex>;
+extern template class VisitingIndex<CellCoverIndex>;
+
+// --- Backend Factory ---
+// Creates an empty index by name: "rtree", "grid", "quadtree", "kdtree",
+// "hilbert", "cover" or "forest" (GridForest, see grid_forest.h), each with its default
+// parameters; grid, quadtree and forest cover the world in longitude/latitude.
+// Throws std::invalid_argument for other names.
+std::unique_ptr<SpatialIndex> make_spatial_index(const std::string &name);
+
+// Every name make_spatial_index accepts
+const std::vector<std::string> &spatial_index_names();
+
+#endif // INDEX_BACKENDS_H
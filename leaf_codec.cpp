@@ -0,0 +1,356 @@
+#include "leaf_codec.h"
+
+#include <bit>       // For std::bit_cast, std::bit_width
+#include <cmath>     // For std::llround, std::floor, std::ceil
+#include <cstring>   // For std::memcpy
+#include <limits>    // For the population filter's "no filter" value
+#include <stdexcept> // For runtime_error
+
+// --- Key Mappings ---
+
+namespace
+{
+    const std::uint64_t sign_bit = std::uint64_t(1) << 63;
+    const int max_decimal_places = 9;
+    const size_t header_words = 2 + 7; // Counts, widths, one base per column
+    const size_t scan_block = 64;
+
+    // Two's complement integers sort like their keys once the sign bit is flipped
+    std::uint64_t integer_key(std::int64_t value) { return static_cast<std::uint64_t>(value) ^ sign_bit; }
+    std::int64_t integer_value(std::uint64_t key) { return static_cast<std::int64_t>(key ^ sign_bit); }
+
+    // IEEE doubles sort like their keys once negatives are inverted and
+    // positives get the sign bit set. -0.0 is folded into +0.0.
+    std::uint64_t ordered_key(double value)
+    {
+        std::uint64_t bits = std::bit_cast<std::uint64_t>(value == 0.0 ? 0.0 : value);
+        return (bits & sign_bit) ? ~bits : (bits | sign_bit);
+    }
+
+    double ordered_value(std::uint64_t key)
+    {
+        return std::bit_cast<double>((key & sign_bit) ? (key & ~sign_bit) : ~key);
+    }
+
+    double power_of_ten(int places)
+    {
+        double scale = 1.0;
+        for (int i = 0; i < places; ++i)
+            scale *= 10.0;
+        return scale;
+    }
+
+    // True if every coordinate is exactly an integer count of 1 / scale
+    bool fits_decimal(std::span<const DataItem> items, double scale)
+    {
+        const double limit = 9007199254740992.0; // 2^53: integers stay exact
+        for (const auto &item : items)
+        {
+            for (std::size_t i = 0; i < 2; ++i)
+            {
+                for (double value : {item.bounds.min_corner[i], item.bounds.max_corner[i]})
+                {
+                    double scaled = value * scale;
+                    if (!(std::abs(scaled) < limit) || static_cast<double>(std::llround(scaled)) / scale != value)
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    size_t column_words(size_t values, unsigned width)
+    {
+        return (values * width + 63) / 64 + 1; // One spare word for two-word reads
+    }
+
+    void pack(std::uint64_t *column, size_t i, unsigned width, std::uint64_t value)
+    {
+        if (width == 0)
+            return;
+        size_t bit = i * width;
+        size_t word = bit / 64, shift = bit % 64;
+        column[word] |= value << shift;
+        if (shift + width > 64)
+            column[word + 1] |= value >> (64 - shift);
+    }
+}
+
+// --- Encoding ---
+
+CompressedLeaf CompressedLeaf::encode(std::span<const DataItem> items)
+{
+    CompressedLeaf leaf;
+    leaf.count_ = items.size();
+    for (int places = 0; places <= max_decimal_places && !items.empty(); ++places)
+    {
+        if (fits_decimal(items, power_of_ten(places)))
+        {
+            leaf.decimal_places_ = places;
+            leaf.scale_ = power_of_ten(places);
+            break;
+        }
+    }
+
+    // Raw column values before frame-of-reference subtraction
+    const size_t n = items.size();
+    std::vector<std::uint64_t> values[column_count];
+    for (auto &column : values)
+        column.reserve(n + 1);
+    std::uint64_t name_bytes = 0;
+    for (const auto &item : items)
+    {
+        std::uint64_t min_x_key = leaf.coordinate_key(item.bounds.min_corner[0]);
+        std::uint64_t min_y_key = leaf.coordinate_key(item.bounds.min_corner[1]);
+        values[min_x].push_back(min_x_key);
+        values[min_y].push_back(min_y_key);
+        values[extent_x].push_back(leaf.coordinate_key(item.bounds.max_corner[0]) - min_x_key);
+        values[extent_y].push_back(leaf.coordinate_key(item.bounds.max_corner[1]) - min_y_key);
+        values[id].push_back(integer_key(item.id));
+        values[population].push_back(integer_key(item.population));
+        values[name_offset].push_back(name_bytes);
+        name_bytes += item.name.size();
+    }
+    values[name_offset].push_back(name_bytes);
+
+    // Subtract each frame's base (extents and offsets already start at 0), then size the columns
+    for (Column column : {min_x, min_y, id, population})
+    {
+        if (n == 0)
+            break;
+        std::uint64_t base = *std::min_element(values[column].begin(), values[column].end());
+        leaf.bases_[column] = base;
+        for (auto &value : values[column])
+            value -= base;
+    }
+    size_t total_words = header_words;
+    for (int column = 0; column < column_count; ++column)
+    {
+        std::uint64_t largest = values[column].empty() ? 0 : *std::max_element(values[column].begin(), values[column].end());
+        leaf.widths_[column] = static_cast<unsigned>(std::bit_width(largest));
+        total_words += column_words(values[column].size(), leaf.widths_[column]);
+    }
+    total_words += (name_bytes + 7) / 8;
+
+    // Header, then columns, then name bytes
+    leaf.words_.assign(total_words, 0);
+    leaf.words_[0] = static_cast<std::uint64_t>(n) | (static_cast<std::uint64_t>(leaf.decimal_places_ + 1) << 32);
+    for (int column = 0; column < column_count; ++column)
+    {
+        leaf.words_[1] |= static_cast<std::uint64_t>(leaf.widths_[column]) << (8 * column);
+        leaf.words_[2 + column] = leaf.bases_[column];
+    }
+    size_t start = header_words;
+    for (int column = 0; column < column_count; ++column)
+    {
+        for (size_t i = 0; i < values[column].size(); ++i)
+            pack(leaf.words_.data() + start, i, leaf.widths_[column], values[column][i]);
+        start += column_words(values[column].size(), leaf.widths_[column]);
+    }
+    char *names = reinterpret_cast<char *>(leaf.words_.data() + start);
+    for (const auto &item : items)
+    {
+        std::memcpy(names, item.name.data(), item.name.size());
+        names += item.name.size();
+    }
+
+    leaf.index_columns();
+    return leaf;
+}
+
+// --- Serialization ---
+
+std::span<const char> CompressedLeaf::bytes() const
+{
+    return {reinterpret_cast<const char *>(words_.data()), memory_bytes()};
+}
+
+CompressedLeaf CompressedLeaf::from_bytes(std::span<const char> bytes)
+{
+    CompressedLeaf leaf;
+    if (bytes.size() % sizeof(std::uint64_t) != 0 || bytes.size() < header_words * sizeof(std::uint64_t))
+        throw std::runtime_error("Malformed compressed leaf");
+    leaf.words_.resize(bytes.size() / sizeof(std::uint64_t));
+    std::memcpy(leaf.words_.data(), bytes.data(), bytes.size());
+    leaf.index_columns();
+    return leaf;
+}
+
+void CompressedLeaf::index_columns()
+{
+    count_ = static_cast<size_t>(words_[0] & 0xFFFFFFFFu);
+    decimal_places_ = static_cast<int>((words_[0] >> 32) & 0xFFu) - 1;
+    if (decimal_places_ > max_decimal_places)
+        throw std::runtime_error("Malformed compressed leaf");
+    scale_ = decimal() ? power_of_ten(decimal_places_) : 1.0;
+
+    size_t start = header_words;
+    for (int column = 0; column < column_count; ++column)
+    {
+        widths_[column] = static_cast<unsigned>((words_[1] >> (8 * column)) & 0xFFu);
+        bases_[column] = words_[2 + column];
+        if (widths_[column] > 64)
+            throw std::runtime_error("Malformed compressed leaf");
+        column_start_[column] = start;
+        start += column_words(count_ + (column == name_offset), widths_[column]);
+    }
+    names_start_ = start;
+    if (names_start_ > words_.size() || get(name_offset, count_) > (words_.size() - names_start_) * sizeof(std::uint64_t))
+        throw std::runtime_error("Malformed compressed leaf");
+}
+
+// --- Decoding ---
+
+void CompressedLeaf::unpack(Column column, size_t begin, size_t n, std::uint64_t *out) const
+{
+    const unsigned width = widths_[column];
+    if (width == 0) // Every value equals the base; the column has no data words
+    {
+        std::fill(out, out + n, std::uint64_t(0));
+        return;
+    }
+    const std::uint64_t *words = words_.data() + column_start_[column];
+    const std::uint64_t mask = width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+    for (size_t k = 0; k < n; ++k)
+    {
+        size_t bit = (begin + k) * width;
+        size_t word = bit / 64, shift = bit % 64;
+        // The second shift is split so that shift == 0 contributes nothing
+        std::uint64_t value = (words[word] >> shift) | ((words[word + 1] << 1) << (63 - shift));
+        out[k] = value & mask;
+    }
+}
+
+std::uint64_t CompressedLeaf::get(Column column, size_t i) const
+{
+    std::uint64_t value;
+    unpack(column, i, 1, &value);
+    return bases_[column] + value;
+}
+
+std::uint64_t CompressedLeaf::coordinate_key(double value) const
+{
+    return decimal() ? integer_key(std::llround(value * scale_)) : ordered_key(value);
+}
+
+double CompressedLeaf::coordinate_value(std::uint64_t key) const
+{
+    return decimal() ? static_cast<double>(integer_value(key)) / scale_ : ordered_value(key);
+}
+
+Rectangle CompressedLeaf::bounds(size_t i) const
+{
+    std::uint64_t x = get(min_x, i), y = get(min_y, i);
+    return Rectangle(coordinate_value(x), coordinate_value(y),
+                     coordinate_value(x + get(extent_x, i)), coordinate_value(y + get(extent_y, i)));
+}
+
+DataItem CompressedLeaf::item(size_t i) const
+{
+    const char *names = reinterpret_cast<const char *>(words_.data() + names_start_);
+    std::uint64_t name_begin = get(name_offset, i), name_end = get(name_offset, i + 1);
+    return DataItem(static_cast<int>(integer_value(get(id, i))),
+                    std::string(names + name_begin, names + name_end),
+                    static_cast<long>(integer_value(get(population, i))),
+                    bounds(i));
+}
+
+std::vector<DataItem> CompressedLeaf::decode() const
+{
+    std::vector<DataItem> items;
+    items.reserve(count_);
+    for (size_t i = 0; i < count_; ++i)
+        items.push_back(item(i));
+    return items;
+}
+
+// --- Scanning ---
+
+bool CompressedLeaf::key_at_most(double bound, std::uint64_t &key) const
+{
+    if (std::isnan(bound))
+        return false;
+    if (!decimal())
+    {
+        key = ordered_key(bound);
+        return true;
+    }
+    // Stored integers are below 2^53, so clamping far-away bounds to 2^62 is safe
+    const double limit = 4611686018427387904.0;
+    double scaled = std::floor(bound * scale_);
+    if (scaled < -limit)
+        return false;
+    std::int64_t t = scaled > limit ? static_cast<std::int64_t>(limit) : static_cast<std::int64_t>(scaled);
+    while (static_cast<double>(t) / scale_ > bound)
+        --t;
+    while (t < static_cast<std::int64_t>(limit) && static_cast<double>(t + 1) / scale_ <= bound)
+        ++t;
+    key = integer_key(t);
+    return true;
+}
+
+bool CompressedLeaf::key_at_least(double bound, std::uint64_t &key) const
+{
+    if (std::isnan(bound))
+        return false;
+    if (!decimal())
+    {
+        key = ordered_key(bound);
+        return true;
+    }
+    const double limit = 4611686018427387904.0;
+    double scaled = std::ceil(bound * scale_);
+    if (scaled > limit)
+        return false;
+    std::int64_t t = scaled < -limit ? -static_cast<std::int64_t>(limit) : static_cast<std::int64_t>(scaled);
+    while (static_cast<double>(t) / scale_ < bound)
+        ++t;
+    while (t > -static_cast<std::int64_t>(limit) && static_cast<double>(t - 1) / scale_ >= bound)
+        --t;
+    key = integer_key(t);
+    return true;
+}
+
+void CompressedLeaf::scan(const Rectangle &query, long min_population, std::vector<std::uint32_t> &matches) const
+{
+    // Entry intersects query iff min <= query max and max >= query min, per axis
+    std::uint64_t upper_x, upper_y, lower_x, lower_y;
+    if (count_ == 0 || !key_at_most(query.max_corner[0], upper_x) || !key_at_most(query.max_corner[1], upper_y) ||
+        !key_at_least(query.min_corner[0], lower_x) || !key_at_least(query.min_corner[1], lower_y))
+        return;
+    if (upper_x < bases_[min_x] || upper_y < bases_[min_y])
+        return; // Every min corner lies beyond the query
+    const std::uint64_t min_x_limit = upper_x - bases_[min_x], min_y_limit = upper_y - bases_[min_y];
+    const std::uint64_t base_x = bases_[min_x], base_y = bases_[min_y];
+    const bool filter_population = min_population != std::numeric_limits<long>::min();
+    const std::uint64_t population_key = integer_key(min_population);
+
+    std::uint64_t mx[scan_block], my[scan_block], ex[scan_block], ey[scan_block], pop[scan_block];
+    for (size_t begin = 0; begin < count_; begin += scan_block)
+    {
+        const size_t n = std::min(scan_block, count_ - begin);
+        unpack(min_x, begin, n, mx);
+        unpack(min_y, begin, n, my);
+        unpack(extent_x, begin, n, ex);
+        unpack(extent_y, begin, n, ey);
+
+        std::uint64_t hits = 0;
+        for (size_t k = 0; k < n; ++k)
+        {
+            bool hit = (mx[k] <= min_x_limit) & (my[k] <= min_y_limit) &
+                       (base_x + mx[k] + ex[k] >= lower_x) & (base_y + my[k] + ey[k] >= lower_y);
+            hits |= static_cast<std::uint64_t>(hit) << k;
+        }
+        if (filter_population && hits)
+        {
+            unpack(population, begin, n, pop);
+            for (size_t k = 0; k < n; ++k)
+                hits &= ~(static_cast<std::uint64_t>(bases_[population] + pop[k] < population_key) << k);
+        }
+        while (hits)
+        {
+            matches.push_back(static_cast<std::uint32_t>(begin + std::countr_zero(hits)));
+            hits &= hits - 1;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef LEAF_CODEC_H
+#define LEAF_CODEC_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <cstdint> // For packed words
+#include <span>    // For encoder input and serialized bytes
+
+// --- Compressed Leaves ---
+// Losslessly packs the entries of one leaf into a few bit-packed columns:
+//   * Coordinates are mapped to 64-bit keys that sort like the values. If
+//     every coordinate in the leaf is a decimal with at most 9 places (as
+//     parsed from CSV), the key is the scaled integer; otherwise it is the
+//     IEEE bit pattern made order-preserving. Min corners are stored as
+//     deltas from the smallest min key of the leaf, max corners as the
+//     extent (max key - min key) of their own box.
+//   * Ids and populations are stored frame-of-reference: minus the leaf's
+//     smallest value.
+//   * Names are concatenated, with a packed column of start offsets.
+// Each column uses the fewest bits that hold its largest value.
+//
+// scan() never decodes to doubles: the query is converted to key thresholds
+// once, and blocks of 64 entries are unpacked into small integer arrays and
+// compared in straight-line loops the compiler can vectorize.
+//
+// Round trips are exact except that -0.0 comes back as +0.0.
+class CompressedLeaf
+{
+public:
+    static CompressedLeaf encode(std::span<const DataItem> items);
+
+    // Serialized form (the same words that are held in memory)
+    std::span<const char> bytes() const;
+    // Throws std::runtime_error if bytes is not a well-formed leaf
+    static CompressedLeaf from_bytes(std::span<const char> bytes);
+
+    size_t size() const { return count_; }
+    size_t memory_bytes() const { return words_.size() * sizeof(std::uint64_t); }
+    bool decimal() const { return decimal_places_ >= 0; }
+
+    Rectangle bounds(size_t i) const;
+    DataItem item(size_t i) const;
+    std::vector<DataItem> decode() const;
+
+    // Appends the indices of entries intersecting query with population >= min_population
+    void scan(const Rectangle &query, long min_population, std::vector<std::uint32_t> &matches) const;
+
+private:
+    enum Column
+    {
+        min_x,
+        min_y,
+        extent_x,
+        extent_y,
+        id,
+        population,
+        name_offset,
+        column_count
+    };
+
+    // Parses the header and locates the columns
+    void index_columns();
+
+    std::uint64_t get(Column column, size_t i) const;
+    void unpack(Column column, size_t begin, size_t n, std::uint64_t *out) const;
+
+    std::uint64_t coordinate_key(double value) const;
+    double coordinate_value(std::uint64_t key) const;
+    // Largest key whose value is <= bound / smallest key whose value is >= bound
+    // (false if there is none)
+    bool key_at_most(double bound, std::uint64_t &key) const;
+    bool key_at_least(double bound, std::uint64_t &key) const;
+
+    std::vector<std::uint64_t> words_;
+    size_t count_ = 0;
+    int decimal_places_ = -1; // -1: ordered IEEE keys
+    double scale_ = 1.0;      // 10^decimal_places_
+    unsigned widths_[column_count] = {};
+    std::uint64_t bases_[column_count] = {};
+    size_t column_start_[column_count] = {}; // Word index of each column
+    size_t names_start_ = 0;                 // Word index of the name bytes
+};
+
+#endif // LEAF_CODEC_H
@@ -0,0 +1,281 @@
+#include "lsm_rtree.h"
+
+#include <limits> // For the all-covering rectangle
+
+// Node fan-out of the memtable and the packed runs
+static const size_t lsm_min_entries = 4;
+static const size_t lsm_max_entries = 16;
+
+static const double inf = std::numeric_limits<double>::infinity();
+static const Rectangle everything(-inf, -inf, inf, inf);
+
+// --- Construction ---
+
+LsmRTree::LsmRTree(size_t memtable_capacity, size_t merge_fan_in, bool background_merge)
+    : memtable_capacity_(std::max<size_t>(memtable_capacity, 1)),
+      merge_fan_in_(std::max<size_t>(merge_fan_in, 2)),
+      memtable_(std::make_unique<RTree>(lsm_min_entries, lsm_max_entries))
+{
+    if (background_merge)
+    {
+        merge_thread_ = std::thread(&LsmRTree::merge_loop, this);
+    }
+}
+
+LsmRTree::~LsmRTree()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    merge_wanted_.notify_all();
+    if (merge_thread_.joinable())
+        merge_thread_.join();
+}
+
+// --- Updates ---
+
+void LsmRTree::insert(const DataItem &item)
+{
+    RunPtr frozen;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [existing, inserted] = memtable_bounds_.try_emplace(item.id, item.bounds);
+        if (!inserted)
+        {
+            memtable_->remove(DataItem(item.id, "", 0, existing->second));
+            existing->second = item.bounds;
+        }
+        memtable_tombstones_.erase(item.id);
+        memtable_->insert(item);
+
+        if (memtable_bounds_.size() >= memtable_capacity_)
+            frozen = freeze_memtable();
+    }
+    if (frozen)
+        pack_run(frozen);
+}
+
+void LsmRTree::remove(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto existing = memtable_bounds_.find(id);
+    if (existing != memtable_bounds_.end())
+    {
+        memtable_->remove(DataItem(id, "", 0, existing->second));
+        memtable_bounds_.erase(existing);
+    }
+    // Older runs may still hold the id
+    if (!runs_.empty())
+        memtable_tombstones_.insert(id);
+}
+
+void LsmRTree::flush()
+{
+    RunPtr frozen;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frozen = freeze_memtable();
+    }
+    if (frozen)
+        pack_run(frozen);
+}
+
+void LsmRTree::compact()
+{
+    flush();
+    merge_group(true);
+}
+
+LsmRTree::RunPtr LsmRTree::freeze_memtable()
+{
+    if (memtable_bounds_.empty() && memtable_tombstones_.empty())
+        return nullptr;
+
+    // The memtable becomes the newest run as it is; pack_run replaces its tree later
+    auto run = std::make_shared<Run>();
+    run->ids.reserve(memtable_bounds_.size());
+    for (const auto &[id, bounds] : memtable_bounds_)
+    {
+        run->ids.insert(id);
+    }
+    memtable_->tighten(); // Runs are read concurrently, so no MBR may be left stale
+    run->tree = std::move(memtable_);
+    run->tombstones = std::move(memtable_tombstones_);
+
+    runs_.insert(runs_.begin(), run);
+    memtable_ = std::make_unique<RTree>(lsm_min_entries, lsm_max_entries);
+    memtable_bounds_.clear();
+    memtable_tombstones_.clear();
+
+    if (!full_tier().empty())
+        merge_wanted_.notify_one();
+    return run;
+}
+
+void LsmRTree::pack_run(const RunPtr &frozen)
+{
+    // Runs are immutable, so the packed tree goes into a copy of the run
+    auto packed = std::make_shared<Run>();
+    packed->ids = frozen->ids;
+    packed->tombstones = frozen->tombstones;
+    packed->tier = frozen->tier;
+    packed->tree = std::make_unique<RTree>(lsm_min_entries, lsm_max_entries);
+    packed->tree->bulk_load(frozen->tree->search(everything));
+
+    // A merge that took the run meanwhile has packed its items already
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto slot = std::find(runs_.begin(), runs_.end(), frozen);
+    if (slot != runs_.end())
+        *slot = std::move(packed);
+}
+
+// --- Merging ---
+
+LsmRTree::RunPtr LsmRTree::merge_runs(const std::vector<RunPtr> &runs, bool includes_oldest) const
+{
+    auto merged = std::make_shared<Run>();
+    std::unordered_set<int> deleted;
+    std::vector<DataItem> items;
+    for (const RunPtr &run : runs)
+    {
+        for (DataItem &item : run->tree->search(everything))
+        {
+            // Skip copies shadowed by a newer run or deleted after this run froze
+            if (deleted.count(item.id) || !merged->ids.insert(item.id).second)
+                continue;
+            items.push_back(std::move(item));
+        }
+        deleted.insert(run->tombstones.begin(), run->tombstones.end());
+    }
+    if (!includes_oldest)
+        merged->tombstones = std::move(deleted);
+
+    merged->tree = std::make_unique<RTree>(lsm_min_entries, lsm_max_entries);
+    merged->tree->bulk_load(items);
+    merged->tree->tighten();
+    merged->tier = runs.back()->tier + 1;
+    return merged;
+}
+
+std::vector<LsmRTree::RunPtr> LsmRTree::full_tier() const
+{
+    // Tiers never decrease from newest to oldest, so each tier is a contiguous group
+    for (size_t begin = 0; begin < runs_.size();)
+    {
+        size_t end = begin;
+        while (end < runs_.size() && runs_[end]->tier == runs_[begin]->tier)
+            ++end;
+        if (end - begin >= merge_fan_in_)
+            return std::vector<RunPtr>(runs_.begin() + begin, runs_.begin() + end);
+        begin = end;
+    }
+    return {};
+}
+
+void LsmRTree::merge_group(bool everything)
+{
+    std::lock_guard<std::mutex> merge_lock(merge_mutex_);
+
+    std::vector<RunPtr> group;
+    bool includes_oldest;
+    size_t from_oldest; // Position of the group's first run, counted from the end
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        group = everything ? runs_ : full_tier();
+        if (group.size() < 2)
+            return;
+        includes_oldest = group.back() == runs_.back();
+        from_oldest = runs_.end() - std::find(runs_.begin(), runs_.end(), group.front());
+    }
+
+    // The expensive part runs without blocking readers and writers
+    RunPtr merged = merge_runs(group, includes_oldest);
+
+    // pack_run may have replaced runs of the group in place, so they are
+    // found by position rather than by pointer
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto first = runs_.erase(runs_.end() - from_oldest, runs_.end() - from_oldest + group.size());
+    runs_.insert(first, std::move(merged));
+}
+
+void LsmRTree::merge_loop()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            merge_wanted_.wait(lock, [&]
+                               { return stopping_ || !full_tier().empty(); });
+            if (stopping_)
+                return;
+        }
+        merge_group(false);
+    }
+}
+
+// --- Queries ---
+
+template <typename Visit>
+void LsmRTree::visit_live(const Rectangle &query_rect, Visit &&visit) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The memtable holds the newest copy of every id it contains
+    memtable_->for_each_intersecting(query_rect, visit);
+
+    for (size_t level = 0; level < runs_.size(); ++level)
+    {
+        runs_[level]->tree->for_each_intersecting(query_rect, [&](const DataItem &item)
+                                                  {
+                                                      // Hidden if any newer level stores or deleted the same id
+                                                      if (memtable_bounds_.count(item.id) || memtable_tombstones_.count(item.id))
+                                                          return;
+                                                      for (size_t newer = 0; newer < level; ++newer)
+                                                      {
+                                                          if (runs_[newer]->ids.count(item.id) || runs_[newer]->tombstones.count(item.id))
+                                                              return;
+                                                      }
+                                                      visit(item); });
+    }
+}
+
+std::vector<DataItem> LsmRTree::search(const Rectangle &query_rect) const
+{
+    std::vector<DataItem> results;
+    visit_live(query_rect, [&](const DataItem &item)
+               { results.push_back(item); });
+    return results;
+}
+
+std::vector<DataItem> LsmRTree::search_with_population(const Rectangle &query_rect, long min_population) const
+{
+    std::vector<DataItem> results;
+    visit_live(query_rect, [&](const DataItem &item)
+               {
+                   if (item.population >= min_population)
+                       results.push_back(item); });
+    return results;
+}
+
+size_t LsmRTree::count(const Rectangle &query_rect) const
+{
+    size_t matches = 0;
+    visit_live(query_rect, [&](const DataItem &)
+               { ++matches; });
+    return matches;
+}
+
+// --- Introspection ---
+
+size_t LsmRTree::memtable_size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memtable_bounds_.size();
+}
+
+size_t LsmRTree::run_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return runs_.size();
+}
@@ -0,0 +1,118 @@
+#ifndef LSM_RTREE_H
+#define LSM_RTREE_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <memory>             // For std::shared_ptr (runs are shared with the merge thread)
+#include <unordered_map>      // Memtable items by id
+#include <unordered_set>      // Per-level id and tombstone sets
+#include <mutex>              // Guards the memtable and the run list
+#include <condition_variable> // Wakes the merge thread
+#include <thread>             // Background merging
+
+// --- Log-Structured Merge R-Tree ---
+// Write-optimized index for sustained ingest. New items go to a small,
+// mutable in-memory RTree (the memtable). When the memtable reaches its
+// capacity it is frozen and bulk-packed into an immutable run. Runs are
+// size-tiered: a frozen memtable is tier 0, and once a tier holds merge_fan_in
+// runs a background thread merges them into one packed run of the next tier.
+// Each insert therefore only touches a small tree, every item is rewritten
+// only about log(n / memtable_capacity) / log(merge_fan_in) times, and the
+// runs stay tightly packed no matter the insert order.
+//
+// Queries fan out over the memtable and every run, newest first. An id seen
+// in a newer level shadows older copies of it, so inserting an existing id
+// replaces it. Deletes write a tombstone, which hides the id in all older
+// runs until a merge drops both.
+//
+// All public methods are thread-safe; they serialize on one mutex, which the
+// merge thread only takes to swap in its result. A full memtable becomes the
+// newest run at once and is bulk-packed after the mutex is released.
+class LsmRTree
+{
+public:
+    // memtable_capacity: items held in the mutable tree before it is frozen.
+    // merge_fan_in: number of runs of one tier that are merged together.
+    // background_merge: merge on a background thread (otherwise only compact() merges).
+    explicit LsmRTree(size_t memtable_capacity = 65536, size_t merge_fan_in = 4, bool background_merge = true);
+
+    LsmRTree(const LsmRTree &) = delete;
+    LsmRTree &operator=(const LsmRTree &) = delete;
+    ~LsmRTree();
+
+    // Insert item, replacing any stored item with the same id
+    void insert(const DataItem &item);
+
+    // Delete the item with the given id (a no-op if it is not stored)
+    void remove(int id);
+
+    // Same queries as RTree, over the newest version of every live item
+    std::vector<DataItem> search(const Rectangle &query_rect) const;
+    std::vector<DataItem> search_with_population(const Rectangle &query_rect, long min_population) const;
+    size_t count(const Rectangle &query_rect) const;
+
+    // Freeze the memtable into a run now, even if it is not full
+    void flush();
+
+    // Flush, then merge all runs into one on the calling thread
+    void compact();
+
+    size_t memtable_size() const;
+    size_t run_count() const;
+
+private:
+    // An immutable, bulk-packed level
+    struct Run
+    {
+        std::unique_ptr<RTree> tree;
+        std::unordered_set<int> ids;        // Ids stored in this run
+        std::unordered_set<int> tombstones; // Ids deleted while this run (or the runs merged into it) was newest
+        size_t tier = 0;                    // Number of merges its items went through
+    };
+    using RunPtr = std::shared_ptr<const Run>;
+
+    // Turn the memtable into the newest run as it is and return that run,
+    // or null if the memtable is empty (caller holds mutex_)
+    RunPtr freeze_memtable();
+
+    // Bulk-pack a run returned by freeze_memtable and swap it in, unless a
+    // merge has taken the run meanwhile (caller must not hold mutex_)
+    void pack_run(const RunPtr &frozen);
+
+    // Merge adjacent runs (newest first) into one. Copies shadowed within the
+    // group are dropped; tombstones are kept unless the group ends with the
+    // oldest run, since older runs may still hold the deleted ids.
+    RunPtr merge_runs(const std::vector<RunPtr> &runs, bool includes_oldest) const;
+
+    // The runs of the first tier that has filled up (caller holds mutex_)
+    std::vector<RunPtr> full_tier() const;
+
+    // Merge a group of adjacent runs and swap the result in for them.
+    // merge_mutex_ keeps the merge thread and compact() from merging the same
+    // runs twice; runs frozen meanwhile are only ever prepended, and packing
+    // replaces a run in place, so the group keeps its position from the end.
+    void merge_group(bool everything);
+
+    void merge_loop();
+
+    // Call visit for the newest live copy of every item intersecting query_rect
+    template <typename Visit>
+    void visit_live(const Rectangle &query_rect, Visit &&visit) const;
+
+    const size_t memtable_capacity_;
+    const size_t merge_fan_in_;
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<RTree> memtable_;
+    std::unordered_map<int, Rectangle> memtable_bounds_; // Ids in the memtable, with the bounds needed to remove them
+    std::unordered_set<int> memtable_tombstones_;
+    std::vector<RunPtr> runs_; // Newest first
+
+    std::mutex merge_mutex_;
+    std::condition_variable merge_wanted_;
+    bool stopping_ = false;
+    std::thread merge_thread_;
+};
+
+#endif // LSM_RTREE_H
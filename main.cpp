@@ -1,4 +1,6 @@
 #include "rtree.h"
+#include "index_backends.h" // For choosing the backend by name
+#include "fanout_tuning.h"   // For packing the rtree backend with measured node capacities
 #include <iostream>
 #include <vector>
 #include <string>
@@ -30,9 +32,10 @@ std::map<std::string, Rectangle> country_bounds = {
 };
 
 // --- Function to Load Data from CSV ---
-// Loads data, skips header, comments (#), and malformed lines.
-void load_data_from_csv(const std::string &filename, RTree &tree)
+// Reads the data items, skipping header, comments (#), and malformed lines.
+std::vector<DataItem> load_data_from_csv(const std::string &filename)
 {
+    std::vector<DataItem> items;
     std::ifstream input_file(filename);
     std::string line;
     int line_number = 0;
@@ -104,8 +107,8 @@ void load_data_from_csv(const std::string &filename, RTree &tree)
                 items_skipped++;
                 continue;
             }
-            // Insert valid data into R-Tree
-            tree.insert(DataItem(id, name, population, Rectangle(min_x, min_y, max_x, max_y)));
+            // Keep valid data for the index
+            items.emplace_back(id, name, population, Rectangle(min_x, min_y, max_x, max_y));
             items_loaded++;
         }
         catch (const std::invalid_argument &e)
@@ -120,7 +123,7 @@ void load_data_from_csv(const std::string &filename, RTree &tree)
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Warning: Skipping line " << line_number << " due to error during processing/insertion: " << e.what() << std::endl;
+            std::cerr << "Warning: Skipping line " << line_number << " due to error during processing: " << e.what() << std::endl;
             items_skipped++;
         }
         catch (...)
@@ -143,6 +146,7 @@ void load_data_from_csv(const std::string &filename, RTree &tree)
     {
         std::cerr << "ERROR: Input file seems empty or contains only a header." << std::endl;
     }
+    return items;
 }
 
 // --- Input Functions ---
@@ -237,21 +241,50 @@ long get_population_threshold_from_user()
 }
 
 // --- Main Function ---
-int main()
+// Usage: rtree_app [backend], where backend is one of spatial_index_names() (default "rtree")
+int main(int argc, char *argv[])
 {
     std::cout << "===== R-Tree Spatial Query Application =====\n";
 
-    // 1. Create the R-Tree
-    RTree spatial_index;
+    // 1. Create the spatial index
+    const std::string backend = argc > 1 ? argv[1] : "rtree";
+    std::unique_ptr<SpatialIndex> spatial_index;
+    try
+    {
+        spatial_index = make_spatial_index(backend);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cerr << e.what() << ". Available backends:";
+        for (const auto &name : spatial_index_names())
+            std::cerr << " " << name;
+        std::cerr << std::endl;
+        return 1;
+    }
 
     // 2. Load Data (handle potential errors)
     try
     {
-        load_data_from_csv(input_data_filename, spatial_index);
+        std::vector<DataItem> items = load_data_from_csv(input_data_filename);
+        if (backend == "rtree")
+        {
+            // Pack the tree once, with node capacities measured on the predefined query regions
+            std::vector<Rectangle> queries;
+            for (const auto &[name, bounds] : country_bounds)
+                queries.push_back(bounds);
+            TunedRTree tuned = bulk_load_tuned(items, queries);
+            std::cout << "Packed R-tree with " << tuned.tuning.best.max_entries << " entries per internal node and "
+                      << tuned.tuning.best.max_leaf_entries << " per leaf (measured)." << std::endl;
+            spatial_index = std::move(tuned.tree);
+        }
+        else
+        {
+            spatial_index->insert_batch(items);
+        }
         // Exit if no data could be loaded
-        if (spatial_index.empty())
+        if (spatial_index->empty())
         {
-            std::cerr << "Error: R-Tree is empty after attempting to load data. Cannot perform query." << std::endl;
+            std::cerr << "Error: Spatial index is empty after attempting to load data. Cannot perform query." << std::endl;
             return 1; // Indicate error
         }
     }
@@ -282,7 +315,7 @@ int main()
               << query_bounds.min_corner.x << "," << query_bounds.min_corner.y << ")-("
               << query_bounds.max_corner.x << "," << query_bounds.max_corner.y << ")"
               << " for population >= " << min_population << "\n";
-    std::vector<DataItem> results = spatial_index.search_with_population(query_bounds, min_population);
+    std::vector<DataItem> results = spatial_index->search_with_population(query_bounds, min_population);
 
     // 5. Write Results to CSV
     std::cout << "\n--- Writing Results to CSV File ---" << std::endl;
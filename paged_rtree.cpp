@@ -0,0 +1,516 @@
+#include "paged_rtree.h"
+#include "async_io.h"
+
+#include <cstring>   // For std::memcpy, std::memset
+#include <fstream>   // For the names file and the header probe
+#include <stdexcept> // For runtime_error, invalid_argument
+#include <fcntl.h>   // For open
+#include <unistd.h>  // For pread, pwrite, fsync, close
+
+// --- Page Layout ---
+// Node page:   [u16 is_leaf][u16 entry count][u32 reserved][entries...]
+// Leaf entry:  [4 x double bounds][i64 population][u64 name offset][i32 id][u32 name size]
+// Child entry: [4 x double bounds][u64 child page]
+// Header page: [8-byte magic][u64 page size][u64 root page][u64 height][u64 item count]
+
+namespace
+{
+    const size_t node_header_size = 8;
+    const size_t bounds_size = 4 * sizeof(double);
+    const size_t leaf_entry_size = bounds_size + 8 + 8 + 4 + 4;
+    const size_t child_entry_size = bounds_size + 8;
+    const char page_file_magic[8] = {'R', 'T', 'P', 'A', 'G', 'E', '0', '1'};
+
+    template <typename V>
+    V load(const char *at)
+    {
+        V value;
+        std::memcpy(&value, at, sizeof(V));
+        return value;
+    }
+
+    template <typename V>
+    void store(char *at, const V &value)
+    {
+        std::memcpy(at, &value, sizeof(V));
+    }
+
+    Rectangle load_bounds(const char *at)
+    {
+        Rectangle r;
+        r.min_corner[0] = load<double>(at);
+        r.min_corner[1] = load<double>(at + 8);
+        r.max_corner[0] = load<double>(at + 16);
+        r.max_corner[1] = load<double>(at + 24);
+        return r;
+    }
+
+    void store_bounds(char *at, const Rectangle &r)
+    {
+        store(at, r.min_corner[0]);
+        store(at + 8, r.min_corner[1]);
+        store(at + 16, r.max_corner[0]);
+        store(at + 24, r.max_corner[1]);
+    }
+
+    bool page_is_leaf(const char *page) { return load<std::uint16_t>(page) != 0; }
+    size_t page_entries(const char *page) { return load<std::uint16_t>(page + 2); }
+}
+
+// --- Page File ---
+
+PageFile::PageFile(const std::string &path, size_t page_size, bool create)
+    : path_(path), page_size_(page_size)
+{
+    fd_ = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+    if (fd_ < 0)
+        throw std::runtime_error("Could not open page file: " + path);
+    off_t end = ::lseek(fd_, 0, SEEK_END);
+    page_count_ = end < 0 ? 0 : static_cast<PageId>(end) / page_size_;
+}
+
+PageFile::~PageFile()
+{
+    ::close(fd_);
+}
+
+void PageFile::read(PageId id, char *page) const
+{
+    ssize_t got = ::pread(fd_, page, page_size_, static_cast<off_t>(id * page_size_));
+    if (got != static_cast<ssize_t>(page_size_))
+        throw std::runtime_error("Could not read page " + std::to_string(id) + " of " + path_);
+}
+
+void PageFile::write(PageId id, const char *page)
+{
+    ssize_t put = ::pwrite(fd_, page, page_size_, static_cast<off_t>(id * page_size_));
+    if (put != static_cast<ssize_t>(page_size_))
+        throw std::runtime_error("Could not write page " + std::to_string(id) + " of " + path_);
+    page_count_ = std::max(page_count_, id + 1);
+}
+
+void PageFile::drop_os_cache() const
+{
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+void PageFile::sync()
+{
+    if (::fsync(fd_) != 0)
+        throw std::runtime_error("Could not fsync page file: " + path_);
+}
+
+// --- Buffer Pool ---
+
+BufferPool::BufferPool(PageFile &file, size_t capacity)
+    : file_(file),
+      memory_(std::max<size_t>(capacity, 1) * file.page_size()),
+      frames_(std::max<size_t>(capacity, 1))
+{
+}
+
+BufferPool::~BufferPool()
+{
+    // Reads in flight still write into our frames
+    while (in_flight_ > 0)
+        wait_for_reads();
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "ERROR: Could not write back buffer pool: " << e.what() << std::endl;
+    }
+}
+
+size_t BufferPool::victim()
+{
+    reap();
+    size_t frame = try_victim();
+    while (frame == npos && in_flight_ > 0)
+    {
+        wait_for_reads(); // Prefetched frames become evictable once loaded
+        frame = try_victim();
+    }
+    if (frame == npos)
+        throw std::runtime_error("Buffer pool exhausted: all " + std::to_string(frames_.size()) + " pages are pinned");
+    return frame;
+}
+
+size_t BufferPool::try_victim()
+{
+    // Two sweeps clear every reference bit, so a third finds any unpinned frame
+    for (size_t step = 0; step < 3 * frames_.size(); ++step)
+    {
+        size_t frame = clock_hand_;
+        clock_hand_ = (clock_hand_ + 1) % frames_.size();
+        Frame &f = frames_[frame];
+        if (f.pin_count > 0)
+            continue;
+        if (f.referenced)
+        {
+            f.referenced = false;
+            continue;
+        }
+        if (f.used)
+        {
+            if (f.dirty)
+                file_.write(f.id, frame_data(frame));
+            page_table_.erase(f.id);
+        }
+        f = Frame();
+        return frame;
+    }
+    return npos;
+}
+
+char *BufferPool::pin(PageId id)
+{
+    reap();
+    auto cached = page_table_.find(id);
+    while (cached != page_table_.end() && frames_[cached->second].loading)
+    {
+        wait_for_reads();
+        cached = page_table_.find(id); // Gone if the read failed; then read it below
+    }
+    if (cached != page_table_.end())
+    {
+        Frame &f = frames_[cached->second];
+        ++f.pin_count;
+        f.referenced = true;
+        ++hits_;
+        return frame_data(cached->second);
+    }
+
+    size_t frame = victim();
+    file_.read(id, frame_data(frame));
+    ++reads_;
+    frames_[frame] = Frame{id, 1, true, true, false};
+    page_table_[id] = frame;
+    return frame_data(frame);
+}
+
+char *BufferPool::pin_new(PageId &id)
+{
+    size_t frame = victim();
+    id = file_.allocate();
+    std::memset(frame_data(frame), 0, file_.page_size());
+    frames_[frame] = Frame{id, 1, true, true, true}; // Dirty until first written
+    page_table_[id] = frame;
+    return frame_data(frame);
+}
+
+void BufferPool::unpin(PageId id, bool dirty)
+{
+    Frame &f = frames_[page_table_.at(id)];
+    --f.pin_count;
+    f.dirty = f.dirty || dirty;
+}
+
+void BufferPool::flush()
+{
+    for (size_t frame = 0; frame < frames_.size(); ++frame)
+    {
+        Frame &f = frames_[frame];
+        if (f.used && f.dirty)
+        {
+            file_.write(f.id, frame_data(frame));
+            f.dirty = false;
+        }
+    }
+    file_.sync();
+}
+
+void BufferPool::enable_async_reads(size_t threads)
+{
+    if (reader_)
+        return;
+    reader_ = std::make_unique<ThreadPoolPageReader>(file_, threads, [this](const PageRead &request, bool ok)
+                                                     {
+                                                         {
+                                                             std::lock_guard<std::mutex> lock(io_mutex_);
+                                                             completed_.emplace_back(request.tag, ok);
+                                                         }
+                                                         io_done_.notify_one(); });
+}
+
+void BufferPool::prefetch(std::span<const PageId> ids)
+{
+    if (!reader_)
+        return;
+    reap();
+
+    std::vector<PageRead> batch;
+    for (PageId id : ids)
+    {
+        if (in_flight_ + batch.size() >= frames_.size() / 2)
+            break;
+        if (page_table_.count(id))
+            continue;
+        size_t frame = try_victim();
+        if (frame == npos)
+            break;
+        frames_[frame] = Frame{id, 1, true, true, false, true};
+        page_table_[id] = frame;
+        batch.push_back(PageRead{id, frame_data(frame), frame});
+    }
+    if (batch.empty())
+        return;
+    in_flight_ += batch.size();
+    reads_ += batch.size();
+    prefetches_ += batch.size();
+    reader_->submit(batch);
+}
+
+void BufferPool::reap()
+{
+    if (in_flight_ == 0)
+        return;
+    std::vector<std::pair<size_t, bool>> done;
+    {
+        std::lock_guard<std::mutex> lock(io_mutex_);
+        done.swap(completed_);
+    }
+    for (auto [frame, ok] : done)
+    {
+        --in_flight_;
+        Frame &f = frames_[frame];
+        f.loading = false;
+        --f.pin_count;
+        if (!ok)
+        {
+            page_table_.erase(f.id);
+            f = Frame();
+        }
+    }
+}
+
+void BufferPool::wait_for_reads()
+{
+    {
+        std::unique_lock<std::mutex> lock(io_mutex_);
+        io_done_.wait(lock, [&]
+                      { return !completed_.empty(); });
+    }
+    reap();
+}
+
+// --- Paged R-Tree: Building ---
+
+void PagedRTree::build(const std::string &path, std::span<const DataItem> items, size_t page_size)
+{
+    if (page_size < min_page_size || page_size > max_page_size || (page_size & (page_size - 1)) != 0)
+        throw std::invalid_argument("Page size must be a power of two between 4 KiB and 16 KiB");
+    const size_t leaf_capacity = (page_size - node_header_size) / leaf_entry_size;
+    const size_t child_capacity = (page_size - node_header_size) / child_entry_size;
+
+    PageFile file(path, page_size, true);
+    BufferPool pool(file, 64);
+    std::ofstream names(path + ".names", std::ios::binary | std::ios::trunc);
+    if (!names)
+        throw std::runtime_error("Could not create names file: " + path + ".names");
+
+    PageId header_id;
+    pool.pin_new(header_id);
+    pool.unpin(header_id);
+
+    // Order the items along the Hilbert curve
+    auto sorted = curve_order(items, [](const DataItem &item)
+                              { return item.bounds; });
+
+    // Each level is the list of (page, bounds) of its nodes
+    std::vector<std::pair<PageId, Rectangle>> level;
+    std::uint64_t name_offset = 0;
+    for (size_t begin = 0; begin < sorted.size() || level.empty(); begin += leaf_capacity)
+    {
+        size_t end = std::min(sorted.size(), begin + leaf_capacity);
+        PageId id;
+        char *page = pool.pin_new(id);
+        store<std::uint16_t>(page, 1);
+        store<std::uint16_t>(page + 2, static_cast<std::uint16_t>(end - begin));
+        Rectangle bounds = Rectangle::empty();
+        for (size_t k = begin; k < end; ++k)
+        {
+            const DataItem &item = items[sorted[k].second];
+            char *entry = page + node_header_size + (k - begin) * leaf_entry_size;
+            store_bounds(entry, item.bounds);
+            store<std::int64_t>(entry + bounds_size, item.population);
+            store<std::uint64_t>(entry + bounds_size + 8, name_offset);
+            store<std::int32_t>(entry + bounds_size + 16, item.id);
+            store<std::uint32_t>(entry + bounds_size + 20, static_cast<std::uint32_t>(item.name.size()));
+            names.write(item.name.data(), static_cast<std::streamsize>(item.name.size()));
+            name_offset += item.name.size();
+            bounds.expand(item.bounds);
+        }
+        pool.unpin(id, true);
+        level.emplace_back(id, bounds);
+    }
+
+    size_t height = 1;
+    while (level.size() > 1)
+    {
+        std::vector<std::pair<PageId, Rectangle>> parents;
+        for (size_t begin = 0; begin < level.size(); begin += child_capacity)
+        {
+            size_t end = std::min(level.size(), begin + child_capacity);
+            PageId id;
+            char *page = pool.pin_new(id);
+            store<std::uint16_t>(page, 0);
+            store<std::uint16_t>(page + 2, static_cast<std::uint16_t>(end - begin));
+            Rectangle bounds = Rectangle::empty();
+            for (size_t k = begin; k < end; ++k)
+            {
+                char *entry = page + node_header_size + (k - begin) * child_entry_size;
+                store_bounds(entry, level[k].second);
+                store<std::uint64_t>(entry + bounds_size, level[k].first);
+                bounds.expand(level[k].second);
+            }
+            pool.unpin(id, true);
+            parents.emplace_back(id, bounds);
+        }
+        level = std::move(parents);
+        ++height;
+    }
+
+    char *header = pool.pin(header_id);
+    std::memcpy(header, page_file_magic, sizeof(page_file_magic));
+    store<std::uint64_t>(header + 8, page_size);
+    store<std::uint64_t>(header + 16, level.front().first);
+    store<std::uint64_t>(header + 24, height);
+    store<std::uint64_t>(header + 32, items.size());
+    pool.unpin(header_id, true);
+    pool.flush();
+    names.flush();
+    if (!names)
+        throw std::runtime_error("Could not write names file: " + path + ".names");
+}
+
+// --- Paged R-Tree: Opening ---
+
+PagedRTree::PagedRTree(const std::string &path, size_t pool_pages, size_t async_io_threads)
+{
+    // The page size is in the header, which is needed before the file can be paged
+    char probe[16] = {};
+    std::ifstream header_file(path, std::ios::binary);
+    header_file.read(probe, sizeof(probe));
+    if (!header_file || std::memcmp(probe, page_file_magic, sizeof(page_file_magic)) != 0)
+        throw std::runtime_error("Not a paged R-Tree file: " + path);
+
+    const size_t page_size = load<std::uint64_t>(probe + 8);
+    if (page_size < min_page_size || page_size > max_page_size || (page_size & (page_size - 1)) != 0)
+        throw std::runtime_error("Corrupt paged R-Tree header");
+    file_ = std::make_unique<PageFile>(path, page_size, false);
+    pool_ = std::make_unique<BufferPool>(*file_, pool_pages);
+    if (async_io_threads > 0)
+        pool_->enable_async_reads(async_io_threads);
+    const char *header = pool_->pin(0);
+    root_ = load<std::uint64_t>(header + 16);
+    height_ = load<std::uint64_t>(header + 24);
+    item_count_ = load<std::uint64_t>(header + 32);
+    pool_->unpin(0);
+    if (root_ == 0 || root_ >= file_->page_count())
+        throw std::runtime_error("Corrupt paged R-Tree header");
+
+    names_fd_ = ::open((path + ".names").c_str(), O_RDONLY);
+    if (names_fd_ < 0)
+        throw std::runtime_error("Could not open names file: " + path + ".names");
+}
+
+PagedRTree::~PagedRTree()
+{
+    ::close(names_fd_);
+}
+
+// --- Paged R-Tree: Queries ---
+
+template <typename Visit>
+void PagedRTree::traverse(const Rectangle &query_rect, Visit &&visit)
+{
+    std::vector<PageId> pending{root_};
+    std::vector<PageId> children;
+    while (!pending.empty())
+    {
+        PageId id = pending.back();
+        pending.pop_back();
+        const char *page = pool_->pin(id);
+        const size_t entries = page_entries(page);
+        const size_t capacity = (page_size() - node_header_size) / (page_is_leaf(page) ? leaf_entry_size : child_entry_size);
+        if (entries > capacity)
+        {
+            pool_->unpin(id);
+            throw std::runtime_error("Corrupt paged R-Tree node");
+        }
+        if (page_is_leaf(page))
+        {
+            for (size_t i = 0; i < entries; ++i)
+            {
+                const char *entry = page + node_header_size + i * leaf_entry_size;
+                if (load_bounds(entry).intersects(query_rect))
+                    visit(entry);
+            }
+        }
+        else
+        {
+            children.clear();
+            for (size_t i = 0; i < entries; ++i)
+            {
+                const char *entry = page + node_header_size + i * child_entry_size;
+                if (!load_bounds(entry).intersects(query_rect))
+                    continue;
+                PageId child = load<std::uint64_t>(entry + bounds_size);
+                if (child == 0 || child >= page_count()) // Page 0 is the header
+                {
+                    pool_->unpin(id);
+                    throw std::runtime_error("Corrupt paged R-Tree node");
+                }
+                children.push_back(child);
+            }
+            // Reverse order keeps the depth-first visit in page order
+            pending.insert(pending.end(), children.rbegin(), children.rend());
+        }
+        pool_->unpin(id);
+
+        // Start reading all children at once; the first is needed right away,
+        // the others load while it (and its subtree) is being processed
+        if (children.size() > 1)
+            pool_->prefetch(children);
+        children.clear();
+    }
+}
+
+std::string PagedRTree::read_name(std::uint64_t offset, std::uint32_t size) const
+{
+    std::string name(size, '\0');
+    if (size > 0 && ::pread(names_fd_, name.data(), size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size))
+        throw std::runtime_error("Could not read item name");
+    return name;
+}
+
+std::vector<DataItem> PagedRTree::search_with_population(const Rectangle &query_rect, long min_population)
+{
+    std::vector<DataItem> results;
+    traverse(query_rect, [&](const char *entry)
+             {
+                 long population = static_cast<long>(load<std::int64_t>(entry + bounds_size));
+                 if (population < min_population)
+                     return;
+                 std::string name = read_name(load<std::uint64_t>(entry + bounds_size + 8), load<std::uint32_t>(entry + bounds_size + 20));
+                 results.emplace_back(load<std::int32_t>(entry + bounds_size + 16), std::move(name), population, load_bounds(entry)); });
+    return results;
+}
+
+std::vector<DataItem> PagedRTree::search(const Rectangle &query_rect)
+{
+    return search_with_population(query_rect, std::numeric_limits<long>::min());
+}
+
+size_t PagedRTree::count(const Rectangle &query_rect)
+{
+    size_t total = 0;
+    traverse(query_rect, [&](const char *)
+             { ++total; });
+    return total;
+}
@@ -0,0 +1,198 @@
+#ifndef PAGED_RTREE_H
+#define PAGED_RTREE_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>       // For page ids and on-disk fields
+#include <span>          // For the bulk-load input
+#include <unordered_map>      // Buffer pool page table
+#include <mutex>              // Guards completed asynchronous reads
+#include <condition_variable> // Signals completed asynchronous reads
+
+using PageId = std::uint64_t;
+
+class ThreadPoolPageReader; // async_io.h
+
+// --- Page File ---
+// A file of fixed-size pages addressed by PageId (page i starts at byte
+// i * page_size). Reads and writes are positioned, so no seek state is shared.
+class PageFile
+{
+public:
+    // Opens (or creates, if create is set) the file at path
+    PageFile(const std::string &path, size_t page_size, bool create);
+
+    PageFile(const PageFile &) = delete;
+    PageFile &operator=(const PageFile &) = delete;
+    ~PageFile();
+
+    void read(PageId id, char *page) const;
+    void write(PageId id, const char *page);
+
+    // Reserves a new page at the end of the file (written later)
+    PageId allocate() { return page_count_++; }
+
+    // Asks the OS to drop its cached copy of the file (for cold-cache measurements)
+    void drop_os_cache() const;
+
+    void sync();
+
+    size_t page_size() const { return page_size_; }
+    PageId page_count() const { return page_count_; }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    size_t page_size_;
+    PageId page_count_ = 0;
+};
+
+// --- Buffer Pool ---
+// Caches up to capacity pages of a PageFile in memory. Pages are pinned while
+// in use and can only be evicted when unpinned; victims are chosen by the
+// CLOCK algorithm (a second-chance approximation of LRU): each access sets a
+// frame's reference bit, and the clock hand clears reference bits until it
+// finds an unpinned frame whose bit is already clear. Dirty frames are
+// written back when evicted or flushed.
+//
+// With asynchronous reads enabled, prefetch() starts loading a batch of pages
+// in the background (see async_io.h). Loading frames hold a pin until their
+// read completes, and pinning a page that is still loading waits for it. At
+// most half the frames are used for outstanding prefetches. The pool itself
+// is still meant to be used from one thread.
+class BufferPool
+{
+public:
+    BufferPool(PageFile &file, size_t capacity);
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+    ~BufferPool(); // Writes back dirty pages
+
+    // Pins page id in memory and returns its contents. Throws if every frame is pinned.
+    char *pin(PageId id);
+
+    // Appends a zeroed page to the file and pins it
+    char *pin_new(PageId &id);
+
+    // Releases one pin; dirty marks the page as modified
+    void unpin(PageId id, bool dirty = false);
+
+    // Writes back every dirty page and fsyncs the file
+    void flush();
+
+    // Read pages in the background with the given number of I/O threads
+    void enable_async_reads(size_t threads);
+    bool async_reads() const { return reader_ != nullptr; }
+
+    // Starts reading the pages of ids that are not resident yet; returns immediately.
+    // A no-op unless asynchronous reads are enabled.
+    void prefetch(std::span<const PageId> ids);
+
+    size_t capacity() const { return frames_.size(); }
+    size_t reads() const { return reads_; }           // Pages loaded from disk
+    size_t hits() const { return hits_; }             // Pins served from memory
+    size_t prefetches() const { return prefetches_; } // Reads started by prefetch()
+    void reset_stats() { reads_ = hits_ = prefetches_ = 0; }
+
+private:
+    struct Frame
+    {
+        PageId id = 0;
+        int pin_count = 0;
+        bool used = false;
+        bool referenced = false;
+        bool dirty = false;
+        bool loading = false; // Asynchronous read in flight (holds a pin)
+    };
+
+    // Picks a frame to (re)use, writing back its old page if needed.
+    // Returns npos if every frame is pinned.
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    size_t try_victim();
+    size_t victim();
+
+    // Applies finished asynchronous reads: releases their pins and forgets failed pages
+    void reap();
+
+    // Blocks until at least one more asynchronous read has finished, then reaps
+    void wait_for_reads();
+    char *frame_data(size_t frame) { return memory_.data() + frame * file_.page_size(); }
+
+    PageFile &file_;
+    std::vector<char, CacheAlignedAllocator<char>> memory_;
+    std::vector<Frame> frames_;
+    std::unordered_map<PageId, size_t> page_table_;
+    size_t clock_hand_ = 0;
+    size_t reads_ = 0;
+    size_t hits_ = 0;
+    size_t prefetches_ = 0;
+
+    std::mutex io_mutex_;
+    std::condition_variable io_done_;
+    std::vector<std::pair<size_t, bool>> completed_; // (frame, ok), filled by I/O threads
+    size_t in_flight_ = 0;
+    std::unique_ptr<ThreadPoolPageReader> reader_; // Declared last: destroyed first
+};
+
+// --- Paged R-Tree ---
+// A disk-resident, read-only R-Tree: every node is one page of a page file
+// and children are referenced by PageId instead of pointers, so only the
+// pages a query visits are read (through the buffer pool). Page 0 is a header;
+// names are variable-length and live in a separate "<path>.names" file.
+//
+// Trees are created by build(), which packs the items bottom-up along the
+// Hilbert curve with every page full. Page sizes from 4 KiB to 16 KiB (powers
+// of two) are supported; an 8 KiB page holds 146 leaf or 204 child entries.
+//
+// With async_io_threads > 0, visiting an internal node prefetches all of its
+// qualifying children in one batch, so their reads overlap with each other
+// and with the descent into the first child.
+class PagedRTree
+{
+public:
+    static const size_t min_page_size = 4096;
+    static const size_t max_page_size = 16384;
+
+    // Write a packed tree of items to path (and path + ".names")
+    static void build(const std::string &path, std::span<const DataItem> items, size_t page_size = 8192);
+
+    // Open a built tree, caching at most pool_pages pages. async_io_threads = 0
+    // reads each page synchronously when it is first visited.
+    explicit PagedRTree(const std::string &path, size_t pool_pages = 1024, size_t async_io_threads = 4);
+
+    PagedRTree(const PagedRTree &) = delete;
+    PagedRTree &operator=(const PagedRTree &) = delete;
+    ~PagedRTree();
+
+    // Same queries as RTree. Queries read pages through the pool, so they are not const.
+    std::vector<DataItem> search(const Rectangle &query_rect);
+    std::vector<DataItem> search_with_population(const Rectangle &query_rect, long min_population);
+    size_t count(const Rectangle &query_rect);
+
+    size_t size() const { return item_count_; }
+    size_t height() const { return height_; }
+    size_t page_size() const { return file_->page_size(); }
+    PageId page_count() const { return file_->page_count(); }
+    BufferPool &pool() { return *pool_; }
+
+private:
+    // Visits every leaf entry intersecting query_rect; visit returns the
+    // position of the entry's fields in the pinned page
+    template <typename Visit>
+    void traverse(const Rectangle &query_rect, Visit &&visit);
+
+    std::string read_name(std::uint64_t offset, std::uint32_t size) const;
+
+    std::unique_ptr<PageFile> file_;
+    std::unique_ptr<BufferPool> pool_;
+    int names_fd_ = -1;
+    PageId root_ = 0;
+    size_t height_ = 0;
+    size_t item_count_ = 0;
+};
+
+#endif // PAGED_RTREE_H
@@ -0,0 +1,81 @@
+#include "query_index.h"
+
+#include <algorithm> // For std::sort
+#include <stdexcept> // For std::invalid_argument
+
+QueryIndex::QueryIndex(size_t min_entries, size_t max_entries)
+    : tree_(min_entries, max_entries)
+{
+}
+
+DataItem QueryIndex::entry(const Subscription &subscription)
+{
+    return DataItem(subscription.id, "", subscription.min_population, subscription.rect);
+}
+
+// --- Subscriptions ---
+
+void QueryIndex::add(const Subscription &subscription)
+{
+    add_batch(std::span<const Subscription>(&subscription, 1));
+}
+
+void QueryIndex::add_batch(std::span<const Subscription> subscriptions)
+{
+    std::vector<DataItem> entries;
+    entries.reserve(subscriptions.size());
+    for (const auto &subscription : subscriptions)
+    {
+        if (!subscriptions_.emplace(subscription.id, subscription).second)
+        {
+            // Roll back this batch so the index stays consistent
+            for (const auto &added : entries)
+                subscriptions_.erase(added.id);
+            throw std::invalid_argument("QueryIndex: subscription " + std::to_string(subscription.id) + " already exists");
+        }
+        entries.push_back(entry(subscription));
+    }
+    if (tree_.empty())
+        tree_.bulk_load(entries);
+    else
+        tree_.insert_batch(entries);
+    tree_.tighten(); // So concurrent match() calls never tighten
+}
+
+bool QueryIndex::remove(int subscription_id)
+{
+    auto it = subscriptions_.find(subscription_id);
+    if (it == subscriptions_.end())
+        return false;
+    tree_.remove(entry(it->second));
+    tree_.tighten();
+    subscriptions_.erase(it);
+    return true;
+}
+
+const Subscription *QueryIndex::find(int subscription_id) const
+{
+    auto it = subscriptions_.find(subscription_id);
+    return it == subscriptions_.end() ? nullptr : &it->second;
+}
+
+// --- Matching ---
+
+size_t QueryIndex::match(const DataItem &item, std::vector<int> &out) const
+{
+    size_t before = out.size();
+    // Entries carry the threshold in their population field
+    tree_.for_each_intersecting(item.bounds, [&](const DataItem &subscription)
+                                {
+                                    if (item.population >= subscription.population)
+                                        out.push_back(subscription.id); });
+    return out.size() - before;
+}
+
+std::vector<int> QueryIndex::match(const DataItem &item) const
+{
+    std::vector<int> ids;
+    match(item, ids);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
@@ -0,0 +1,65 @@
+#ifndef QUERY_INDEX_H
+#define QUERY_INDEX_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <span>
+#include <limits>        // For the "no population filter" default
+#include <unordered_map> // Subscriptions by id
+
+// --- Subscription ---
+// A registered query: matched by items intersecting rect with at least min_population
+struct Subscription
+{
+    int id;
+    Rectangle rect;
+    long min_population = std::numeric_limits<long>::min();
+
+    bool matches(const DataItem &item) const
+    {
+        return item.population >= min_population && item.bounds.intersects(rect);
+    }
+};
+
+// --- Reverse Query Index ---
+// The inverse of RTree::search: the query rectangles are indexed in their own
+// RTree (entry id = subscription id, population = threshold), and each
+// incoming item is matched against it, so the cost per item depends on the
+// number of rectangles near it rather than on the number of subscriptions.
+// Meant for geofencing and alerting on item streams. match() is const and
+// keeps no state, so concurrent matching is safe while nothing is added or removed.
+class QueryIndex
+{
+public:
+    explicit QueryIndex(size_t min_entries = 4, size_t max_entries = 16);
+
+    // Register a subscription. Throws std::invalid_argument if the id is taken.
+    void add(const Subscription &subscription);
+
+    // Register many subscriptions at once (packed with RTree::bulk_load when
+    // the index is empty)
+    void add_batch(std::span<const Subscription> subscriptions);
+
+    bool remove(int subscription_id);
+
+    // Registered subscription with the given id, or nullptr
+    const Subscription *find(int subscription_id) const;
+
+    // Ids of every subscription item satisfies, in ascending order
+    std::vector<int> match(const DataItem &item) const;
+
+    // Appends the matching ids (unsorted) to out and returns how many there
+    // were; reusing out avoids an allocation per item on hot streams
+    size_t match(const DataItem &item, std::vector<int> &out) const;
+
+    size_t size() const { return subscriptions_.size(); }
+
+private:
+    static DataItem entry(const Subscription &subscription);
+
+    RTree tree_;
+    std::unordered_map<int, Subscription> subscriptions_;
+};
+
+#endif // QUERY_INDEX_H
@@ -9,575 +9,1240 @@
 #include <algorithm> // For std::min, std::max, std::find_if, std::sort (potentially useful for better split)
 #include <stdexcept> // For std::invalid_argument, std::runtime_error
 #include <vector>
+#include <array>
 #include <memory>
 #include <iterator> // For std::make_move_iterator
 #include <utility>  // For std::move
+#include <unordered_set> // For counting nodes shared between versions
 
-// --- Rectangle Method Implementations ---
+// --- Output Helpers ---
 
-Rectangle::Rectangle() = default; // Use default implementation
+// Prints a rectangle as (min coords)-(max coords), e.g. (1,2)-(3,4) in 2D
+template <typename T, std::size_t D>
+static std::ostream &operator<<(std::ostream &os, const BasicRectangle<T, D> &rect)
+{
+    for (int corner = 0; corner < 2; ++corner)
+    {
+        const auto &p = corner == 0 ? rect.min_corner : rect.max_corner;
+        os << (corner == 0 ? "(" : ")-(");
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            os << (i ? "," : "") << p[i];
+        }
+    }
+    return os << ")";
+}
 
-Rectangle::Rectangle(Point min_c, Point max_c) : min_corner(min_c), max_corner(max_c) {}
+// --- Batch Kernel Helpers ---
 
-Rectangle::Rectangle(double min_x, double min_y, double max_x, double max_y)
-    : min_corner(min_x, min_y), max_corner(max_x, max_y) {}
+// Entries per batch kernel call; larger nodes are scanned in chunks
+static constexpr std::size_t kernel_chunk = 64;
 
-// Check if this rectangle intersects another rectangle
-bool Rectangle::intersects(const Rectangle &other) const
+// Calls on_match(i) for each i whose boxes[i] (or point) pred accepts. The
+// tests run first over a whole chunk through match_mask, so that loop stays
+// free of the data-dependent branches of the calls.
+template <typename Box, typename Pred, typename OnMatch>
+static void for_each_match(std::span<const Box> boxes, Pred &pred, OnMatch &&on_match)
 {
-    // Check for no overlap (the separating axis theorem)
-    if (max_corner.x < other.min_corner.x || min_corner.x > other.max_corner.x ||
-        max_corner.y < other.min_corner.y || min_corner.y > other.max_corner.y)
+    std::array<std::uint8_t, kernel_chunk> mask;
+    for (std::size_t begin = 0; begin < boxes.size(); begin += kernel_chunk)
     {
-        return false; // No intersection
+        std::span<const Box> chunk = boxes.subspan(begin, std::min(kernel_chunk, boxes.size() - begin));
+        if (match_mask(chunk, pred, mask) == 0)
+            continue;
+        for (std::size_t i = 0; i < chunk.size(); ++i)
+        {
+            if (mask[i])
+                on_match(begin + i);
+        }
     }
-    return true; // They overlap
 }
 
-// Expand this rectangle's MBR to minimally enclose another rectangle
-void Rectangle::expand(const Rectangle &other)
+// --- Traversal Stack ---
+
+// Fixed-size stack used by the traversal engine and for insertion descent paths.
+// The inline buffer covers depth x fan-out for any realistic tree; anything
+// beyond spills to the heap.
+template <typename V, std::size_t N>
+class TraversalStack
 {
-    // If the other rectangle is invalid, do nothing
-    if (other.min_corner.x > other.max_corner.x || other.min_corner.y > other.max_corner.y)
+public:
+    bool empty() const { return size_ == 0; }
+
+    void push(const V &value)
     {
-        return;
+        if (size_ < N)
+            inline_[size_] = value;
+        else
+            overflow_.push_back(value);
+        ++size_;
     }
-    // If this rectangle is currently invalid (e.g., default constructed), just become the other one
-    if (min_corner.x > max_corner.x || min_corner.y > max_corner.y)
+
+    const V &top() const { return size_ <= N ? inline_[size_ - 1] : overflow_.back(); }
+
+    V pop()
     {
-        *this = other;
-        return;
+        --size_;
+        if (size_ < N)
+            return inline_[size_];
+        V value = overflow_.back();
+        overflow_.pop_back();
+        return value;
     }
-    // Otherwise, expand bounds
-    min_corner.x = std::min(min_corner.x, other.min_corner.x);
-    min_corner.y = std::min(min_corner.y, other.min_corner.y);
-    max_corner.x = std::max(max_corner.x, other.max_corner.x);
-    max_corner.y = std::max(max_corner.y, other.max_corner.y);
-}
 
-// Calculate the minimal bounding rectangle enclosing two rectangles
-Rectangle Rectangle::combine(const Rectangle &r1, const Rectangle &r2)
-{
-    // Handle cases where one or both rectangles might be invalid
-    bool r1_invalid = r1.min_corner.x > r1.max_corner.x || r1.min_corner.y > r1.max_corner.y;
-    bool r2_invalid = r2.min_corner.x > r2.max_corner.x || r2.min_corner.y > r2.max_corner.y;
+private:
+    V inline_[N];
+    std::vector<V> overflow_;
+    std::size_t size_ = 0;
+};
 
-    if (r1_invalid && r2_invalid)
-        return Rectangle(); // Both invalid
-    if (r1_invalid)
-        return r2; // Only r1 invalid
-    if (r2_invalid)
-        return r1; // Only r2 invalid
+// --- RTreeNode Method Implementations ---
 
-    // Both are valid, combine them
-    return Rectangle(
-        std::min(r1.min_corner.x, r2.min_corner.x),
-        std::min(r1.min_corner.y, r2.min_corner.y),
-        std::max(r1.max_corner.x, r2.max_corner.x),
-        std::max(r1.max_corner.y, r2.max_corner.y));
+template <typename T, std::size_t D>
+BasicRTreeNode<T, D>::BasicRTreeNode(bool leaf) : is_leaf(leaf)
+{
+    // MBR starts as the empty box until updated
 }
 
-// Calculate the increase in area needed for this MBR to include another rectangle
-double Rectangle::area_increase(const Rectangle &other) const
+// Recalculate the MBR for this node based on its children or data entries
+// (an empty node gets the empty box)
+template <typename T, std::size_t D>
+void BasicRTreeNode<T, D>::update_mbr()
 {
-    // If the other rectangle is invalid, the increase is 0
-    if (other.min_corner.x > other.max_corner.x || other.min_corner.y > other.max_corner.y)
+    // entry_mbrs mirrors the children/items, so one contiguous pass suffices
+    mbr = combine_all(std::span<const rect_type>(entry_mbrs));
+    for (const auto &point : entry_points)
     {
-        return 0.0;
+        mbr.expand(rect_type(point, point));
     }
-    // If this rectangle is invalid, the increase is the area of the other rectangle
-    if (min_corner.x > max_corner.x || min_corner.y > max_corner.y)
+    for (const auto &item : buffer)
     {
-        return other.area();
+        mbr.expand(item.bounds);
     }
-    // Calculate the area of the combined rectangle
-    Rectangle combined = combine(*this, other);
-    // Increase is the combined area minus the current area
-    return combined.area() - this->area();
 }
 
-// --- RTreeNode Method Implementations ---
+// Check if the node has reached its maximum capacity
+template <typename T, std::size_t D>
+bool BasicRTreeNode<T, D>::is_full(size_t max_entries) const
+{
+    return size() >= max_entries;
+}
 
-RTreeNode::RTreeNode(bool leaf) : is_leaf(leaf), parent(nullptr)
+// Get the current number of entries (for leaf) or children (for internal)
+template <typename T, std::size_t D>
+size_t BasicRTreeNode<T, D>::size() const
 {
-    // MBR is default initialized (invalid state) until updated
+    return point_leaf ? entry_points.size() : entry_mbrs.size();
 }
 
-// Recalculate the MBR for this node based on its children or data entries
-void RTreeNode::update_mbr()
+// Append a child node, keeping entry_mbrs in step with children
+template <typename T, std::size_t D>
+void BasicRTreeNode<T, D>::add_child(NodePtr child)
+{
+    entry_mbrs.push_back(child->mbr);
+    children.push_back(std::move(child));
+}
+
+// Append a data item, keeping entry_mbrs (or entry_points) in step with data_entries
+template <typename T, std::size_t D>
+void BasicRTreeNode<T, D>::add_entry(const item_type &item)
 {
-    if (is_leaf)
+    if (point_leaf && item.bounds.is_point())
     {
-        if (data_entries.empty())
-        {
-            mbr = Rectangle(); // Reset MBR to invalid state for empty leaf
-            return;
-        }
-        // Calculate MBR from data entries
-        mbr = data_entries[0].bounds;
-        for (size_t i = 1; i < data_entries.size(); ++i)
-        {
-            mbr.expand(data_entries[i].bounds);
-        }
+        entry_points.push_back(item.bounds.min_corner);
     }
     else
-    { // Internal node
-        if (children.empty())
-        {
-            mbr = Rectangle(); // Reset MBR to invalid state for empty internal node
-            return;
-        }
-        // Calculate MBR from children's MBRs
-        // Ensure the first child exists before accessing its MBR
-        size_t first_valid_child = 0;
-        while (first_valid_child < children.size() && !children[first_valid_child])
-        {
-            first_valid_child++;
-        }
-
-        if (first_valid_child >= children.size())
-        { // No valid children found
-            mbr = Rectangle();
-            return;
-        }
-
-        mbr = children[first_valid_child]->mbr; // Start with the first valid child's MBR
-        for (size_t i = first_valid_child + 1; i < children.size(); ++i)
-        {
-            // Ensure child pointer and its MBR are valid before expanding
-            if (children[i])
-            { // Basic null check for child pointer
-                mbr.expand(children[i]->mbr);
-            }
-        }
+    {
+        unpack_points();
+        entry_mbrs.push_back(item.bounds);
     }
+    data_entries.push_back(item);
 }
 
-// Check if the node has reached its maximum capacity
-bool RTreeNode::is_full(size_t max_entries) const
+template <typename T, std::size_t D>
+void BasicRTreeNode<T, D>::remove_entry(size_t index)
 {
-    return size() >= max_entries;
+    if (point_leaf)
+        entry_points.erase(entry_points.begin() + index);
+    else
+        entry_mbrs.erase(entry_mbrs.begin() + index);
+    data_entries.erase(data_entries.begin() + index);
 }
 
-// Get the current number of entries (for leaf) or children (for internal)
-size_t RTreeNode::size() const
+template <typename T, std::size_t D>
+void BasicRTreeNode<T, D>::unpack_points()
 {
-    return is_leaf ? data_entries.size() : children.size();
+    if (!point_leaf)
+        return;
+    entry_mbrs.reserve(entry_points.size() + 1);
+    for (const auto &point : entry_points)
+    {
+        entry_mbrs.emplace_back(point, point);
+    }
+    entry_points = PointArray();
+    point_leaf = false;
 }
 
 // --- RTree Method Implementations ---
 
-RTree::RTree(size_t min_entries, size_t max_entries)
-    : min_entries_(std::max((size_t)2, min_entries)),                    // Ensure min is reasonable
-      max_entries_(std::max({(size_t)3, min_entries_ * 2, max_entries})) // Ensure max >= 3 and >= 2*min
+template <typename T, std::size_t D>
+BasicRTree<T, D>::BasicRTree(size_t min_entries, size_t max_entries)
+    : BasicRTree(FanOut{min_entries, max_entries, min_entries, max_entries})
 {
-    // Optional: Add warning if min > max/2, as it affects some split algorithms
-    if (min_entries_ > max_entries_ / 2 && min_entries_ != 2)
-    {
-        // Use std::cerr for warnings/errors now that <iostream> is included
-        std::cerr << "Warning: RTree Min entries (" << min_entries_
-                  << ") > Max entries (" << max_entries_
-                  << ") / 2. This might affect performance with certain split heuristics.\n";
-    }
-    // Start with an empty leaf node as the root
-    root_ = std::make_unique<RTreeNode>(true); // Requires C++14 or later
+}
+
+template <typename T, std::size_t D>
+BasicRTree<T, D>::BasicRTree(const FanOut &fan_out)
+{
+    set_fan_out(fan_out);
+}
+
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::set_fan_out(const FanOut &fan_out)
+{
+    // Ensure min >= 2, max >= 3 and max >= 2*min for both node kinds
+    min_entries_ = std::max((size_t)2, fan_out.min_entries);
+    max_entries_ = std::max({(size_t)3, min_entries_ * 2, fan_out.max_entries});
+    min_leaf_entries_ = std::max((size_t)2, fan_out.min_leaf_entries);
+    max_leaf_entries_ = std::max({(size_t)3, min_leaf_entries_ * 2, fan_out.max_leaf_entries});
+
+    // Re-pack whatever is stored under the new capacities
+    std::vector<item_type> items;
+    if (root_)
+        collect_items(root_, items);
+    bulk_load(items);
 }
 
 // Insert a DataItem into the R-Tree
-void RTree::insert(const DataItem &item)
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::insert(const item_type &item)
 {
     if (!root_)
     { // Should not happen with current constructor, but defensive check
-        root_ = std::make_unique<RTreeNode>(true);
+        root_ = std::make_shared<Node>(true);
     }
-    // Start recursive insertion from the root
-    NodePtr split_node = insert_recursive(root_.get(), item);
+
+    // Buffered mode: park the item at the root until its buffer fills up
+    if (buffer_capacity_ > 0 && !root_->is_leaf)
+    {
+        Node *root = writable(root_);
+        root->mbr.expand(item.bounds);
+        root->dirty = true;
+        root->buffer.push_back(item);
+        root->buffered = true;
+        if (root->buffer.size() >= buffer_capacity_)
+        {
+            grow_root(empty_buffer(root));
+        }
+        return;
+    }
+
+    // Descend to a leaf, recording the path instead of relying on parent links.
+    // Node MBRs are not recomputed here: every node on the path is marked dirty
+    // and tightened later. Only the entry box just read by choose_subtree (already
+    // in cache) and the root MBR are grown, so they stay conservative and later
+    // inserts still choose subtrees well before the next tighten. Nodes shared
+    // with a committed version are copied on the way down (see writable).
+    TraversalStack<PathStep, 32> path;
+    Node *node = writable(root_);
+    node->mbr.expand(item.bounds);
+    node->dirty = true;
+    while (!node->is_leaf)
+    {
+        size_t child_index = choose_subtree(node, item.bounds);
+        node->entry_mbrs[child_index].expand(item.bounds);
+        path.push({node, child_index});
+        node = writable(node->children[child_index]);
+        node->dirty = true;
+    }
+
+    // Add the data item to the leaf node, then fix up the path
+    node->add_entry(item);
+    NodePtr split_node = propagate_up(path, node);
 
     // Check if the root node was split during insertion
     if (split_node)
     {
-        // Create a new root node (which will be an internal node)
-        auto new_root = std::make_unique<RTreeNode>(false); // New root is internal
+        std::vector<NodePtr> siblings;
+        siblings.push_back(std::move(split_node));
+        grow_root(std::move(siblings));
+    }
+}
 
-        // Set parent pointers of the old root and the new node from the split
-        root_->parent = new_root.get();
-        split_node->parent = new_root.get();
+// Insert a batch of DataItems, sharing descents between neighbouring items
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::insert_batch(std::span<const item_type> items)
+{
+    if (items.empty())
+        return;
+    if (!root_)
+    { // Should not happen with current constructor, but defensive check
+        root_ = std::make_shared<Node>(true);
+    }
 
-        // Calculate the MBR for the new root based on its two children
-        new_root->mbr = Rectangle::combine(root_->mbr, split_node->mbr);
+    // Buffered mode: the whole batch joins the root buffer
+    Node *root = writable(root_);
+    if (buffer_capacity_ > 0 && !root->is_leaf)
+    {
+        for (const auto &item : items)
+        {
+            root->mbr.expand(item.bounds);
+            root->buffer.push_back(item);
+        }
+        root->buffered = true;
+        root->dirty = true;
+        if (root->buffer.size() >= buffer_capacity_)
+        {
+            grow_root(empty_buffer(root));
+        }
+        return;
+    }
 
-        // Add the old root and the new node as children of the new root
-        new_root->children.push_back(std::move(root_));
-        new_root->children.push_back(std::move(split_node));
+    // Sort the batch along the Hilbert curve, so items that end up in the same
+    // subtree are adjacent when routed
+    std::vector<const item_type *> sorted = sort_by_curve(items);
 
-        // Update the tree's root pointer
-        root_ = std::move(new_root);
+    // Root MBR is kept conservative eagerly (see insert)
+    for (const item_type *item : sorted)
+    {
+        root->mbr.expand(item->bounds);
     }
+    grow_root(insert_batch_into(root, sorted));
 }
 
-// Public search method: Find items intersecting a query rectangle
-std::vector<DataItem> RTree::search(const Rectangle &query_rect) const
+// Remove a stored item, condensing the tree along its path
+template <typename T, std::size_t D>
+bool BasicRTree<T, D>::remove(const item_type &item)
 {
-    std::vector<DataItem> results;
-    if (root_ && root_->mbr.intersects(query_rect))
-    { // Check intersection with root MBR first
-        search_recursive(root_.get(), query_rect, results);
+    if (!root_)
+        return false;
+
+    std::vector<PathStep> path;
+    if (!find_item(root_.get(), item, path))
+        return false;
+
+    // Replay the path on private copies of any nodes shared with a version
+    Node *node = writable(root_);
+    for (auto &step : path)
+    {
+        step.node = node;
+        node = writable(node->children[step.child_index]);
+    }
+
+    // Take the item out of the node that holds it
+    auto matches = [&](const item_type &candidate)
+    { return candidate.id == item.id; };
+    auto buffered = std::find_if(node->buffer.begin(), node->buffer.end(), matches);
+    if (buffered != node->buffer.end())
+    {
+        node->buffer.erase(buffered);
+        node->buffered = !node->buffer.empty();
     }
+    else
+    {
+        auto entry = std::find_if(node->data_entries.begin(), node->data_entries.end(), matches);
+        node->remove_entry(entry - node->data_entries.begin());
+    }
+    node->dirty = true;
+
+    // Condense: walk the path back up, dissolving underfull nodes. Their items
+    // are reinserted below, which keeps every other node at least min_entries full.
+    std::vector<item_type> orphans;
+    for (size_t k = path.size(); k-- > 0;)
+    {
+        Node *parent = path[k].node;
+        size_t index = path[k].child_index;
+        parent->dirty = true;
+        if (parent->children[index]->size() < min_entries_for(parent->children[index].get()))
+        {
+            collect_items(parent->children[index], orphans);
+            parent->children.erase(parent->children.begin() + index);
+            parent->entry_mbrs.erase(parent->entry_mbrs.begin() + index);
+        }
+    }
+
+    // Shorten the tree while the root has a single child
+    while (!root_->is_leaf && root_->children.size() == 1 && root_->buffer.empty())
+    {
+        NodePtr only_child = std::move(root_->children.front());
+        root_ = std::move(only_child);
+    }
+    if (!root_->is_leaf && root_->children.empty())
+    {
+        collect_items(root_, orphans);
+        root_ = std::make_shared<Node>(true);
+    }
+
+    insert_batch(orphans);
+    return true;
+}
+
+// Replace the contents with a packed tree
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::bulk_load(std::span<const item_type> items)
+{
+    root_ = std::make_shared<Node>(true);
+    if (items.empty())
+        return;
+
+    // Nodes count as full at their maximum, so pack one below that
+    const size_t leaf_capacity = max_leaf_entries_ - 1, internal_capacity = max_entries_ - 1;
+
+    // Number of nodes needed for count entries, and the share of node i (evenly spread)
+    auto node_count = [](size_t count, size_t capacity)
+    { return (count + capacity - 1) / capacity; };
+    auto share_begin = [](size_t i, size_t count, size_t nodes)
+    { return i * count / nodes; };
+
+    // Leaves from the curve-sorted items
+    std::vector<const item_type *> sorted = sort_by_curve(items);
+    std::vector<NodePtr> level;
+    size_t leaves = node_count(sorted.size(), leaf_capacity);
+    for (size_t i = 0; i < leaves; ++i)
+    {
+        auto leaf = std::make_shared<Node>(true);
+        size_t begin = share_begin(i, sorted.size(), leaves), end = share_begin(i + 1, sorted.size(), leaves);
+        leaf->point_leaf = std::all_of(sorted.begin() + begin, sorted.begin() + end, [](const item_type *item)
+                                       { return item->bounds.is_point(); });
+        if (leaf->point_leaf)
+            leaf->entry_points.reserve(end - begin);
+        else
+            leaf->entry_mbrs.reserve(end - begin);
+        leaf->data_entries.reserve(end - begin);
+        for (size_t k = begin; k < end; ++k)
+        {
+            leaf->add_entry(*sorted[k]);
+        }
+        leaf->update_mbr();
+        level.push_back(std::move(leaf));
+    }
+
+    // Internal levels: consecutive nodes along the curve share a parent
+    while (level.size() > 1)
+    {
+        std::vector<NodePtr> parents;
+        size_t parent_count = node_count(level.size(), internal_capacity);
+        for (size_t i = 0; i < parent_count; ++i)
+        {
+            auto parent = std::make_shared<Node>(false);
+            size_t begin = share_begin(i, level.size(), parent_count), end = share_begin(i + 1, level.size(), parent_count);
+            parent->entry_mbrs.reserve(end - begin);
+            parent->children.reserve(end - begin);
+            for (size_t k = begin; k < end; ++k)
+            {
+                parent->add_child(std::move(level[k]));
+            }
+            parent->update_mbr();
+            parents.push_back(std::move(parent));
+        }
+        level = std::move(parents);
+    }
+    root_ = std::move(level.front());
+}
+
+// Count stored items by walking every node
+template <typename T, std::size_t D>
+size_t BasicRTree<T, D>::size() const
+{
+    size_t total = 0;
+    walk([](const rect_type &)
+         { return true; },
+         [&](const Node *node, int)
+         { total += node->data_entries.size() + node->buffer.size(); });
+    return total;
+}
+
+// Switch between buffered and direct inserts
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::set_insert_buffering(size_t buffer_capacity)
+{
+    if (buffer_capacity == 0)
+    {
+        flush_buffers(); // Direct inserts never look at buffers, so none may remain
+    }
+    buffer_capacity_ = buffer_capacity;
+}
+
+// Push every buffered item down to the leaves
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::flush_buffers()
+{
+    std::vector<item_type> pending;
+    if (!root_ || !collect_buffers(root_, pending))
+        return;
+
+    // Removing items from buffers leaves ancestor MBRs conservative (and dirty),
+    // so the collected items can simply be re-inserted as one direct batch
+    size_t capacity = buffer_capacity_;
+    buffer_capacity_ = 0;
+    insert_batch(pending);
+    buffer_capacity_ = capacity;
+}
+
+// Public search method: Find items intersecting a query rectangle
+template <typename T, std::size_t D>
+std::vector<typename BasicRTree<T, D>::item_type> BasicRTree<T, D>::search(const rect_type &query_rect) const
+{
+    std::vector<item_type> results;
+    auto overlaps = [&](const rect_type &box)
+    { return box.intersects(query_rect); };
+    auto inside = [&](const point_type &point)
+    { return query_rect.contains(point); };
+    traverse(overlaps, overlaps, inside, [&](const item_type &item)
+             { results.push_back(item); });
     return results;
 }
 
 // Public search method: Find items intersecting query_rect with minimum population
-std::vector<DataItem> RTree::search_with_population(const Rectangle &query_rect, long min_population) const
+template <typename T, std::size_t D>
+std::vector<typename BasicRTree<T, D>::item_type> BasicRTree<T, D>::search_with_population(const rect_type &query_rect, long min_population) const
 {
-    std::vector<DataItem> results;
-    if (root_ && root_->mbr.intersects(query_rect))
-    { // Check intersection with root MBR first
-        search_pop_recursive(root_.get(), query_rect, min_population, results);
-    }
+    std::vector<item_type> results;
+    // Internal nodes don't store population, so only the MBR prunes subtrees
+    auto overlaps = [&](const rect_type &box)
+    { return box.intersects(query_rect); };
+    auto inside = [&](const point_type &point)
+    { return query_rect.contains(point); };
+    traverse(overlaps, overlaps, inside, [&](const item_type &item)
+             {
+                 if (item.population >= min_population)
+                     results.push_back(item); });
+    return results;
+}
+
+// Public search method: Find items lying entirely inside query_rect
+template <typename T, std::size_t D>
+std::vector<typename BasicRTree<T, D>::item_type> BasicRTree<T, D>::search_contained(const rect_type &query_rect) const
+{
+    std::vector<item_type> results;
+    traverse([&](const rect_type &mbr)
+             { return mbr.intersects(query_rect); },
+             [&](const rect_type &box)
+             { return query_rect.contains(box); },
+             [&](const point_type &point)
+             { return query_rect.contains(point); },
+             [&](const item_type &item)
+             { results.push_back(item); });
     return results;
 }
 
+// Public count method: Number of items intersecting query_rect
+template <typename T, std::size_t D>
+size_t BasicRTree<T, D>::count(const rect_type &query_rect) const
+{
+    size_t matches = 0;
+    auto overlaps = [&](const rect_type &box)
+    { return box.intersects(query_rect); };
+    auto inside = [&](const point_type &point)
+    { return query_rect.contains(point); };
+    traverse(overlaps, overlaps, inside, [&](const item_type &)
+             { ++matches; });
+    return matches;
+}
+
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::for_each_intersecting(const rect_type &query_rect, const std::function<void(const item_type &)> &visit) const
+{
+    auto overlaps = [&](const rect_type &box)
+    { return box.intersects(query_rect); };
+    auto inside = [&](const point_type &point)
+    { return query_rect.contains(point); };
+    traverse(overlaps, overlaps, inside, visit);
+}
+
 // Print the tree structure to an output stream (e.g., std::cout)
-void RTree::print_structure(std::ostream &os) const
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::print_structure(std::ostream &os) const
 {
-    // Now uses 'os' parameter correctly
     os << "--- R-Tree Structure ---\n";
-    if (!root_ || (root_->is_leaf && root_->data_entries.empty() && root_->children.empty()))
+    if (empty())
     {
         os << "(Empty Tree)\n";
     }
     else
     {
-        print_node(os, root_.get(), 0);
+        walk([](const rect_type &)
+             { return true; },
+             [&](const Node *node, int depth)
+             {
+                 std::string indent_str(depth * 2, ' '); // Create indentation string
+
+                 // Print node type, memory address (for debugging splits), MBR, and size
+                 os << indent_str << "[" << (node->is_leaf ? "LEAF" : "INTERNAL")
+                    << " @ " << static_cast<const void *>(node) // Print node address safely
+                    << "] MBR: " << node->mbr << " "
+                    << "Size: " << node->size() << "\n";
+
+                 // Leaf node: Print details of each data item (children are visited by walk)
+                 for (const auto &item : node->data_entries)
+                 {
+                     os << indent_str << "  - Item ID: " << item.id << ", Name: " << item.name
+                        << ", Pop: " << item.population << ", Bounds: " << item.bounds << "\n";
+                 }
+                 // Internal node: Print items waiting in its insert buffer
+                 for (const auto &item : node->buffer)
+                 {
+                     os << indent_str << "  ~ Buffered ID: " << item.id << ", Name: " << item.name
+                        << ", Pop: " << item.population << ", Bounds: " << item.bounds << "\n";
+                 }
+             });
     }
     os << "------------------------\n";
 }
 
 // Check if the tree is empty
-bool RTree::empty() const
+template <typename T, std::size_t D>
+bool BasicRTree<T, D>::empty() const
 {
     return !root_ || root_->size() == 0;
 }
 
-// --- RTree Private Helper Method Implementations ---
-
-// Choose the best subtree to insert into (minimizes MBR area increase)
-RTreeNode *RTree::choose_subtree(RTreeNode *node, const Rectangle &item_bounds) const
+// Recompute every stale MBR (see tighten_node)
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::tighten() const
 {
-    // Precondition: node is guaranteed to be an internal node.
-    if (node->children.empty())
+    if (root_ && root_->dirty)
     {
-        // This indicates an error state (internal node with no children)
-        throw std::runtime_error("Internal RTree node has no children during choose_subtree.");
+        tighten_node(root_.get());
     }
+}
 
-    RTreeNode *best_child = nullptr;
-    double min_increase = std::numeric_limits<double>::max();
-    double min_area = std::numeric_limits<double>::max();
+// --- Versions ---
 
-    // Iterate through the children of the current node
-    for (auto &child_ptr : node->children)
+// Freeze the current contents. Committed nodes are never modified again (they
+// are copied first), so they are tightened once here and stay clean.
+template <typename T, std::size_t D>
+std::uint64_t BasicRTree<T, D>::commit_version()
+{
+    tighten();
+    std::uint64_t version = ++last_version_;
+    versions_.emplace(version, root_);
+    set_version_retention(version_retention_);
+    return version;
+}
+
+// Drop the oldest versions beyond the limit (0 keeps every version)
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::set_version_retention(size_t versions)
+{
+    version_retention_ = versions;
+    while (version_retention_ > 0 && versions_.size() > version_retention_)
     {
-        if (!child_ptr)
-            continue; // Safety check for null pointers
+        versions_.erase(versions_.begin()); // Frees the nodes only this version used
+    }
+}
 
-        double current_area = child_ptr->mbr.area();
-        // Calculate how much the child's MBR would need to increase to include the new item
-        double increase = child_ptr->mbr.area_increase(item_bounds);
+template <typename T, std::size_t D>
+bool BasicRTree<T, D>::release_version(std::uint64_t version)
+{
+    return versions_.erase(version) != 0;
+}
 
-        // Primary criterion: Choose the child requiring the minimum area increase
-        if (increase < min_increase)
-        {
-            min_increase = increase;
-            min_area = current_area; // Store area for tie-breaking
-            best_child = child_ptr.get();
-        }
-        // Tie-breaking criterion: If increases are equal, choose the child with the smallest current MBR area
-        else if (increase == min_increase)
-        {
-            // Ensure best_child is not null before comparing areas
-            if (best_child == nullptr || current_area < min_area)
-            {
-                min_area = current_area;
-                best_child = child_ptr.get();
-            }
-        }
-    }
+template <typename T, std::size_t D>
+std::vector<typename BasicRTree<T, D>::item_type> BasicRTree<T, D>::search(const rect_type &query_rect, std::uint64_t version) const
+{
+    std::vector<item_type> results;
+    auto overlaps = [&](const rect_type &box)
+    { return box.intersects(query_rect); };
+    auto inside = [&](const point_type &point)
+    { return query_rect.contains(point); };
+    traverse(overlaps, overlaps, inside, [&](const item_type &item)
+             { results.push_back(item); },
+             version_root(version));
+    return results;
+}
 
-    // Fallback: If all children resulted in the same (possibly max) increase,
-    // or if only one child existed, best_child might still be null after the loop.
-    // Choose the first valid child in such cases.
-    if (!best_child)
-    {
-        for (auto &child_ptr : node->children)
-        {
-            if (child_ptr)
-            {
-                best_child = child_ptr.get();
-                break;
-            }
-        }
-    }
+template <typename T, std::size_t D>
+size_t BasicRTree<T, D>::count(const rect_type &query_rect, std::uint64_t version) const
+{
+    size_t matches = 0;
+    auto overlaps = [&](const rect_type &box)
+    { return box.intersects(query_rect); };
+    auto inside = [&](const point_type &point)
+    { return query_rect.contains(point); };
+    traverse(overlaps, overlaps, inside, [&](const item_type &)
+             { ++matches; },
+             version_root(version));
+    return matches;
+}
 
-    // If still no best child found (e.g., all children were nullptrs), it's an error
-    if (!best_child)
+// Count each node once, however many versions share it
+template <typename T, std::size_t D>
+size_t BasicRTree<T, D>::retained_node_count() const
+{
+    std::unordered_set<const Node *> nodes;
+    auto everything = [](const rect_type &)
+    { return true; };
+    auto record = [&](const Node *node, int)
+    { nodes.insert(node); };
+    walk(everything, record);
+    for (const auto &[version, root] : versions_)
     {
-        throw std::runtime_error("Failed to find any valid child node in choose_subtree.");
+        walk(everything, record, root.get());
     }
+    return nodes.size();
+}
 
-    return best_child;
+template <typename T, std::size_t D>
+size_t BasicRTree<T, D>::point_leaf_count() const
+{
+    size_t leaves = 0;
+    walk([](const rect_type &)
+         { return true; },
+         [&](const Node *node, int)
+         { leaves += node->point_leaf; });
+    return leaves;
 }
 
-// Recursive helper function for inserting a DataItem
-RTree::NodePtr RTree::insert_recursive(RTreeNode *node, const DataItem &item)
+// --- Traversal Engine ---
+
+template <typename T, std::size_t D>
+template <typename NodePred, typename NodeVisitor>
+void BasicRTree<T, D>::walk(NodePred &&node_pred, NodeVisitor &&visit_node, const Node *root) const
 {
-    // Expand the node's MBR on the way down *before* choosing a subtree or inserting
-    // This ensures parent MBRs always contain their children/entries.
-    node->mbr.expand(item.bounds);
+    if (!root)
+    {
+        tighten(); // First read after modifications pays for the deferred MBR work
+        root = root_.get();
+    }
+    if (!root || !node_pred(root->mbr))
+        return;
 
-    if (node->is_leaf)
+    struct Frame
+    {
+        const Node *node;
+        int depth;
+    };
+    TraversalStack<Frame, 64> stack;
+    std::vector<const Node *> qualifying; // Reused per node to avoid reallocations
+    qualifying.reserve(max_entries_);
+    stack.push({root, 0});
+
+    while (!stack.empty())
     {
-        // Add the data item to the leaf node
-        node->data_entries.push_back(item);
-        // MBR was already expanded. Check if the node is now full.
-        if (node->is_full(max_entries_))
+        Frame frame = stack.pop();
+
+        // The next node's header was prefetched when it was pushed; start loading
+        // its entry array now, so that overlaps with the scan of this node
+        if (prefetch_distance_ > 0 && !stack.empty())
         {
-            // Split the node and return the new node resulting from the split
-            return split_node(node);
+            const Node *next = stack.top().node;
+            RTREE_PREFETCH(next->point_leaf ? static_cast<const void *>(next->entry_points.data())
+                                            : static_cast<const void *>(next->entry_mbrs.data()));
         }
-        // Node is not full, no split occurred
-        return nullptr;
-    }
-    else
-    { // Internal node
-        // Choose the best child node to descend into
-        RTreeNode *subtree_to_insert = choose_subtree(node, item.bounds);
+        visit_node(frame.node, frame.depth);
+        if (frame.node->is_leaf)
+            continue;
 
-        // Recursively insert the item into the chosen subtree
-        NodePtr potential_split_node = insert_recursive(subtree_to_insert, item);
+        // Collect all qualifying children first ...
+        qualifying.clear();
+        for_each_match(std::span<const rect_type>(frame.node->entry_mbrs), node_pred, [&](size_t i)
+                       { qualifying.push_back(frame.node->children[i].get()); });
 
-        // Check if the recursive call resulted in a split of the child node
-        if (potential_split_node)
+        // ... start loading the headers of the ones visited next (one cache line each) ...
+        size_t prefetch_count = std::min(prefetch_distance_, qualifying.size());
+        for (size_t i = 0; i < prefetch_count; ++i)
         {
-            // A split occurred below. Add the new node (returned by the recursive call)
-            // as a child of the *current* node.
-            potential_split_node->parent = node; // Set parent pointer of the new node
-            node->children.push_back(std::move(potential_split_node));
+            RTREE_PREFETCH(qualifying[i]);
+        }
 
-            // MBR was already expanded at the start. Check if the *current* node is now full.
-            if (node->is_full(max_entries_))
-            {
-                // Split the current node and propagate the split upwards
-                return split_node(node);
-            }
+        // ... then push them in reverse so they are visited in order
+        for (size_t i = qualifying.size(); i-- > 0;)
+        {
+            stack.push({qualifying[i], frame.depth + 1});
         }
-        // No split occurred below, or if it did, the current node didn't become full.
-        return nullptr; // No split needs to be propagated upwards from this node.
     }
 }
 
-// Splits a full node (either leaf or internal) into two nodes.
-// Returns a unique_ptr to the newly created node.
-// Modifies the original node ('node') to contain the first half of the entries/children.
-// Note: This uses a very simple linear split (dividing items in half).
-//       Real R-Trees use more sophisticated algorithms (Linear, Quadratic, R*)
-//       to minimize overlap and area for better query performance. This is a placeholder.
-RTree::NodePtr RTree::split_node(RTreeNode *node)
+template <typename T, std::size_t D>
+template <typename NodePred, typename LeafPred, typename PointPred, typename Visitor>
+void BasicRTree<T, D>::traverse(NodePred &&node_pred, LeafPred &&leaf_pred, PointPred &&point_pred, Visitor &&visit, const Node *root) const
 {
-    size_t total_size = node->size();
+    walk(node_pred, [&](const Node *node, int)
+         {
+             // Items still buffered on an internal node (buffered insert mode);
+             // the flag keeps the cold buffer vector out of the common path
+             if (node->buffered)
+             {
+                 for (const auto &item : node->buffer)
+                 {
+                     if (leaf_pred(item.bounds))
+                     {
+                         visit(item);
+                     }
+                 }
+             }
 
-    // Determine the split point. Aim for roughly half, but respect min_entries_.
-    // This simple split doesn't guarantee min_entries_ for both resulting nodes,
-    // which is a limitation compared to proper R-Tree split algorithms.
-    size_t split_index = std::max(min_entries_, total_size / 2);
-    // Ensure the original node keeps at least min_entries_ if possible
-    // and the new node also gets at least min_entries_ if total_size allows
-    if (total_size > min_entries_ * 2)
-    { // Only adjust if there's enough to satisfy min on both sides
-        if (total_size - split_index < min_entries_)
-        {
-            split_index = total_size - min_entries_;
-        }
-        if (split_index < min_entries_)
-        { // Ensure original node keeps min_entries_
-            split_index = min_entries_;
-        }
-    }
-    else
-    {                                       // Not enough items to guarantee min_entries on both, just split near middle
-        split_index = (total_size + 1) / 2; // Ensure first node gets slightly more if odd
+             // Scan the contiguous entry MBRs (or points); item payloads are only touched on a hit
+             auto visit_entry = [&](size_t i)
+             { visit(node->data_entries[i]); };
+             if (node->point_leaf)
+             {
+                 for_each_match(std::span<const point_type>(node->entry_points), point_pred, visit_entry);
+                 return;
+             }
+             for_each_match(std::span<const rect_type>(node->entry_mbrs).first(node->data_entries.size()), leaf_pred, visit_entry); },
+         root);
+}
+
+// --- RTree Private Helper Method Implementations ---
+
+// Copy-on-write: the live tree owns a node exclusively unless a committed
+// version (or a copied parent) also points to it. Copying the node copies its
+// child pointers, so the subtrees below stay shared until they are written.
+template <typename T, std::size_t D>
+typename BasicRTree<T, D>::Node *BasicRTree<T, D>::writable(NodePtr &slot)
+{
+    if (slot.use_count() > 1)
+    {
+        slot = std::make_shared<Node>(*slot);
     }
+    return slot.get();
+}
 
-    // Clamp split_index to valid range [1, total_size - 1] if possible
-    split_index = std::max((size_t)1, std::min(split_index, total_size > 1 ? total_size - 1 : 1));
+template <typename T, std::size_t D>
+const typename BasicRTree<T, D>::Node *BasicRTree<T, D>::version_root(std::uint64_t version) const
+{
+    auto it = versions_.find(version);
+    if (it == versions_.end())
+    {
+        throw std::out_of_range("RTree version " + std::to_string(version) + " is not retained");
+    }
+    return it->second.get();
+}
 
-    // Create the new sibling node (same type: leaf or internal)
-    auto new_node = std::make_unique<RTreeNode>(node->is_leaf);
-    new_node->parent = node->parent; // Initially shares the same parent
+// Route a curve-sorted slice of a batch below node
+template <typename T, std::size_t D>
+std::vector<typename BasicRTree<T, D>::NodePtr> BasicRTree<T, D>::insert_batch_into(Node *node, std::span<const item_type *const> items)
+{
+    node->dirty = true;
 
     if (node->is_leaf)
     {
-        // Move the second half of data entries to the new node
-        if (split_index < node->data_entries.size())
-        {
-            new_node->data_entries.assign(
-                std::make_move_iterator(node->data_entries.begin() + split_index),
-                std::make_move_iterator(node->data_entries.end()));
-            // Erase the moved entries from the original node
-            node->data_entries.erase(node->data_entries.begin() + split_index, node->data_entries.end());
-        }
-        else if (!node->data_entries.empty() && split_index == node->data_entries.size())
+        // Append the leaf's whole share first, then split as often as needed
+        for (const item_type *item : items)
         {
-            // Edge case: trying to move 0 elements when split_index == size
-            // This might happen if logic results in split_index being size, just means new node is empty initially.
+            node->add_entry(*item);
         }
-        else if (!node->data_entries.empty())
+        return split_until_fits(node);
+    }
+
+    // Partition the items among the children in one pass. Neighbouring items
+    // usually go to the same child, so an item that the previously chosen
+    // child already covers reuses that choice without rescanning the children.
+    const size_t child_count = node->children.size();
+    std::vector<std::uint32_t> choice(items.size());
+    std::vector<size_t> bucket_start(child_count + 1, 0);
+    size_t last_choice = child_count;
+    for (size_t k = 0; k < items.size(); ++k)
+    {
+        const item_type *item = items[k];
+        size_t child_index = last_choice;
+        if (child_index == child_count || !node->entry_mbrs[child_index].contains(item->bounds))
         {
-            std::cerr << "Warning: Split index issue during leaf node split. Size: " << total_size << ", Index: " << split_index << std::endl;
+            child_index = choose_subtree(node, item->bounds);
         }
+        node->entry_mbrs[child_index].expand(item->bounds); // Conservative until tightened
+        choice[k] = static_cast<std::uint32_t>(child_index);
+        ++bucket_start[child_index + 1];
+        last_choice = child_index;
     }
-    else
-    {   // Internal node
-        // Move the second half of child pointers to the new node
-        if (split_index < node->children.size())
+
+    // Counting sort into one contiguous buffer (stable, so curve order is kept)
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        bucket_start[i + 1] += bucket_start[i];
+    }
+    std::vector<const item_type *> routed(items.size());
+    std::vector<size_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+    for (size_t k = 0; k < items.size(); ++k)
+    {
+        routed[fill[choice[k]]++] = items[k];
+    }
+
+    // Descend once per child, absorbing any nodes split off below
+    std::span<const item_type *const> all_routed(routed);
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        size_t share = bucket_start[i + 1] - bucket_start[i];
+        if (share == 0)
+            continue;
+        Node *child = writable(node->children[i]);
+        auto child_share = all_routed.subspan(bucket_start[i], share);
+        std::vector<NodePtr> split_off;
+        if (buffer_capacity_ > 0 && !child->is_leaf)
         {
-            new_node->children.assign(
-                std::make_move_iterator(node->children.begin() + split_index),
-                std::make_move_iterator(node->children.end()));
-            // Erase the moved children from the original node
-            node->children.erase(node->children.begin() + split_index, node->children.end());
-
-            // IMPORTANT: Update the parent pointers of the moved children to point to the new node
-            for (auto &child : new_node->children)
+            // Buffered mode: internal children take the share into their buffer
+            // and only push it further down once that buffer is full
+            for (const item_type *item : child_share)
+            {
+                child->buffer.push_back(*item);
+            }
+            child->buffered = true;
+            child->dirty = true;
+            if (child->buffer.size() >= buffer_capacity_)
             {
-                if (child)
-                    child->parent = new_node.get();
+                split_off = empty_buffer(child);
             }
         }
-        else if (!node->children.empty() && split_index == node->children.size())
+        else
         {
-            // Edge case: trying to move 0 elements when split_index == size
+            split_off = insert_batch_into(child, child_share);
         }
-        else if (!node->children.empty())
+        if (!split_off.empty())
         {
-            std::cerr << "Warning: Split index issue during internal node split. Size: " << total_size << ", Index: " << split_index << std::endl;
+            node->entry_mbrs[i] = node->children[i]->mbr; // The child shrank when it split
+            for (auto &sibling : split_off)
+            {
+                node->add_child(std::move(sibling));
+            }
         }
     }
+    return split_until_fits(node);
+}
 
-    // Update the MBRs for both the original node and the new node, as their contents have changed
-    node->update_mbr();
-    new_node->update_mbr();
+// Empty a full buffer into the level below
+template <typename T, std::size_t D>
+std::vector<typename BasicRTree<T, D>::NodePtr> BasicRTree<T, D>::empty_buffer(Node *node)
+{
+    std::vector<item_type> pending = std::move(node->buffer);
+    node->buffer.clear();
+    node->buffered = false;
+    node->dirty = true;
 
-    // Return the pointer to the newly created node
-    return new_node;
+    // Only the root buffer collects items in arrival order. Lower buffers are
+    // filled with shares that were already curve-sorted one level up, so their
+    // items arrive in sorted runs and can be routed as they are.
+    if (node == root_.get())
+    {
+        return insert_batch_into(node, sort_by_curve(pending));
+    }
+    std::vector<const item_type *> in_order;
+    in_order.reserve(pending.size());
+    for (const auto &item : pending)
+    {
+        in_order.push_back(&item);
+    }
+    return insert_batch_into(node, in_order);
+}
+
+// Depth-first search for the node holding item. Entry boxes always contain
+// the boxes below them, so only entries containing item.bounds are followed.
+template <typename T, std::size_t D>
+typename BasicRTree<T, D>::Node *BasicRTree<T, D>::find_item(Node *node, const item_type &item, std::vector<PathStep> &path) const
+{
+    auto matches = [&](const item_type &candidate)
+    { return candidate.id == item.id; };
+    if (std::any_of(node->buffer.begin(), node->buffer.end(), matches))
+        return node;
+    if (node->is_leaf)
+    {
+        return std::any_of(node->data_entries.begin(), node->data_entries.end(), matches) ? node : nullptr;
+    }
+    for (size_t i = 0; i < node->children.size(); ++i)
+    {
+        if (!node->entry_mbrs[i].contains(item.bounds))
+            continue;
+        path.push_back({node, i});
+        if (Node *found = find_item(node->children[i].get(), item, path))
+            return found;
+        path.pop_back();
+    }
+    return nullptr;
+}
+
+// Move out every item stored in a subtree (copy those a version still uses).
+// A node below a shared one is reachable from the version too, even though
+// its own pointer has a single owner.
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::collect_items(const NodePtr &slot, std::vector<item_type> &out, bool shared)
+{
+    Node *node = slot.get();
+    shared |= slot.use_count() > 1;
+    if (!shared)
+    {
+        std::move(node->buffer.begin(), node->buffer.end(), std::back_inserter(out));
+        std::move(node->data_entries.begin(), node->data_entries.end(), std::back_inserter(out));
+    }
+    else
+    {
+        out.insert(out.end(), node->buffer.begin(), node->buffer.end());
+        out.insert(out.end(), node->data_entries.begin(), node->data_entries.end());
+    }
+    for (const auto &child : node->children)
+    {
+        collect_items(child, out, shared);
+    }
 }
 
-// Recursive helper for standard spatial search (find items intersecting query_rect)
-void RTree::search_recursive(const RTreeNode *node, const Rectangle &query_rect, std::vector<DataItem> &results) const
+// Gather buffered items from a subtree (buffers only live on internal nodes)
+template <typename T, std::size_t D>
+bool BasicRTree<T, D>::collect_buffers(NodePtr &slot, std::vector<item_type> &out)
 {
-    if (!node)
-        return; // Safety check
+    // Shared subtrees without buffers are left alone instead of being copied
+    if (slot->is_leaf || (slot.use_count() > 1 && !holds_buffered(slot.get())))
+        return false;
+    Node *node = writable(slot);
+    bool collected = !node->buffer.empty();
+    std::move(node->buffer.begin(), node->buffer.end(), std::back_inserter(out));
+    node->buffer.clear();
+    node->buffered = false;
+    for (auto &child : node->children)
+    {
+        collected |= collect_buffers(child, out);
+    }
+    node->dirty |= collected; // So tighten reaches the nodes whose buffers shrank
+    return collected;
+}
 
+template <typename T, std::size_t D>
+bool BasicRTree<T, D>::holds_buffered(const Node *node)
+{
     if (node->is_leaf)
+        return false;
+    if (node->buffered)
+        return true;
+    return std::any_of(node->children.begin(), node->children.end(), [](const NodePtr &child)
+                       { return holds_buffered(child.get()); });
+}
+
+// Add levels above the root while it keeps splitting
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::grow_root(std::vector<NodePtr> siblings)
+{
+    while (!siblings.empty())
     {
-        // Leaf node: Check each data item's bounds against the query rectangle
-        for (const auto &item : node->data_entries)
+        // Create a new root node (which will be an internal node) with the
+        // old root and the nodes split off it as children
+        auto new_root = std::make_shared<Node>(false);
+        new_root->add_child(std::move(root_));
+        for (auto &sibling : siblings)
         {
-            if (item.bounds.intersects(query_rect))
-            {
-                results.push_back(item); // Add item to results if it intersects
-            }
+            new_root->add_child(std::move(sibling));
         }
+        new_root->update_mbr();
+        new_root->dirty = true;
+        root_ = std::move(new_root);
+        siblings = split_until_fits(root_.get());
     }
-    else
-    { // Internal node
-        // Internal node: Check which children's MBRs intersect the query rectangle
-        for (const auto &child_ptr : node->children)
+}
+
+// Sort items by space-filling-curve key over the extent of the items themselves
+template <typename T, std::size_t D>
+std::vector<const typename BasicRTree<T, D>::item_type *> BasicRTree<T, D>::sort_by_curve(std::span<const item_type> items)
+{
+    std::vector<const item_type *> sorted;
+    sorted.reserve(items.size());
+    for (const auto &[key, position] : curve_order(items, [](const item_type &item)
+                                                   { return item.bounds; }))
+    {
+        sorted.push_back(&items[position]);
+    }
+    return sorted;
+}
+
+// Repeatedly halve node (and the resulting pieces) until none is full
+template <typename T, std::size_t D>
+std::vector<typename BasicRTree<T, D>::NodePtr> BasicRTree<T, D>::split_until_fits(Node *node)
+{
+    std::vector<NodePtr> split_off;
+    std::vector<Node *> pending{node};
+    while (!pending.empty())
+    {
+        Node *current = pending.back();
+        pending.pop_back();
+        if (!current->is_full(max_entries_for(current)))
+            continue;
+        NodePtr sibling = split_node(current);
+        pending.push_back(current);
+        pending.push_back(sibling.get());
+        split_off.push_back(std::move(sibling));
+    }
+    return split_off;
+}
+
+// Post-order recomputation limited to dirty subtrees: clean children keep
+// their exact MBRs, dirty ones are tightened first and their entry refreshed
+template <typename T, std::size_t D>
+void BasicRTree<T, D>::tighten_node(Node *node) const
+{
+    if (!node->is_leaf)
+    {
+        for (size_t i = 0; i < node->children.size(); ++i)
         {
-            // If child exists and its MBR intersects the query, descend into that child
-            if (child_ptr && child_ptr->mbr.intersects(query_rect))
+            Node *child = node->children[i].get();
+            if (child->dirty)
             {
-                search_recursive(child_ptr.get(), query_rect, results);
+                tighten_node(child);
+                node->entry_mbrs[i] = child->mbr;
             }
         }
     }
+    node->update_mbr();
+    node->dirty = false;
 }
 
-// Recursive helper for spatial search with population filter
-void RTree::search_pop_recursive(const RTreeNode *node, const Rectangle &query_rect, long min_population, std::vector<DataItem> &results) const
+// Choose the best subtree to insert into (minimizes MBR area increase)
+template <typename T, std::size_t D>
+size_t BasicRTree<T, D>::choose_subtree(const Node *node, const rect_type &item_bounds) const
 {
-    if (!node)
-        return; // Safety check
+    // Precondition: node is guaranteed to be an internal node.
+    if (node->children.empty())
+    {
+        // This indicates an error state (internal node with no children)
+        throw std::runtime_error("Internal RTree node has no children during choose_subtree.");
+    }
 
-    if (node->is_leaf)
+    size_t best_child = 0;
+    using area_type = typename rect_type::area_type;
+    area_type min_increase = std::numeric_limits<area_type>::max();
+    area_type min_area = std::numeric_limits<area_type>::max();
+
+    // Iterate over the children's MBRs (contiguous, no child node is dereferenced).
+    // The area increases of a chunk are computed in one batch kernel call.
+    std::span<const rect_type> boxes(node->entry_mbrs);
+    std::array<area_type, kernel_chunk> increases;
+    for (size_t begin = 0; begin < boxes.size(); begin += kernel_chunk)
     {
-        // Leaf node: Check each data item
-        for (const auto &item : node->data_entries)
+        std::span<const rect_type> chunk = boxes.subspan(begin, std::min(kernel_chunk, boxes.size() - begin));
+        area_increases(chunk, item_bounds, increases);
+        for (size_t i = 0; i < chunk.size(); ++i)
         {
-            // Check BOTH intersection AND population criteria
-            if (item.population >= min_population && item.bounds.intersects(query_rect))
+            area_type current_area = chunk[i].area();
+
+            // Primary criterion: Choose the child requiring the minimum area increase
+            // Tie-breaking criterion: If increases are equal, choose the child with the smallest current MBR area
+            if (increases[i] < min_increase || (increases[i] == min_increase && current_area < min_area))
             {
-                results.push_back(item);
+                min_increase = increases[i];
+                min_area = current_area;
+                best_child = begin + i;
             }
         }
     }
-    else
-    { // Internal node
-        // Internal node: Check which children's MBRs intersect the query rectangle
-        // No population check needed here, as internal nodes don't store population directly.
-        // We must descend into any relevant child to check its leaves eventually.
-        for (const auto &child_ptr : node->children)
+
+    return best_child;
+}
+
+// Unwind a descent path from the modified node up to the root
+template <typename T, std::size_t D>
+template <typename Path>
+typename BasicRTree<T, D>::NodePtr BasicRTree<T, D>::propagate_up(Path &path, Node *node)
+{
+    // Split the modified node itself if it is now full
+    NodePtr pending_split = node->is_full(max_entries_for(node)) ? split_node(node) : nullptr;
+
+    while (!path.empty())
+    {
+        PathStep step = path.pop();
+        Node *parent = step.node;
+
+        // A split occurred below. Refresh the parent's box for the shrunken child,
+        // add the new node as a child of the parent, and split the parent in turn
+        // if that made it full.
+        if (pending_split)
         {
-            if (child_ptr && child_ptr->mbr.intersects(query_rect))
+            parent->entry_mbrs[step.child_index] = parent->children[step.child_index]->mbr;
+            parent->add_child(std::move(pending_split));
+            if (parent->is_full(max_entries_for(parent)))
             {
-                search_pop_recursive(child_ptr.get(), query_rect, min_population, results);
+                pending_split = split_node(parent);
             }
         }
     }
+    return pending_split; // Non-null only if the root itself was split
 }
 
-// Recursive helper for printing the tree structure
-// Uses the 'os' parameter passed down from print_structure
-void RTree::print_node(std::ostream &os, const RTreeNode *node, int indent) const
+// Splits a full node (either leaf or internal) into two nodes.
+// Returns a pointer to the newly created node.
+// Modifies the original node ('node') to contain the first half of the entries/children.
+// Note: This uses a very simple linear split (dividing items in half).
+//       Real R-Trees use more sophisticated algorithms (Linear, Quadratic, R*)
+//       to minimize overlap and area for better query performance. This is a placeholder.
+template <typename T, std::size_t D>
+typename BasicRTree<T, D>::NodePtr BasicRTree<T, D>::split_node(Node *node)
 {
-    if (!node)
-        return;
+    size_t total_size = node->size();
+    const size_t min_entries = min_entries_for(node);
 
-    std::string indent_str(indent * 2, ' '); // Create indentation string
+    // Determine the split point. Aim for roughly half, but respect min_entries.
+    // This simple split doesn't guarantee min_entries for both resulting nodes,
+    // which is a limitation compared to proper R-Tree split algorithms.
+    size_t split_index = std::max(min_entries, total_size / 2);
+    // Ensure the original node keeps at least min_entries if possible
+    // and the new node also gets at least min_entries if total_size allows
+    if (total_size > min_entries * 2)
+    { // Only adjust if there's enough to satisfy min on both sides
+        if (total_size - split_index < min_entries)
+        {
+            split_index = total_size - min_entries;
+        }
+        if (split_index < min_entries)
+        { // Ensure original node keeps min_entries
+            split_index = min_entries;
+        }
+    }
+    else
+    {                                       // Not enough items to guarantee min_entries on both, just split near middle
+        split_index = (total_size + 1) / 2; // Ensure first node gets slightly more if odd
+    }
 
-    // Print node type, memory address (for debugging splits), MBR, and size
-    os << indent_str << "[" << (node->is_leaf ? "LEAF" : "INTERNAL")
-       << " @ " << static_cast<const void *>(node) // Print node address safely
-       << "] MBR: ("
-       << node->mbr.min_corner.x << "," << node->mbr.min_corner.y << ")-("
-       << node->mbr.max_corner.x << "," << node->mbr.max_corner.y << ") "
-       << "Size: " << node->size() << "\n";
+    // Clamp split_index to valid range [1, total_size - 1] if possible
+    split_index = std::max((size_t)1, std::min(split_index, total_size > 1 ? total_size - 1 : 1));
 
-    // Print contents based on node type
-    if (node->is_leaf)
+    // Create the new sibling node (same type: leaf or internal)
+    auto new_node = std::make_shared<Node>(node->is_leaf);
+
+    // Move the second half of the entry MBRs (or points) to the new node
+    new_node->point_leaf = node->point_leaf;
+    if (node->point_leaf)
     {
-        // Leaf node: Print details of each data item
-        for (const auto &item : node->data_entries)
-        {
-            os << indent_str << "  - Item ID: " << item.id << ", Name: " << item.name
-               << ", Pop: " << item.population << ", Bounds: ("
-               << item.bounds.min_corner.x << "," << item.bounds.min_corner.y << ")-("
-               << item.bounds.max_corner.x << "," << item.bounds.max_corner.y << ")\n";
-        }
+        new_node->entry_points.assign(node->entry_points.begin() + split_index, node->entry_points.end());
+        node->entry_points.erase(node->entry_points.begin() + split_index, node->entry_points.end());
     }
     else
     {
-        // Internal node: Recursively print each child node
-        for (const auto &child : node->children)
-        {
-            if (child)
-            {
-                print_node(os, child.get(), indent + 1); // Increase indent for children
-            }
-            else
-            {
-                os << indent_str << "  (null child pointer)\n"; // Should ideally not happen
-            }
-        }
+        new_node->entry_mbrs.assign(node->entry_mbrs.begin() + split_index, node->entry_mbrs.end());
+        node->entry_mbrs.erase(node->entry_mbrs.begin() + split_index, node->entry_mbrs.end());
     }
+
+    if (node->is_leaf)
+    {
+        // Move the matching data entries to the new node
+        new_node->data_entries.assign(
+            std::make_move_iterator(node->data_entries.begin() + split_index),
+            std::make_move_iterator(node->data_entries.end()));
+        // Erase the moved entries from the original node
+        node->data_entries.erase(node->data_entries.begin() + split_index, node->data_entries.end());
+    }
+    else
+    {   // Internal node
+        // Move the matching child pointers to the new node
+        new_node->children.assign(
+            std::make_move_iterator(node->children.begin() + split_index),
+            std::make_move_iterator(node->children.end()));
+        // Erase the moved children from the original node
+        node->children.erase(node->children.begin() + split_index, node->children.end());
+    }
+
+    // Give both halves their MBR from one pass over their own entry boxes, so
+    // choose_subtree can tell them apart before the next tighten. Entry boxes
+    // of dirty children may still be loose, so both stay dirty.
+    node->update_mbr();
+    new_node->update_mbr();
+    node->dirty = true;
+    new_node->dirty = true;
+
+    // Return the pointer to the newly created node
+    return new_node;
 }
+
+// --- Explicit Instantiations ---
+// The template definitions above are only visible in this translation unit,
+// so every supported coordinate configuration is instantiated here.
+template struct BasicRTreeNode<double, 2>;
+template class BasicRTree<double, 2>;
+template struct BasicRTreeNode<std::int32_t, 2>;
+template class BasicRTree<std::int32_t, 2>;
+template struct BasicRTreeNode<double, 3>;
+template class BasicRTree<double, 3>;
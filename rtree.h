@@ -2,164 +2,753 @@
 #define RTREE_H
 
 #include <vector>
-#include <memory>  // For std::unique_ptr
+#include <memory>  // For std::shared_ptr (nodes are shared between versions)
 #include <cstddef> // For size_t
+#include <cstdint> // For std::int32_t (integer-grid instantiation)
 #include <string>
+#include <algorithm>   // For std::min, std::max in the constexpr geometry kernels
+#include <type_traits> // For std::conditional_t, std::enable_if_t
+#include <limits>      // For the empty-box sentinels
+#include <span>        // For the batch rectangle kernels
+#include <new>         // For std::align_val_t (cache-aligned node storage)
+#include <map>         // For the retained versions
+#include <functional>  // For std::function (item visitors)
+#include <utility>     // For std::pair (curve order)
 
 #include <iostream> // Include full iostream for std::ostream and std::cout definitions
 
+// Hint the CPU to start loading a cache line that will be read soon
+#if defined(__GNUC__) || defined(__clang__)
+#define RTREE_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#else
+#define RTREE_PREFETCH(addr) ((void)(addr))
+#endif
+
 // --- Basic Geometric Structures ---
+// Geometry is templated on the coordinate type T and the dimension D.
+// The dimension is a compile-time constant, so every per-axis loop below
+// is fully unrolled by the compiler. The familiar 2D double types are
+// provided as the aliases Point / Rectangle further down.
 
-struct Point
+template <typename T, std::size_t D>
+struct BasicPoint
 {
-    double x = 0.0;
-    double y = 0.0;
+    static_assert(D >= 1, "BasicPoint requires at least one dimension");
+
+    T coords[D] = {};
+
+    constexpr BasicPoint() = default;
+
+    // One coordinate per dimension, e.g. BasicPoint<double, 3>(x, y, z)
+    template <typename... Args, std::enable_if_t<sizeof...(Args) == D, int> = 0>
+    constexpr BasicPoint(Args... args) : coords{static_cast<T>(args)...} {}
 
-    Point(double x_ = 0.0, double y_ = 0.0) : x(x_), y(y_) {}
+    constexpr T &operator[](std::size_t axis) { return coords[axis]; }
+    constexpr const T &operator[](std::size_t axis) const { return coords[axis]; }
 };
 
-struct Rectangle
+// 2D specialization keeps the named x/y members used throughout the application
+template <typename T>
+struct BasicPoint<T, 2>
 {
-    Point min_corner;
-    Point max_corner;
+    T x = T();
+    T y = T();
 
-    Rectangle(); // Default constructor
-    Rectangle(Point min_c, Point max_c);
-    Rectangle(double min_x, double min_y, double max_x, double max_y);
+    constexpr BasicPoint(T x_ = T(), T y_ = T()) : x(x_), y(y_) {}
 
-    // --- Inline Methods ---
-    double area() const
+    constexpr T &operator[](std::size_t axis) { return axis == 0 ? x : y; }
+    constexpr const T &operator[](std::size_t axis) const { return axis == 0 ? x : y; }
+};
+
+template <typename T, std::size_t D>
+struct BasicRectangle
+{
+    using coord_type = T;
+    using point_type = BasicPoint<T, D>;
+    // Areas of integer boxes are computed in double so large grids cannot overflow
+    using area_type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+    static constexpr std::size_t dimensions = D;
+
+    // Sentinels for the empty box: +inf/-inf for floating point, max/lowest for integers
+    static constexpr T empty_min = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    static constexpr T empty_max = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+
+    point_type min_corner;
+    point_type max_corner;
+
+    // Default constructor produces the empty box (see empty())
+    constexpr BasicRectangle() : BasicRectangle(empty()) {}
+    constexpr BasicRectangle(point_type min_c, point_type max_c) : min_corner(min_c), max_corner(max_c) {}
+
+    template <std::size_t DD = D, std::enable_if_t<DD == 2, int> = 0>
+    constexpr BasicRectangle(T min_x, T min_y, T max_x, T max_y)
+        : min_corner(min_x, min_y), max_corner(max_x, max_y) {}
+
+    // The empty box (+inf, ..., -inf, ...). It is the identity of expand/combine,
+    // has zero area and intersects nothing, so the kernels below need no validity checks.
+    static constexpr BasicRectangle empty()
     {
-        if (max_corner.x < min_corner.x || max_corner.y < min_corner.y)
-            return 0.0; // Invalid
-        return (max_corner.x - min_corner.x) * (max_corner.y - min_corner.y);
+        BasicRectangle result(point_type{}, point_type{});
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            result.min_corner[i] = empty_min;
+            result.max_corner[i] = empty_max;
+        }
+        return result;
     }
 
-    bool contains(const Point &p) const
+    // A rectangle is valid when min <= max on every axis
+    constexpr bool is_valid() const
     {
-        return p.x >= min_corner.x && p.x <= max_corner.x &&
-               p.y >= min_corner.y && p.y <= max_corner.y;
+        bool valid = true;
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            valid &= min_corner[i] <= max_corner[i];
+        }
+        return valid;
     }
 
-    bool contains(const Rectangle &other) const
+    // A degenerate box (min == max on every axis) stands for a single point
+    constexpr bool is_point() const
     {
-        return other.min_corner.x >= min_corner.x &&
-               other.max_corner.x <= max_corner.x &&
-               other.min_corner.y >= min_corner.y &&
-               other.max_corner.y <= max_corner.y;
+        bool point = true;
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            point &= min_corner[i] == max_corner[i];
+        }
+        return point;
     }
 
-    // --- Methods implemented in rtree.cpp ---
-    bool intersects(const Rectangle &other) const;
-    void expand(const Rectangle &other);                // Expand this MBR to include another
-    double area_increase(const Rectangle &other) const; // Calculate area increase needed
+    // Empty and inverted boxes have zero area (negative extents clamp to 0)
+    constexpr area_type area() const
+    {
+        area_type result = 1;
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            result *= std::max(area_type(0), static_cast<area_type>(max_corner[i]) - static_cast<area_type>(min_corner[i]));
+        }
+        return result;
+    }
 
-    // --- Static Methods ---
-    static Rectangle combine(const Rectangle &r1, const Rectangle &r2); // Combine two MBRs
+    constexpr bool contains(const point_type &p) const
+    {
+        bool inside = true;
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            inside &= (p[i] >= min_corner[i]) & (p[i] <= max_corner[i]);
+        }
+        return inside;
+    }
+
+    constexpr bool contains(const BasicRectangle &other) const
+    {
+        bool inside = true;
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            inside &= (other.min_corner[i] >= min_corner[i]) & (other.max_corner[i] <= max_corner[i]);
+        }
+        return inside;
+    }
+
+    // Check if this rectangle intersects another rectangle
+    // (separating axis test, evaluated without early exits)
+    constexpr bool intersects(const BasicRectangle &other) const
+    {
+        bool overlap = true;
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            overlap &= (max_corner[i] >= other.min_corner[i]) & (min_corner[i] <= other.max_corner[i]);
+        }
+        return overlap;
+    }
+
+    // Expand this rectangle's MBR to minimally enclose another rectangle.
+    // Expanding by the empty box is a no-op; expanding the empty box yields the other box.
+    constexpr void expand(const BasicRectangle &other)
+    {
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            min_corner[i] = std::min(min_corner[i], other.min_corner[i]);
+            max_corner[i] = std::max(max_corner[i], other.max_corner[i]);
+        }
+    }
+
+    // Calculate the increase in area needed for this MBR to include another rectangle
+    constexpr area_type area_increase(const BasicRectangle &other) const
+    {
+        return combine(*this, other).area() - area();
+    }
+
+    // Calculate the minimal bounding rectangle enclosing two rectangles
+    static constexpr BasicRectangle combine(const BasicRectangle &r1, const BasicRectangle &r2)
+    {
+        BasicRectangle result = r1;
+        result.expand(r2);
+        return result;
+    }
 };
 
+// --- Batch Rectangle Kernels ---
+// Straight-line loops over contiguous boxes with no data-dependent branches,
+// so the compiler can vectorize them. Used on node entry arrays by the
+// traversal engine and choose_subtree.
+
+// Writes pred(box) as 1/0 per box (or point) into mask (mask.size() >= boxes.size());
+// returns the number of hits. pred should be a branchless test like intersects.
+template <typename Box, typename Pred>
+constexpr std::size_t match_mask(std::span<const Box> boxes, Pred &&pred, std::span<std::uint8_t> mask)
+{
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        bool hit = pred(boxes[i]);
+        mask[i] = static_cast<std::uint8_t>(hit);
+        hits += hit;
+    }
+    return hits;
+}
+
+// match_mask with an intersection test against query
+template <typename T, std::size_t D>
+constexpr std::size_t intersect_mask(std::span<const BasicRectangle<T, D>> boxes, const BasicRectangle<T, D> &query,
+                                     std::span<std::uint8_t> mask)
+{
+    return match_mask(boxes, [&](const BasicRectangle<T, D> &box)
+                      { return box.intersects(query); },
+                      mask);
+}
+
+// Bounding box of all boxes (the empty box for an empty span)
+template <typename T, std::size_t D>
+constexpr BasicRectangle<T, D> combine_all(std::span<const BasicRectangle<T, D>> boxes)
+{
+    BasicRectangle<T, D> result = BasicRectangle<T, D>::empty();
+    for (const auto &box : boxes)
+    {
+        result.expand(box);
+    }
+    return result;
+}
+
+// Area increase of every box when enlarged to include item (out.size() >= boxes.size())
+template <typename T, std::size_t D>
+constexpr void area_increases(std::span<const BasicRectangle<T, D>> boxes, const BasicRectangle<T, D> &item,
+                              std::span<typename BasicRectangle<T, D>::area_type> out)
+{
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        out[i] = boxes[i].area_increase(item);
+    }
+}
+
+// --- Space-Filling Curve Keys ---
+// Used to order items so that neighbours on the curve are neighbours in space
+// (batch insert, bulk loading).
+
+// Position of grid cell (x, y) along a Hilbert curve covering a 2^order x 2^order grid
+constexpr std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y, unsigned order)
+{
+    const std::uint32_t n = std::uint32_t(1) << order;
+    std::uint64_t d = 0;
+    for (std::uint32_t s = n / 2; s > 0; s /= 2)
+    {
+        std::uint32_t rx = (x & s) > 0;
+        std::uint32_t ry = (y & s) > 0;
+        d += std::uint64_t(s) * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve stays continuous
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+    return d;
+}
+
+// Grid cell (0 .. 2^order - 1) of a coordinate within [lo, hi]
+template <typename T>
+constexpr std::uint32_t curve_cell(T value, T lo, T hi, unsigned order)
+{
+    double span = static_cast<double>(hi) - static_cast<double>(lo);
+    if (!(span > 0.0))
+        return 0;
+    double max_cell = static_cast<double>((std::uint64_t(1) << order) - 1);
+    double cell = (static_cast<double>(value) - static_cast<double>(lo)) / span * max_cell;
+    if (!(cell > 0.0)) // Also catches NaN
+        return 0;
+    return static_cast<std::uint32_t>(std::min(cell, max_cell));
+}
+
+// Curve key of a box's center within extent: Hilbert order in 2D, Z-order
+// (bit interleaving) in other dimensions
+template <typename T, std::size_t D>
+constexpr std::uint64_t space_filling_key(const BasicRectangle<T, D> &box, const BasicRectangle<T, D> &extent)
+{
+    constexpr unsigned order = D == 2 ? 16 : static_cast<unsigned>(63 / D);
+    std::uint32_t cells[D] = {};
+    for (std::size_t i = 0; i < D; ++i)
+    {
+        T center = static_cast<T>(box.min_corner[i] / 2 + box.max_corner[i] / 2);
+        cells[i] = curve_cell(center, extent.min_corner[i], extent.max_corner[i], order);
+    }
+    if constexpr (D == 2)
+    {
+        return hilbert_index(cells[0], cells[1], order);
+    }
+    std::uint64_t key = 0;
+    for (unsigned bit = order; bit-- > 0;)
+    {
+        for (std::size_t i = 0; i < D; ++i)
+        {
+            key = (key << 1) | ((cells[i] >> bit) & 1u);
+        }
+    }
+    return key;
+}
+
+// Box enclosing bounds_of(item) for every item (the empty box if there are none)
+template <typename Items, typename Bounds>
+auto curve_extent(const Items &items, Bounds &&bounds_of)
+{
+    using rect_type = std::decay_t<decltype(bounds_of(*std::begin(items)))>;
+    rect_type extent = rect_type::empty();
+    for (const auto &item : items)
+    {
+        extent.expand(bounds_of(item));
+    }
+    return extent;
+}
+
+// (key, position) of every item, sorted along the curve: key is the
+// space_filling_key of bounds_of(item) within extent. Items with equal keys
+// keep their input order.
+template <typename Items, typename Bounds, typename Rect>
+std::vector<std::pair<std::uint64_t, std::size_t>> curve_order(const Items &items, Bounds &&bounds_of, const Rect &extent)
+{
+    std::vector<std::pair<std::uint64_t, std::size_t>> order;
+    order.reserve(std::size(items));
+    std::size_t position = 0;
+    for (const auto &item : items)
+    {
+        order.emplace_back(space_filling_key(bounds_of(item), extent), position++);
+    }
+    std::sort(order.begin(), order.end());
+    return order;
+}
+
+// Same, within the extent of the items themselves
+template <typename Items, typename Bounds>
+std::vector<std::pair<std::uint64_t, std::size_t>> curve_order(const Items &items, Bounds &&bounds_of)
+{
+    return curve_order(items, bounds_of, curve_extent(items, bounds_of));
+}
+
+using Point = BasicPoint<double, 2>;
+using Rectangle = BasicRectangle<double, 2>;
+
 // --- Data Item Structure ---
 // Represents the actual data stored in the leaf nodes.
 // Includes the spatial extent (rectangle) and associated attributes.
-struct DataItem
+template <typename T, std::size_t D>
+struct BasicDataItem
 {
+    using rect_type = BasicRectangle<T, D>;
+
     int id;           // Unique identifier for the data item
     std::string name; // Name (e.g., city name, region code)
     long population;  // Associated data (e.g., population count)
-    Rectangle bounds; // The spatial bounding box of this item
+    rect_type bounds; // The spatial bounding box of this item
 
-    DataItem(int id_ = 0, std::string name_ = "", long pop_ = 0, Rectangle b_ = Rectangle())
+    BasicDataItem(int id_ = 0, std::string name_ = "", long pop_ = 0, rect_type b_ = rect_type())
         : id(id_), name(std::move(name_)), population(pop_), bounds(b_) {}
 };
 
-// --- R-Tree Node Structure ---
+using DataItem = BasicDataItem<double, 2>;
+
+// --- Cache-Line Aligned Storage ---
 
-// Forward declaration
-class RTree;
+constexpr std::size_t cache_line_size = 64;
 
-struct RTreeNode
+// Allocator that starts every buffer on a cache-line boundary, so a node's
+// entry MBR array occupies whole cache lines of its own
+template <typename V, std::size_t Alignment = cache_line_size>
+struct CacheAlignedAllocator
 {
-    using NodePtr = std::unique_ptr<RTreeNode>;
+    using value_type = V;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = CacheAlignedAllocator<U, Alignment>;
+    };
 
-    Rectangle mbr; // Minimum Bounding Rectangle enclosing all entries/children in this node
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U, Alignment> &) {}
+
+    V *allocate(std::size_t n)
+    {
+        return static_cast<V *>(::operator new(n * sizeof(V), std::align_val_t(Alignment)));
+    }
+    void deallocate(V *p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U, Alignment> &) const { return true; }
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+// --- R-Tree Node Structure ---
+// Layout is split by access frequency. The first cache line holds what every
+// visit reads: the flags and the headers of entry_mbrs and entry_points,
+// contiguous cache-line aligned arrays with the MBR of each child (internal)
+// or item (leaf). The node's own MBR is only read at the root and when
+// tightening (a parent tests its children through entry_mbrs), so it follows
+// in the next line with the child pointers and item payloads, which are only
+// dereferenced for entries that pass the MBR test. Insert buffers come last,
+// behind the buffered flag. Nodes store no parent links: insertion records
+// its root-to-leaf path instead. Children are held by shared_ptr so committed
+// versions of the tree can share subtrees.
+// A leaf whose items are all points (as packed by bulk_load) stores only their
+// coordinates in entry_points, half the bytes of a box per entry, and leaves
+// entry_mbrs empty. Adding a non-point item turns it back into a box leaf.
+
+template <typename T, std::size_t D>
+struct alignas(cache_line_size) BasicRTreeNode
+{
+    using NodePtr = std::shared_ptr<BasicRTreeNode>;
+    using rect_type = BasicRectangle<T, D>;
+    using item_type = BasicDataItem<T, D>;
+    using point_type = typename rect_type::point_type;
+    using BoxArray = std::vector<rect_type, CacheAlignedAllocator<rect_type>>;
+    using PointArray = std::vector<point_type, CacheAlignedAllocator<point_type>>;
+
+    // --- Hot: read on every node visit ---
     bool is_leaf = true;
-    RTreeNode *parent = nullptr; // Non-owning pointer to parent
+    bool dirty = false;      // Contents changed since mbr (and child entry_mbrs) were last tightened
+    bool point_leaf = false; // Entries are kept in entry_points instead of entry_mbrs
+    bool buffered = false;   // buffer is non-empty (kept in step by every buffer update)
+    BoxArray entry_mbrs;     // entry_mbrs[i] bounds children[i] or data_entries[i]
+    PointArray entry_points; // entry_points[i] is the location of data_entries[i] (point leaves)
 
-    // Data stored in the node
-    std::vector<DataItem> data_entries; // Used only if is_leaf is true
-    std::vector<NodePtr> children;      // Used only if is_leaf is false
+    // --- Cold: read only for entries whose MBR qualifies ---
+    rect_type mbr;                       // Minimum Bounding Rectangle enclosing all entries/children in this node
+    std::vector<NodePtr> children;       // Used only if is_leaf is false
+    std::vector<item_type> data_entries; // Used only if is_leaf is true
+    std::vector<item_type> buffer;       // Pending inserts (internal nodes, buffered insert mode only)
 
-    explicit RTreeNode(bool leaf = true); // Constructor
+    explicit BasicRTreeNode(bool leaf = true); // Constructor
 
     // --- Methods implemented in rtree.cpp ---
-    void update_mbr(); // Recalculate MBR based on contents
+    void update_mbr(); // Recalculate MBR based on contents (including buffered items)
     bool is_full(size_t max_entries) const;
     size_t size() const;
+    void add_child(NodePtr child);       // Appends a child and its MBR (internal nodes)
+    void add_entry(const item_type &item); // Appends an item and its bounds (leaf nodes)
+    void remove_entry(size_t index);       // Removes data_entries[index] and its bounds
+    void unpack_points();                  // Turns a point leaf back into a box leaf
 };
 
-// --- R-Tree Class ---
+using RTreeNode = BasicRTreeNode<double, 2>;
+
+// --- Spatial Index Interface ---
+// The query API shared by RTree and the alternative backends in
+// index_backends.h, so an application or benchmark can pick the structure
+// per data layer (see make_spatial_index). Calls through a concrete RTree
+// stay direct: the class is final, so they are not dispatched virtually.
 
-class RTree
+template <typename T, std::size_t D>
+class BasicSpatialIndex
 {
 public:
-    using NodePtr = RTreeNode::NodePtr;
+    using rect_type = BasicRectangle<T, D>;
+    using item_type = BasicDataItem<T, D>;
+
+    virtual ~BasicSpatialIndex() = default;
+
+    virtual void insert(const item_type &item) = 0;
+    virtual void insert_batch(std::span<const item_type> items) = 0;
+
+    virtual std::vector<item_type> search(const rect_type &query_rect) const = 0;
+    virtual std::vector<item_type> search_with_population(const rect_type &query_rect, long min_population) const = 0;
+    virtual size_t count(const rect_type &query_rect) const = 0;
+
+    virtual size_t size() const = 0;
+    virtual bool empty() const = 0;
+};
+
+using SpatialIndex = BasicSpatialIndex<double, 2>;
+
+// --- Node Capacities ---
+// Minimum / maximum entries of internal nodes and of leaves. Leaves hold item
+// boxes and internal nodes child boxes, so the best fan-outs can differ
+// (see fanout_tuning.h).
+struct FanOut
+{
+    size_t min_entries = 2;
+    size_t max_entries = 4;
+    size_t min_leaf_entries = 2;
+    size_t max_leaf_entries = 4;
+};
+
+// --- R-Tree Class ---
+// Member definitions live in rtree.cpp, which explicitly instantiates the
+// supported coordinate configurations:
+//   BasicRTree<double, 2>        (RTree, geographic data)
+//   BasicRTree<std::int32_t, 2>  (GridRTree, integer tile grids at half the memory)
+//   BasicRTree<double, 3>        (space x time, used by TemporalRTree)
+//
+// Thread safety: the tree has no internal locking, and its queries are not
+// read-only while any node is dirty (the first query after a modification
+// tightens the tree, see tighten()). Const calls may run concurrently only
+// on a tight tree: after bulk_load, after an explicit tighten(), or on a
+// committed version, which is tightened when it is frozen. Any modification
+// needs exclusive access.
+
+template <typename T, std::size_t D>
+class BasicRTree final : public BasicSpatialIndex<T, D>
+{
+public:
+    using Node = BasicRTreeNode<T, D>;
+    using NodePtr = typename Node::NodePtr;
+    using rect_type = BasicRectangle<T, D>;
+    using item_type = BasicDataItem<T, D>;
+    using point_type = typename rect_type::point_type;
 
     // Constructor: Sets min/max entries per node
-    explicit RTree(size_t min_entries = 2, size_t max_entries = 4);
+    explicit BasicRTree(size_t min_entries = 2, size_t max_entries = 4);
+
+    // Constructor with separate leaf capacities (each pair is adjusted like min/max above)
+    explicit BasicRTree(const FanOut &fan_out);
 
     // --- Rule of Five/Zero ---
-    // R-Trees with unique_ptr children are complex to copy/move correctly.
-    // Deleting them prevents accidental slicing or double-frees.
-    RTree(const RTree &) = delete;
-    RTree &operator=(const RTree &) = delete;
-    RTree(RTree &&) = delete;            // Could be implemented, but complex
-    RTree &operator=(RTree &&) = delete; // Could be implemented, but complex
-    ~RTree() = default;                  // Default destructor is sufficient thanks to unique_ptr
+    // Nodes are shared with the retained versions, so a copy would have to
+    // copy-on-write against those as well. Deleting them prevents accidental aliasing.
+    BasicRTree(const BasicRTree &) = delete;
+    BasicRTree &operator=(const BasicRTree &) = delete;
+    BasicRTree(BasicRTree &&) = delete;            // Could be implemented, but complex
+    BasicRTree &operator=(BasicRTree &&) = delete; // Could be implemented, but complex
+    ~BasicRTree() = default;                       // Default destructor is sufficient thanks to shared_ptr
 
     // --- Core Public Methods ---
 
     // Insert a data item into the tree
-    void insert(const DataItem &item);
+    void insert(const item_type &item) override;
+
+    // Insert many items at once. The batch is sorted by Hilbert key and routed
+    // down the tree together: each internal node partitions its share of the
+    // batch among its children in one pass, and each leaf receives all of its
+    // items before it is split (possibly several times).
+    void insert_batch(std::span<const item_type> items) override;
+
+    // Remove the item with item.id whose bounds lie within item.bounds' search
+    // path. Nodes left with fewer than min_entries are dissolved and their
+    // items reinserted. Returns false if no such item is stored.
+    bool remove(const item_type &item);
+
+    // Replace the tree's contents with items packed bottom-up along the Hilbert
+    // curve: leaves and internal nodes are filled evenly to just below capacity.
+    // Much faster than inserting one by one and gives tight, non-overlapping leaves.
+    // Leaves holding only points (zero-extent bounds) store just their coordinates.
+    void bulk_load(std::span<const item_type> items);
+
+    // Number of stored items (including buffered ones)
+    size_t size() const override;
+
+    // Write-optimized insert mode (buffer tree). With a non-zero capacity,
+    // insert and insert_batch append to a buffer on the root instead of
+    // descending. A full buffer is emptied one level down, in one sorted pass,
+    // into the children's buffers (or leaves), which cascade when they fill up.
+    // Queries also scan the buffers of the internal nodes they visit, so
+    // buffered items are always visible. Setting the capacity to 0 (the
+    // default) flushes all buffers and returns to direct inserts.
+    void set_insert_buffering(size_t buffer_capacity);
+    size_t insert_buffer_capacity() const { return buffer_capacity_; }
+
+    // Push every buffered item down to the leaves
+    void flush_buffers();
 
     // Search for data items whose bounds intersect with a query rectangle
-    std::vector<DataItem> search(const Rectangle &query_rect) const;
+    std::vector<item_type> search(const rect_type &query_rect) const override;
 
     // Search for data items intersecting query_rect AND meeting a population criterion
-    std::vector<DataItem> search_with_population(const Rectangle &query_rect, long min_population) const;
+    std::vector<item_type> search_with_population(const rect_type &query_rect, long min_population) const override;
+
+    // Search for data items whose bounds lie entirely inside query_rect
+    std::vector<item_type> search_contained(const rect_type &query_rect) const;
+
+    // Count data items intersecting query_rect without materializing them
+    size_t count(const rect_type &query_rect) const override;
+
+    // Call visit for each data item intersecting query_rect, without copying it
+    void for_each_intersecting(const rect_type &query_rect, const std::function<void(const item_type &)> &visit) const;
 
     // Simple console visualization of the tree structure (for debugging)
     // Now requires <iostream> to be included for std::cout default argument
     void print_structure(std::ostream &os = std::cout) const;
 
     // Check if the tree is empty
-    bool empty() const;
+    bool empty() const override;
+
+    // MBRs are maintained lazily: modifications only mark the nodes they touch
+    // dirty, and the stale MBRs are recomputed once, bottom-up, on the first
+    // query afterwards. Call tighten() to do that work at a chosen point instead
+    // (e.g. after a batch of inserts). Queries that tighten rewrite cached MBRs
+    // only, so they stay logically const, but they write to the nodes: a dirty
+    // tree must not be queried from several threads at once. Call tighten()
+    // before handing the tree to concurrent readers.
+    void tighten() const;
+
+    // --- Versions (path copying) ---
+    // commit_version() freezes the current contents as a read-only version and
+    // returns its number (1, 2, ...). Versions share nodes with each other and
+    // with the live tree: the first change to a node after a commit copies it
+    // (and the path above it) instead of modifying it, so a version only costs
+    // the nodes that changed before the next one. Only the newest `retention`
+    // versions are kept (0 = all); dropping a version frees every node that no
+    // other version or the live tree still uses.
+    std::uint64_t commit_version();
+    void set_version_retention(size_t versions);
+    size_t version_retention() const { return version_retention_; }
+    bool release_version(std::uint64_t version); // False if not retained
+    bool has_version(std::uint64_t version) const { return versions_.count(version) != 0; }
+    size_t version_count() const { return versions_.size(); }
+
+    // Point-in-time queries; throw std::out_of_range if version is not retained
+    std::vector<item_type> search(const rect_type &query_rect, std::uint64_t version) const;
+    size_t count(const rect_type &query_rect, std::uint64_t version) const;
+
+    // Distinct nodes kept alive by the live tree and the retained versions
+    size_t retained_node_count() const;
+
+    // Number of leaves storing their entries as points (see bulk_load)
+    size_t point_leaf_count() const;
+
+    // Node capacities in use
+    FanOut fan_out() const { return {min_entries_, max_entries_, min_leaf_entries_, max_leaf_entries_}; }
+
+    // Switch to new node capacities, re-packing the stored items with bulk_load
+    // (retained versions keep their nodes)
+    void set_fan_out(const FanOut &fan_out);
+
+    // Number of qualifying children prefetched ahead of the descent at each
+    // internal node during queries (0 disables software prefetching)
+    void set_prefetch_distance(size_t distance) { prefetch_distance_ = distance; }
+    size_t prefetch_distance() const { return prefetch_distance_; }
 
 private:
-    NodePtr root_;       // Root node of the R-Tree
-    size_t min_entries_; // Minimum number of entries per node (except root)
-    size_t max_entries_; // Maximum number of entries per node
+    NodePtr root_;                // Root node of the R-Tree
+    size_t min_entries_;          // Minimum number of entries per internal node (except root)
+    size_t max_entries_;          // Maximum number of entries per internal node
+    size_t min_leaf_entries_;     // Minimum number of entries per leaf (except root)
+    size_t max_leaf_entries_;     // Maximum number of entries per leaf
+    size_t prefetch_distance_ = 4; // Children prefetched per internal node visit
+    size_t buffer_capacity_ = 0;   // Items per internal node buffer (0 = direct inserts)
+    std::map<std::uint64_t, NodePtr> versions_; // Committed roots by version number
+    std::uint64_t last_version_ = 0;
+    size_t version_retention_ = 0; // Newest versions kept (0 = all)
 
     // --- Private Helper Methods (Declarations) ---
 
-    // Choose the best subtree to insert into (minimizes MBR enlargement)
-    RTreeNode *choose_subtree(RTreeNode *node, const Rectangle &item_bounds) const;
+    // Capacities of a node of node's kind (leaf or internal)
+    size_t min_entries_for(const Node *node) const { return node->is_leaf ? min_leaf_entries_ : min_entries_; }
+    size_t max_entries_for(const Node *node) const { return node->is_leaf ? max_leaf_entries_ : max_entries_; }
 
-    // Recursive helper for insertion
-    NodePtr insert_recursive(RTreeNode *node, const DataItem &item);
+    // Choose the best subtree to insert into (minimizes MBR enlargement).
+    // Returns the index of the chosen child.
+    size_t choose_subtree(const Node *node, const rect_type &item_bounds) const;
 
-    // Splits a full node. Returns the newly created node.
-    NodePtr split_node(RTreeNode *node); // Modifies node, returns new node
+    // Makes the node in slot safe to modify: a node shared with a committed
+    // version is replaced by a private copy (its children stay shared)
+    static Node *writable(NodePtr &slot);
+
+    // Root of a retained version (throws std::out_of_range)
+    const Node *version_root(std::uint64_t version) const;
 
-    // Recursive helper for standard spatial search
-    void search_recursive(const RTreeNode *node, const Rectangle &query_rect, std::vector<DataItem> &results) const;
+    // One step of a root-to-leaf descent: the node and the child taken from it
+    struct PathStep
+    {
+        Node *node;
+        size_t child_index;
+    };
+
+    // Walk from node back up a recorded descent path, absorbing (and
+    // propagating) any split. Returns the node split off the root, if any.
+    template <typename Path>
+    NodePtr propagate_up(Path &path, Node *node);
+
+    // Batch insert helper: adds the (curve-sorted) items below node and
+    // returns the siblings split off node, if any
+    std::vector<NodePtr> insert_batch_into(Node *node, std::span<const item_type *const> items);
+
+    // Empties node's buffer one level down (see set_insert_buffering).
+    // Returns the siblings split off node, if any.
+    std::vector<NodePtr> empty_buffer(Node *node);
+
+    // Finds the node storing item (a leaf entry or an internal node's buffer),
+    // recording the descent path to it
+    Node *find_item(Node *node, const item_type &item, std::vector<PathStep> &path) const;
+
+    // Moves every item stored below slot (entries and buffers) into out.
+    // Items of nodes shared with a version, and of every node below them, are
+    // copied instead (shared is set once the recursion is below such a node).
+    static void collect_items(const NodePtr &slot, std::vector<item_type> &out, bool shared = false);
+
+    // Moves all buffered items below slot into out; marks the nodes it touched dirty.
+    // Returns true if anything was collected.
+    bool collect_buffers(NodePtr &slot, std::vector<item_type> &out);
 
-    // Recursive helper for search with population filter
-    void search_pop_recursive(const RTreeNode *node, const Rectangle &query_rect, long min_population, std::vector<DataItem> &results) const;
+    // True if any internal node below node holds buffered items
+    static bool holds_buffered(const Node *node);
 
-    // Recursive helper for printing the tree structure
-    // Requires <iostream> for std::ostream definition
-    void print_node(std::ostream &os, const RTreeNode *node, int indent) const;
+    // Adds new levels above the root until the root stops splitting
+    void grow_root(std::vector<NodePtr> siblings);
+
+    // Orders items along the space-filling curve over their own extent
+    static std::vector<const item_type *> sort_by_curve(std::span<const item_type> items);
+
+    // Splits node until neither it nor any split-off sibling is full.
+    // Returns the split-off siblings.
+    std::vector<NodePtr> split_until_fits(Node *node);
+
+    // Recompute the MBRs of a dirty node and its dirty descendants (post-order)
+    void tighten_node(Node *node) const;
+
+    // Splits a full node. Returns the newly created node.
+    NodePtr split_node(Node *node); // Modifies node, returns new node
+
+    // --- Traversal Engine (definitions in rtree.cpp) ---
+    // Depth-first walk over every node whose MBR satisfies node_pred,
+    // driven by a small explicit stack instead of recursion. Qualifying
+    // children are collected and prefetched before any of them is visited.
+    // visit_node(const Node *, int depth) is called in pre-order. Walks the
+    // live tree (tightening it first) unless a version's root is given.
+    template <typename NodePred, typename NodeVisitor>
+    void walk(NodePred &&node_pred, NodeVisitor &&visit_node, const Node *root = nullptr) const;
+
+    // Query engine shared by all query types: prunes subtrees with node_pred,
+    // tests leaf entry MBRs with leaf_pred (entry points of point leaves with
+    // point_pred) and hands each matching item to visit (which applies any
+    // attribute filter).
+    template <typename NodePred, typename LeafPred, typename PointPred, typename Visitor>
+    void traverse(NodePred &&node_pred, LeafPred &&leaf_pred, PointPred &&point_pred, Visitor &&visit, const Node *root = nullptr) const;
 };
 
+using RTree = BasicRTree<double, 2>;
+using GridRTree = BasicRTree<std::int32_t, 2>;
+
+extern template class BasicRTree<double, 2>;
+extern template class BasicRTree<std::int32_t, 2>;
+extern template class BasicRTree<double, 3>;
+
 #endif // RTREE_H
 
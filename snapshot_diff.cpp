@@ -0,0 +1,304 @@
+#include "snapshot_diff.h"
+#include "leaf_codec.h"
+#include "wal.h" // For crc32_ieee
+
+#include <cstring>   // For std::memcpy, std::memcmp
+#include <stdexcept> // For runtime_error, invalid_argument
+
+// --- Helper Functions ---
+
+namespace
+{
+    const char snapshot_magic[8] = {'R', 'T', 'B', 'S', 'N', 'A', 'P', '1'};
+    const char delta_magic[8] = {'R', 'T', 'D', 'E', 'L', 'T', 'A', '1'};
+    const unsigned curve_bits = 32; // Hilbert keys of order 16 in 2D
+
+    template <typename V>
+    void put(std::vector<char> &out, const V &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(V));
+    }
+
+    // Reader over a byte range that throws when it runs out
+    struct Reader
+    {
+        const char *pos;
+        const char *end;
+
+        template <typename V>
+        V get()
+        {
+            if (static_cast<size_t>(end - pos) < sizeof(V))
+                throw std::runtime_error("Truncated snapshot data");
+            V value;
+            std::memcpy(&value, pos, sizeof(V));
+            pos += sizeof(V);
+            return value;
+        }
+
+        std::span<const char> bytes(std::uint64_t size)
+        {
+            if (static_cast<std::uint64_t>(end - pos) < size)
+                throw std::runtime_error("Truncated snapshot data");
+            std::span<const char> out(pos, static_cast<size_t>(size));
+            pos += size;
+            return out;
+        }
+    };
+
+    // FNV-1a, 64 bit
+    std::uint64_t hash_bytes(std::span<const char> bytes)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (char c : bytes)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void put_layout(std::vector<char> &out, unsigned bucket_bits, const Rectangle &extent)
+    {
+        put(out, static_cast<std::uint32_t>(bucket_bits));
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            put(out, extent.min_corner[i]);
+            put(out, extent.max_corner[i]);
+        }
+    }
+
+    void get_layout(Reader &in, unsigned &bucket_bits, Rectangle &extent)
+    {
+        bucket_bits = in.get<std::uint32_t>();
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            extent.min_corner[i] = in.get<double>();
+            extent.max_corner[i] = in.get<double>();
+        }
+    }
+
+    // Appends a CRC of everything after the magic
+    void seal(std::vector<char> &out)
+    {
+        std::uint32_t crc = crc32_ieee(out.data() + 8, out.size() - 8);
+        put(out, crc);
+    }
+
+    // Checks magic and CRC, returning a reader over the body
+    Reader open_sealed(std::span<const char> bytes, const char (&magic)[8], const char *what)
+    {
+        if (bytes.size() < 8 + sizeof(std::uint32_t) || std::memcmp(bytes.data(), magic, 8) != 0)
+            throw std::runtime_error(std::string("Not a ") + what);
+        std::uint32_t crc;
+        std::memcpy(&crc, bytes.data() + bytes.size() - sizeof(crc), sizeof(crc));
+        Reader in{bytes.data() + 8, bytes.data() + bytes.size() - sizeof(crc)};
+        if (crc32_ieee(in.pos, static_cast<size_t>(in.end - in.pos)) != crc)
+            throw std::runtime_error(std::string("Checksum mismatch in ") + what);
+        return in;
+    }
+}
+
+// --- Construction ---
+
+BucketSnapshot::BucketSnapshot(std::span<const DataItem> items, std::uint64_t version, const Rectangle &extent, unsigned bucket_bits)
+    : version_(version), extent_(extent), bucket_bits_(bucket_bits)
+{
+    if (bucket_bits == 0 || bucket_bits > curve_bits)
+        throw std::invalid_argument("bucket_bits must be between 1 and 32");
+
+    std::map<std::uint32_t, std::vector<DataItem>> grouped;
+    for (const auto &item : items)
+    {
+        auto bucket = static_cast<std::uint32_t>(space_filling_key(item.bounds, extent_) >> (curve_bits - bucket_bits_));
+        grouped[bucket].push_back(item);
+    }
+    for (auto &[bucket, bucket_items] : grouped)
+    {
+        buckets_.emplace(bucket, make_bucket(std::move(bucket_items)));
+    }
+}
+
+BucketSnapshot::Bucket BucketSnapshot::make_bucket(std::vector<DataItem> items)
+{
+    std::sort(items.begin(), items.end(), [](const DataItem &a, const DataItem &b)
+              { return a.id < b.id; });
+    Bucket bucket;
+    CompressedLeaf leaf = CompressedLeaf::encode(items);
+    bucket.bytes.assign(leaf.bytes().begin(), leaf.bytes().end());
+    bucket.hash = hash_bytes(bucket.bytes);
+    return bucket;
+}
+
+std::vector<DataItem> BucketSnapshot::items() const
+{
+    std::vector<DataItem> all;
+    for (const auto &[index, bucket] : buckets_)
+    {
+        std::vector<DataItem> decoded = CompressedLeaf::from_bytes(bucket.bytes).decode();
+        std::move(decoded.begin(), decoded.end(), std::back_inserter(all));
+    }
+    return all;
+}
+
+// --- Full Snapshots ---
+// [magic][u64 version][u32 bucket bits][4 x double extent][u64 buckets]
+// then per bucket [u32 index][u64 size][bytes], then [u32 CRC]
+
+std::vector<char> BucketSnapshot::serialize() const
+{
+    std::vector<char> out(snapshot_magic, snapshot_magic + 8);
+    put(out, version_);
+    put_layout(out, bucket_bits_, extent_);
+    put(out, static_cast<std::uint64_t>(buckets_.size()));
+    for (const auto &[index, bucket] : buckets_)
+    {
+        put(out, index);
+        put(out, static_cast<std::uint64_t>(bucket.bytes.size()));
+        out.insert(out.end(), bucket.bytes.begin(), bucket.bytes.end());
+    }
+    seal(out);
+    return out;
+}
+
+BucketSnapshot BucketSnapshot::deserialize(std::span<const char> bytes)
+{
+    Reader in = open_sealed(bytes, snapshot_magic, "bucket snapshot");
+    BucketSnapshot snapshot;
+    snapshot.version_ = in.get<std::uint64_t>();
+    get_layout(in, snapshot.bucket_bits_, snapshot.extent_);
+    std::uint64_t count = in.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        auto index = in.get<std::uint32_t>();
+        std::span<const char> encoded = in.bytes(in.get<std::uint64_t>());
+        Bucket bucket;
+        bucket.bytes.assign(encoded.begin(), encoded.end());
+        bucket.hash = hash_bytes(bucket.bytes);
+        snapshot.buckets_.emplace(index, std::move(bucket));
+    }
+    return snapshot;
+}
+
+// --- Deltas ---
+// [magic][u64 base version][u64 target version][u32 bucket bits][4 x double extent][u64 entries]
+// then per changed bucket [u32 index][u64 hash of the replaced bucket, 0 if none][u64 size, 0 to delete][bytes],
+// then [u32 CRC]
+
+std::vector<char> BucketSnapshot::diff(const BucketSnapshot &newer) const
+{
+    if (newer.bucket_bits_ != bucket_bits_ || std::memcmp(&newer.extent_, &extent_, sizeof(extent_)) != 0)
+        throw std::invalid_argument("Snapshots with different bucket layouts cannot be diffed");
+
+    std::vector<char> body;
+    std::uint64_t entries = 0;
+    auto add = [&](std::uint32_t index, const Bucket *old_bucket, const Bucket *new_bucket)
+    {
+        put(body, index);
+        put(body, old_bucket ? old_bucket->hash : std::uint64_t(0));
+        put(body, static_cast<std::uint64_t>(new_bucket ? new_bucket->bytes.size() : 0));
+        if (new_bucket)
+            body.insert(body.end(), new_bucket->bytes.begin(), new_bucket->bytes.end());
+        ++entries;
+    };
+
+    // Merge the two sorted bucket maps
+    auto old_it = buckets_.begin();
+    auto new_it = newer.buckets_.begin();
+    while (old_it != buckets_.end() || new_it != newer.buckets_.end())
+    {
+        if (new_it == newer.buckets_.end() || (old_it != buckets_.end() && old_it->first < new_it->first))
+        {
+            add(old_it->first, &old_it->second, nullptr);
+            ++old_it;
+        }
+        else if (old_it == buckets_.end() || new_it->first < old_it->first)
+        {
+            add(new_it->first, nullptr, &new_it->second);
+            ++new_it;
+        }
+        else
+        {
+            if (old_it->second.bytes != new_it->second.bytes)
+                add(old_it->first, &old_it->second, &new_it->second);
+            ++old_it;
+            ++new_it;
+        }
+    }
+
+    std::vector<char> out(delta_magic, delta_magic + 8);
+    put(out, version_);
+    put(out, newer.version_);
+    put_layout(out, bucket_bits_, extent_);
+    put(out, entries);
+    out.insert(out.end(), body.begin(), body.end());
+    seal(out);
+    return out;
+}
+
+void BucketSnapshot::apply(std::span<const char> delta, RTree *tree)
+{
+    Reader in = open_sealed(delta, delta_magic, "snapshot delta");
+    std::uint64_t base_version = in.get<std::uint64_t>();
+    std::uint64_t target_version = in.get<std::uint64_t>();
+    unsigned bucket_bits;
+    Rectangle extent;
+    get_layout(in, bucket_bits, extent);
+    if (base_version != version_ || bucket_bits != bucket_bits_ || std::memcmp(&extent, &extent_, sizeof(extent_)) != 0)
+        throw std::runtime_error("Snapshot delta was made for version " + std::to_string(base_version) +
+                                 ", not version " + std::to_string(version_));
+
+    // Validate every entry before changing anything
+    struct Change
+    {
+        std::uint32_t index;
+        std::span<const char> bytes;
+    };
+    std::vector<Change> changes;
+    std::uint64_t entries = in.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < entries; ++i)
+    {
+        Change change;
+        change.index = in.get<std::uint32_t>();
+        std::uint64_t old_hash = in.get<std::uint64_t>();
+        change.bytes = in.bytes(in.get<std::uint64_t>());
+        auto current = buckets_.find(change.index);
+        if ((current == buckets_.end() ? 0 : current->second.hash) != old_hash)
+            throw std::runtime_error("Snapshot delta does not match bucket " + std::to_string(change.index) + " of this replica");
+        if (!change.bytes.empty())
+            CompressedLeaf::from_bytes(change.bytes); // Throws if malformed
+        changes.push_back(change);
+    }
+
+    // Take out the old contents of every changed bucket before inserting any
+    // new ones: an item that moved to a bucket applied earlier would otherwise
+    // be inserted there and then removed (by id) with its old bucket
+    if (tree)
+    {
+        for (const Change &change : changes)
+        {
+            auto current = buckets_.find(change.index);
+            if (current == buckets_.end())
+                continue;
+            for (const auto &item : CompressedLeaf::from_bytes(current->second.bytes).decode())
+                tree->remove(item);
+        }
+    }
+
+    for (const Change &change : changes)
+    {
+        if (change.bytes.empty())
+        {
+            buckets_.erase(change.index);
+            continue;
+        }
+        Bucket bucket;
+        bucket.bytes.assign(change.bytes.begin(), change.bytes.end());
+        bucket.hash = hash_bytes(bucket.bytes);
+        if (tree)
+            tree->insert_batch(CompressedLeaf::from_bytes(bucket.bytes).decode());
+        buckets_[change.index] = std::move(bucket);
+    }
+    version_ = target_version;
+}
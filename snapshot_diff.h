@@ -0,0 +1,68 @@
+#ifndef SNAPSHOT_DIFF_H
+#define SNAPSHOT_DIFF_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <span>
+
+// --- Bucketed Snapshots and Deltas ---
+// A snapshot format that supports compact deltas between versions. Items are
+// assigned to buckets by the Hilbert key of their center within a fixed
+// extent: bucket b holds the keys whose top bucket_bits bits equal b, so a
+// bucket is a contiguous stretch of the curve and the assignment of an item
+// never depends on the rest of the data. Each bucket is stored as a
+// CompressedLeaf of its items sorted by id, which makes the encoding (and
+// therefore the comparison of two versions) deterministic.
+//
+// diff() lists the buckets whose bytes changed, together with a hash of the
+// bucket each one replaces. apply() checks those hashes, swaps the buckets
+// in, and can update a replica's RTree in place by removing the old items of
+// each changed bucket and inserting the new ones. A small update therefore
+// ships only the few buckets it touched instead of the whole index.
+class BucketSnapshot
+{
+public:
+    static constexpr unsigned default_bucket_bits = 12;
+
+    BucketSnapshot(std::span<const DataItem> items, std::uint64_t version,
+                   const Rectangle &extent = Rectangle(-180.0, -90.0, 180.0, 90.0), unsigned bucket_bits = default_bucket_bits);
+
+    // Full snapshot, e.g. to seed a new replica
+    std::vector<char> serialize() const;
+    // Throws std::runtime_error if bytes are not an intact snapshot
+    static BucketSnapshot deserialize(std::span<const char> bytes);
+
+    // Delta that turns *this into newer (both must use the same extent and bucket_bits)
+    std::vector<char> diff(const BucketSnapshot &newer) const;
+
+    // Apply a delta made by base.diff(newer), where base has this version and
+    // contents; afterwards *this equals newer. If tree is given (holding this
+    // snapshot's items), it is updated in place. Throws std::runtime_error
+    // (changing nothing) if the delta is corrupt or was made from another base.
+    void apply(std::span<const char> delta, RTree *tree = nullptr);
+
+    std::vector<DataItem> items() const;
+    std::uint64_t version() const { return version_; }
+    size_t bucket_count() const { return buckets_.size(); }
+
+private:
+    struct Bucket
+    {
+        std::vector<char> bytes; // Encoded CompressedLeaf
+        std::uint64_t hash = 0;
+    };
+
+    BucketSnapshot() = default;
+
+    static Bucket make_bucket(std::vector<DataItem> items);
+
+    std::uint64_t version_ = 0;
+    Rectangle extent_;
+    unsigned bucket_bits_ = default_bucket_bits;
+    std::map<std::uint32_t, Bucket> buckets_; // Only non-empty buckets
+};
+
+#endif // SNAPSHOT_DIFF_H
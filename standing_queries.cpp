@@ -0,0 +1,119 @@
+#include "standing_queries.h"
+
+#include <stdexcept> // For std::out_of_range
+
+MonitoredRTree::MonitoredRTree(size_t min_entries, size_t max_entries)
+    : tree_(min_entries, max_entries)
+{
+}
+
+// --- Standing Queries ---
+
+int MonitoredRTree::register_query(const Rectangle &query_rect, long min_population)
+{
+    int query_id = next_query_id_++;
+    queries_.add({query_id, query_rect, min_population});
+    return query_id;
+}
+
+bool MonitoredRTree::unregister_query(int query_id)
+{
+    return queries_.remove(query_id);
+}
+
+std::vector<DataItem> MonitoredRTree::results(int query_id) const
+{
+    const Subscription *query = queries_.find(query_id);
+    if (!query)
+        throw std::out_of_range("MonitoredRTree: unknown query " + std::to_string(query_id));
+    return tree_.search_with_population(query->rect, query->min_population);
+}
+
+std::vector<int> MonitoredRTree::matching_queries(const DataItem &item) const
+{
+    return queries_.match(item);
+}
+
+void MonitoredRTree::emit(const std::vector<int> &before, const std::vector<int> &after, const DataItem &old_item, const DataItem &new_item)
+{
+    // Both lists are sorted, so one merge pass classifies every affected query
+    size_t i = 0, j = 0;
+    while (i < before.size() || j < after.size())
+    {
+        if (j == after.size() || (i < before.size() && before[i] < after[j]))
+        {
+            deltas_.push_back({before[i++], StandingQueryDelta::Kind::exit, old_item});
+        }
+        else if (i == before.size() || after[j] < before[i])
+        {
+            deltas_.push_back({after[j++], StandingQueryDelta::Kind::enter, new_item});
+        }
+        else
+        {
+            deltas_.push_back({after[j], StandingQueryDelta::Kind::update, new_item});
+            ++i;
+            ++j;
+        }
+    }
+}
+
+std::vector<StandingQueryDelta> MonitoredRTree::drain_deltas()
+{
+    std::vector<StandingQueryDelta> drained;
+    drained.swap(deltas_);
+    return drained;
+}
+
+// --- Updates ---
+
+void MonitoredRTree::insert(const DataItem &item)
+{
+    std::vector<int> before;
+    DataItem old_item;
+    auto existing = items_.find(item.id);
+    if (existing != items_.end())
+    {
+        old_item = existing->second;
+        before = matching_queries(old_item);
+        tree_.remove(old_item);
+        existing->second = item;
+    }
+    else
+    {
+        items_.emplace(item.id, item);
+    }
+    tree_.insert(item);
+    emit(before, matching_queries(item), old_item, item);
+}
+
+void MonitoredRTree::insert_batch(std::span<const DataItem> items)
+{
+    std::vector<DataItem> added;
+    for (const auto &item : items)
+    {
+        if (items_.count(item.id))
+        {
+            // An update (possibly of an item added earlier in this batch)
+            tree_.insert_batch(added);
+            added.clear();
+            insert(item);
+            continue;
+        }
+        items_.emplace(item.id, item);
+        emit({}, matching_queries(item), item, item);
+        added.push_back(item);
+    }
+    tree_.insert_batch(added);
+}
+
+bool MonitoredRTree::remove(int id)
+{
+    auto existing = items_.find(id);
+    if (existing == items_.end())
+        return false;
+    DataItem old_item = std::move(existing->second);
+    items_.erase(existing);
+    tree_.remove(old_item);
+    emit(matching_queries(old_item), {}, old_item, old_item);
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef STANDING_QUERIES_H
+#define STANDING_QUERIES_H
+
+#include "rtree.h"
+#include "query_index.h"
+
+#include <vector>
+#include <span>
+#include <unordered_map> // Stored items by id
+#include <limits>        // For the "no population filter" default
+
+// --- Standing Query Deltas ---
+// A change to the result of a standing query
+struct StandingQueryDelta
+{
+    enum class Kind
+    {
+        enter,  // The item now matches (inserted, or moved/changed into the query)
+        exit,   // The item no longer matches (removed, or moved/changed out of it)
+        update, // The item still matches and was written again (e.g. its population changed)
+    };
+
+    int query_id;
+    Kind kind;
+    DataItem item; // The new version (for exits: the version that left)
+};
+
+// --- Monitored R-Tree ---
+// An RTree with registered standing queries (rectangle + minimum population,
+// like search_with_population). The queries live in a QueryIndex, so every
+// insert, update and removal is matched against the queries near the item
+// only, and the resulting changes to their results are queued as deltas, so a
+// client that polls drain_deltas() sees the same changes it would get by
+// re-running every query, without re-evaluating any of them. Not thread-safe.
+class MonitoredRTree
+{
+public:
+    explicit MonitoredRTree(size_t min_entries = 4, size_t max_entries = 16);
+
+    // Register a standing query; returns its id. Items already stored are not
+    // reported as deltas: call results() for the initial result.
+    int register_query(const Rectangle &query_rect, long min_population = std::numeric_limits<long>::min());
+    bool unregister_query(int query_id);
+
+    // Current result of a registered query (throws std::out_of_range for an unknown id)
+    std::vector<DataItem> results(int query_id) const;
+
+    // Insert item, or update the stored item with the same id
+    void insert(const DataItem &item);
+
+    // Insert many items; new ids are added with one RTree::insert_batch
+    void insert_batch(std::span<const DataItem> items);
+
+    // Remove the item with the given id; false if it is not stored
+    bool remove(int id);
+
+    // Deltas queued since the last call, in the order the changes happened
+    std::vector<StandingQueryDelta> drain_deltas();
+
+    const RTree &tree() const { return tree_; }
+    size_t size() const { return items_.size(); }
+    size_t query_count() const { return queries_.size(); }
+
+private:
+    // Ids of the registered queries item satisfies, in ascending order
+    std::vector<int> matching_queries(const DataItem &item) const;
+
+    // Queue the deltas between the query sets matched by the old and new version
+    void emit(const std::vector<int> &before, const std::vector<int> &after, const DataItem &old_item, const DataItem &new_item);
+
+    RTree tree_;
+    std::unordered_map<int, DataItem> items_; // Stored version of every id (to diff and remove it)
+    QueryIndex queries_;
+    int next_query_id_ = 1;
+    std::vector<StandingQueryDelta> deltas_;
+};
+
+#endif // STANDING_QUERIES_H
@@ -0,0 +1,180 @@
+#include "temporal_rtree.h"
+
+#include <algorithm> // For std::min, std::max
+#include <cmath>     // For std::isfinite, std::abs
+#include <stdexcept> // For std::invalid_argument
+
+// --- Construction ---
+
+TemporalRTree::TemporalRTree(size_t min_entries, size_t max_entries)
+    : tree_(min_entries, max_entries)
+{
+}
+
+TemporalRTree::Box TemporalRTree::index_box(const Rectangle &bounds, double from, double to) const
+{
+    return Box({bounds.min_corner.x, bounds.min_corner.y, std::max(-open_end_, from)},
+               {bounds.max_corner.x, bounds.max_corner.y, std::min(open_end_, to)});
+}
+
+void TemporalRTree::cover_time(double t)
+{
+    if (!std::isfinite(t) || std::abs(t) < open_end_)
+        return;
+    // Doubling keeps the number of rebuilds logarithmic in the time range
+    open_end_ = 2 * std::abs(t);
+    if (tree_.empty())
+        return;
+    std::vector<Tree::item_type> entries;
+    for (size_t version = 0; version < versions_.size(); ++version)
+    {
+        // Versions closed at their own start are not indexed
+        if (versions_[version].valid_from < versions_[version].valid_to)
+            entries.push_back(index_entry(version));
+    }
+    tree_.bulk_load(entries);
+}
+
+TemporalRTree::Tree::item_type TemporalRTree::index_entry(size_t version) const
+{
+    const TemporalDataItem &item = versions_[version];
+    return Tree::item_type(static_cast<int>(version), "", 0,
+                           index_box(item.bounds, item.valid_from, item.valid_to));
+}
+
+// --- Updates ---
+
+void TemporalRTree::insert(const TemporalDataItem &item)
+{
+    insert_batch(std::span<const TemporalDataItem>(&item, 1));
+}
+
+void TemporalRTree::insert_batch(std::span<const TemporalDataItem> items)
+{
+    // Validate the whole batch before anything is stored, so a bad item leaves the tree unchanged
+    for (const auto &item : items)
+    {
+        if (!(item.valid_from < item.valid_to))
+        {
+            throw std::invalid_argument("TemporalRTree: item " + std::to_string(item.id) + " has an empty validity interval");
+        }
+    }
+    for (const auto &item : items)
+    {
+        cover_time(item.valid_from);
+        cover_time(item.valid_to);
+    }
+
+    std::vector<Tree::item_type> entries;
+    entries.reserve(items.size());
+    for (const auto &item : items)
+    {
+        size_t version = versions_.size();
+        versions_.push_back(item);
+        entries.push_back(index_entry(version));
+
+        auto [latest, inserted] = latest_.try_emplace(item.id, version);
+        if (!inserted && versions_[latest->second].valid_from <= item.valid_from)
+        {
+            latest->second = version;
+        }
+    }
+    // The first batch (typically the history loaded at startup) is packed
+    if (tree_.empty())
+        tree_.bulk_load(entries);
+    else
+        tree_.insert_batch(entries);
+}
+
+bool TemporalRTree::update_population(int id, long population, double at)
+{
+    auto latest = latest_.find(id);
+    if (latest == latest_.end() || !versions_[latest->second].valid_at(at))
+        return false;
+
+    TemporalDataItem &current = versions_[latest->second];
+    if (current.valid_from == at)
+    {
+        // Same start: correct the version in place (population is not indexed)
+        current.population = population;
+        return true;
+    }
+    TemporalDataItem next = current;
+    next.population = population;
+    next.valid_from = at;
+    close(id, at);
+    insert(next);
+    return true;
+}
+
+bool TemporalRTree::close(int id, double at)
+{
+    auto latest = latest_.find(id);
+    if (latest == latest_.end() || !versions_[latest->second].valid_at(at))
+        return false;
+
+    // The index box shrinks along time, so the entry is removed and re-added
+    cover_time(at);
+    size_t version = latest->second;
+    tree_.remove(index_entry(version));
+    versions_[version].valid_to = at;
+    if (versions_[version].valid_from < at)
+    {
+        tree_.insert(index_entry(version));
+    }
+    // A version closed at its own start never existed: it stays in versions_
+    // (positions are index ids) but is no longer indexed or reported
+    return true;
+}
+
+// --- Queries ---
+
+template <typename Visitor>
+void TemporalRTree::for_each_candidate(const Rectangle &query_rect, double from, double to, Visitor &&visit) const
+{
+    // Queries beyond open_end_ still meet open-ended versions
+    Box query = index_box(query_rect, std::min(from, open_end_), std::max(to, -open_end_));
+    for (const auto &entry : tree_.search(query))
+    {
+        visit(versions_[static_cast<size_t>(entry.id)]);
+    }
+}
+
+std::vector<TemporalDataItem> TemporalRTree::search_at(const Rectangle &query_rect, double t) const
+{
+    std::vector<TemporalDataItem> results;
+    for_each_candidate(query_rect, t, t, [&](const TemporalDataItem &item)
+                       {
+                           // Index boxes are closed at valid_to, intervals are not
+                           if (item.valid_at(t))
+                               results.push_back(item); });
+    return results;
+}
+
+std::vector<TemporalDataItem> TemporalRTree::search_with_population_at(const Rectangle &query_rect, double t, long min_population) const
+{
+    std::vector<TemporalDataItem> results;
+    for_each_candidate(query_rect, t, t, [&](const TemporalDataItem &item)
+                       {
+                           if (item.valid_at(t) && item.population >= min_population)
+                               results.push_back(item); });
+    return results;
+}
+
+size_t TemporalRTree::count_at(const Rectangle &query_rect, double t) const
+{
+    size_t matches = 0;
+    for_each_candidate(query_rect, t, t, [&](const TemporalDataItem &item)
+                       { matches += item.valid_at(t); });
+    return matches;
+}
+
+std::vector<TemporalDataItem> TemporalRTree::search_during(const Rectangle &query_rect, double from, double to) const
+{
+    std::vector<TemporalDataItem> results;
+    for_each_candidate(query_rect, from, to, [&](const TemporalDataItem &item)
+                       {
+                           if (item.valid_during(from, to))
+                               results.push_back(item); });
+    return results;
+}
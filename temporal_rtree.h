@@ -0,0 +1,100 @@
+#ifndef TEMPORAL_RTREE_H
+#define TEMPORAL_RTREE_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <span>
+#include <limits>        // For the open-ended interval end
+#include <unordered_map> // Latest version of each id
+
+// --- Temporal Data Item ---
+// A DataItem that is valid during [valid_from, valid_to). Attributes that
+// change over time (e.g. a yearly population figure) are stored as several
+// versions of the same id with adjacent intervals.
+struct TemporalDataItem
+{
+    static constexpr double forever = std::numeric_limits<double>::infinity();
+
+    int id;
+    std::string name;
+    long population;
+    Rectangle bounds;
+    double valid_from;
+    double valid_to; // Exclusive; forever for the current version
+
+    TemporalDataItem(int id_ = 0, std::string name_ = "", long pop_ = 0, Rectangle b_ = Rectangle(),
+                     double from_ = 0, double to_ = forever)
+        : id(id_), name(std::move(name_)), population(pop_), bounds(b_), valid_from(from_), valid_to(to_) {}
+
+    bool valid_at(double t) const { return valid_from <= t && t < valid_to; }
+
+    // Overlaps the time range [from, to]
+    bool valid_during(double from, double to) const { return valid_from <= to && from < valid_to; }
+};
+
+// --- Temporal R-Tree ---
+// Indexes item versions as boxes in (x, y, time) in a 3D RTree, so a
+// rectangle x time-instant (or time-range) query prunes subtrees on space and
+// time at once, and all years live in one index instead of one tree per year.
+// Open-ended versions are indexed up to open_end() on the time axis, which
+// keeps box volumes finite for choose_subtree. Time is any double scale
+// (years, epoch seconds, ...): open_end() is kept beyond every finite time
+// stored, and the index is rebuilt in the rare case a later time passes it.
+class TemporalRTree
+{
+public:
+    explicit TemporalRTree(size_t min_entries = 4, size_t max_entries = 16);
+
+    // Add one version. Throws std::invalid_argument unless valid_from < valid_to.
+    void insert(const TemporalDataItem &item);
+    void insert_batch(std::span<const TemporalDataItem> items);
+
+    // Close the latest version of id at time `at` and start a new version with
+    // the given population, valid from `at` until the old version's end.
+    // Returns false if id is unknown or its latest version is not valid at `at`.
+    bool update_population(int id, long population, double at);
+
+    // End the latest version of id at `at` (the item no longer exists afterwards).
+    // Returns false if id is unknown or its latest version is not valid at `at`.
+    bool close(int id, double at);
+
+    // Versions valid at instant t
+    std::vector<TemporalDataItem> search_at(const Rectangle &query_rect, double t) const;
+    std::vector<TemporalDataItem> search_with_population_at(const Rectangle &query_rect, double t, long min_population) const;
+    size_t count_at(const Rectangle &query_rect, double t) const;
+
+    // Versions valid at any time in [from, to]
+    std::vector<TemporalDataItem> search_during(const Rectangle &query_rect, double from, double to) const;
+
+    size_t size() const { return versions_.size(); } // Stored versions
+
+    // Time-axis position standing in for `forever` (and its negative for -forever)
+    double open_end() const { return open_end_; }
+
+private:
+    using Tree = BasicRTree<double, 3>;
+    using Box = Tree::rect_type;
+
+    // (x, y, time) box of a version; only infinite times are affected by the
+    // clamping, since every finite time lies within +-open_end_
+    Box index_box(const Rectangle &bounds, double from, double to) const;
+
+    // Move open_end_ past |t| (for finite t), re-indexing the stored versions if it moved
+    void cover_time(double t);
+
+    // Calls visit(version) for every version whose box meets the query box
+    template <typename Visitor>
+    void for_each_candidate(const Rectangle &query_rect, double from, double to, Visitor &&visit) const;
+
+    // Index entries use the position in versions_ as their id, since one id
+    // may have several versions in the same leaf
+    Tree::item_type index_entry(size_t version) const;
+
+    Tree tree_;
+    double open_end_ = 1; // Exceeds the magnitude of every finite time stored
+    std::vector<TemporalDataItem> versions_;
+    std::unordered_map<int, size_t> latest_; // Id -> its version with the latest valid_from
+};
+
+#endif // TEMPORAL_RTREE_H
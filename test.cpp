@@ -1,8 +1,28 @@
 #include "rtree.h"
+#include "lsm_rtree.h"
+#include "durable_rtree.h"
+#include "paged_rtree.h"
+#include "compressed_rtree.h"
+#include "snapshot_diff.h"
+#include "temporal_rtree.h"
+#include "tpr_tree.h"
+#include "standing_queries.h"
+#include "query_index.h"
+#include "index_backends.h"
+#include "grid_forest.h"
+#include "fanout_tuning.h"
 #include <cassert> // For basic assertions
 #include <vector>
 #include <iostream>
 #include <algorithm> // For std::any_of
+#include <fstream>    // For corrupting a log file on purpose
+#include <filesystem> // For a scratch store directory
+#include <random>     // For arbitrary-precision coordinates
+#include <cmath>      // For std::round
+#include <limits>     // For the "no population filter" value
+#include <map>
+#include <set>        // For replaying standing query deltas
+#include <sstream>    // For reading print_structure output
 
 // --- Helper Functions for Tests ---
 
@@ -19,14 +39,25 @@ bool rects_equal(const Rectangle &r1, const Rectangle &r2, double tolerance = 1e
            points_equal(r1.max_corner, r2.max_corner, tolerance);
 }
 
-// Check if a specific DataItem (by ID) exists in a vector of DataItems
-bool contains_item_id(const std::vector<DataItem> &items, int target_id)
+// Check if a specific item (by ID) exists in a vector of DataItems (or TemporalDataItems)
+template <typename Item>
+bool contains_item_id(const std::vector<Item> &items, int target_id)
 {
     return std::any_of(items.begin(), items.end(),
-                       [target_id](const DataItem &item)
+                       [target_id](const Item &item)
                        { return item.id == target_id; });
 }
 
+// Ids of the items found, sorted, for comparing results regardless of order
+std::vector<int> sorted_ids(const std::vector<DataItem> &found)
+{
+    std::vector<int> result;
+    for (const auto &item : found)
+        result.push_back(item.id);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
 // --- Test Functions ---
 
 void test_rectangle_operations()
@@ -37,6 +68,7 @@ void test_rectangle_operations()
     Rectangle r3(4, 4, 5, 5);
     Rectangle r4(0.5, 0.5, 1.5, 1.5); // Contained within r1
     Rectangle r_invalid(5, 5, 4, 4);  // Invalid rectangle
+    Rectangle r_none = Rectangle::empty(); // Empty-box sentinel
 
     // Area
     assert(std::abs(r1.area() - 4.0) < 1e-9);
@@ -73,7 +105,7 @@ void test_rectangle_operations()
     r_expand.expand(r2); // Expand r1 to include r2
     assert(rects_equal(r_expand, Rectangle(0, 0, 3, 3)));
     r_expand = r1;
-    r_expand.expand(r_invalid); // Expanding by invalid should not change
+    r_expand.expand(r_none); // Expanding by the empty box should not change
     assert(rects_equal(r_expand, r1));
     Rectangle r_empty;
     r_empty.expand(r1); // Expanding empty by valid makes it valid
@@ -84,22 +116,73 @@ void test_rectangle_operations()
     assert(rects_equal(combined12, Rectangle(0, 0, 3, 3)));
     Rectangle combined13 = Rectangle::combine(r1, r3);
     assert(rects_equal(combined13, Rectangle(0, 0, 5, 5)));
-    Rectangle combined_invalid = Rectangle::combine(r1, r_invalid);
-    assert(rects_equal(combined_invalid, r1)); // Combine with invalid returns the valid one
-    Rectangle combined_both_invalid = Rectangle::combine(r_invalid, r_invalid);
-    assert(combined_both_invalid.area() == 0.0); // Combining two invalids gives invalid
+    Rectangle combined_empty = Rectangle::combine(r1, r_none);
+    assert(rects_equal(combined_empty, r1)); // Combine with the empty box returns the other one
+    Rectangle combined_both_empty = Rectangle::combine(r_none, r_none);
+    assert(combined_both_empty.area() == 0.0 && !combined_both_empty.is_valid()); // Combining two empties stays empty
+    assert(Rectangle::combine(r_invalid, r_invalid).area() == 0.0);              // Inverted boxes have zero area
 
     // Area Increase
     assert(std::abs(r1.area_increase(r2) - (combined12.area() - r1.area())) < 1e-9); // 9-4=5
     assert(std::abs(r1.area_increase(r3) - (combined13.area() - r1.area())) < 1e-9); // 25-4=21
     assert(std::abs(r1.area_increase(r4) - 0.0) < 1e-9);                             // r4 is contained, no increase
-    assert(std::abs(r1.area_increase(r_invalid) - 0.0) < 1e-9);                      // Increase by invalid is 0
+    assert(std::abs(r1.area_increase(r_none) - 0.0) < 1e-9);                         // Increase by the empty box is 0
     Rectangle r_empty2;
     assert(std::abs(r_empty2.area_increase(r1) - r1.area()) < 1e-9); // Increase for empty is area of other
 
+    // Empty-box sentinel
+    assert(!Rectangle().is_valid()); // Default construction is empty, not (0,0)-(0,0)
+    assert(!r_none.intersects(r1) && !r1.intersects(r_none));
+    assert(!r_none.contains(Point(0, 0)));
+
+    // Batch kernels
+    std::vector<Rectangle> box_storage = {r1, r2, r3, r4};
+    std::span<const Rectangle> boxes(box_storage);
+    std::vector<std::uint8_t> mask(boxes.size());
+    assert(intersect_mask(boxes, Rectangle(1.8, 1.8, 2.5, 2.5), mask) == 2);
+    assert(mask[0] == 1 && mask[1] == 1 && mask[2] == 0 && mask[3] == 0);
+    assert(rects_equal(combine_all(boxes), Rectangle(0, 0, 5, 5)));
+    std::vector<double> increases(boxes.size());
+    area_increases(boxes, r4, increases);
+    assert(std::abs(increases[0]) < 1e-9 && std::abs(increases[2] - (4.5 * 4.5 - 1.0)) < 1e-9);
+
     std::cout << "Rectangle Operations Tests Passed!\n";
 }
 
+void test_templated_geometry()
+{
+    std::cout << "Running Templated Geometry Tests...\n";
+    using GridRect = BasicRectangle<std::int32_t, 2>;
+    using Box3 = BasicRectangle<double, 3>;
+
+    // Geometry kernels are constexpr, so they can be checked at compile time
+    static_assert(GridRect(0, 0, 2, 2).area() == 4.0);
+    static_assert(GridRect(0, 0, 2, 2).intersects(GridRect(2, 2, 3, 3)));
+    static_assert(!GridRect(0, 0, 2, 2).intersects(GridRect(3, 0, 4, 2)));
+    static_assert(GridRect::combine(GridRect(0, 0, 1, 1), GridRect(4, 5, 6, 7)).area() == 42.0);
+    static_assert(2 * sizeof(GridRect) == sizeof(Rectangle)); // Half the memory of double boxes
+
+    // Integer-grid tree
+    GridRTree grid_tree(2, 4);
+    for (std::int32_t i = 0; i < 20; ++i)
+    {
+        grid_tree.insert(BasicDataItem<std::int32_t, 2>(i, "Tile", i * 1000, GridRect(i * 10, 0, i * 10 + 5, 5)));
+    }
+    auto grid_results = grid_tree.search(GridRect(0, 0, 25, 5)); // Tiles 0, 1, 2
+    assert(grid_results.size() == 3);
+    grid_results = grid_tree.search_with_population(GridRect(0, 0, 1000, 5), 15000); // Tiles 15..19
+    assert(grid_results.size() == 5);
+
+    // Three-dimensional boxes
+    Box3 cube(BasicPoint<double, 3>(0, 0, 0), BasicPoint<double, 3>(2, 2, 2));
+    Box3 other(BasicPoint<double, 3>(1, 1, 3), BasicPoint<double, 3>(3, 3, 4));
+    assert(std::abs(cube.area() - 8.0) < 1e-9);
+    assert(!cube.intersects(other)); // Separated on the third axis only
+    assert(std::abs(cube.area_increase(other) - (36.0 - 8.0)) < 1e-9);
+
+    std::cout << "Templated Geometry Tests Passed!\n";
+}
+
 void test_rtree_basic_operations()
 {
     std::cout << "Running RTree Basic Operations Tests...\n";
@@ -159,7 +242,7 @@ void test_rtree_basic_operations()
     assert(results.size() == 1);
     assert(contains_item_id(results, 4));
 
-    results = tree.search(Rectangle(0, 4, 3, 8)); // Should find item 3
+    results = tree.search(Rectangle(0, 4, 2.9, 8)); // Should find item 3 (stops short of item 5's corner at (3,4))
     assert(results.size() == 1);
     assert(contains_item_id(results, 3));
 
@@ -231,18 +314,1498 @@ void test_rtree_population_query()
     std::cout << "RTree Population Query Test Passed!\n";
 }
 
+void test_traversal_queries()
+{
+    std::cout << "Running Traversal Engine Query Tests...\n";
+    RTree tree(2, 4);
+    std::vector<DataItem> items;
+    // 30x30 grid of unit boxes gives a tree several levels deep
+    for (int row = 0; row < 30; ++row)
+    {
+        for (int col = 0; col < 30; ++col)
+        {
+            DataItem item(row * 30 + col, "Cell", (row + col) * 1000, Rectangle(col, row, col + 0.5, row + 0.5));
+            items.push_back(item);
+            tree.insert(item);
+        }
+    }
+
+    Rectangle query(4.75, 9.75, 10.25, 12.25);
+    size_t expected_hits = 0, expected_contained = 0, expected_pop = 0;
+    for (const auto &item : items)
+    {
+        expected_hits += item.bounds.intersects(query);
+        expected_contained += query.contains(item.bounds);
+        expected_pop += item.bounds.intersects(query) && item.population >= 18000;
+    }
+
+    assert(tree.search(query).size() == expected_hits);
+    assert(tree.count(query) == expected_hits);
+    assert(tree.search_contained(query).size() == expected_contained);
+    assert(expected_contained < expected_hits); // Edge cells overlap but are not contained
+    assert(tree.search_with_population(query, 18000).size() == expected_pop);
+    assert(tree.count(Rectangle(-10, -10, 100, 100)) == items.size());
+    assert(tree.count(Rectangle(100, 100, 101, 101)) == 0);
+
+    // Node layout: nodes and their entry MBR arrays start on cache-line boundaries
+    static_assert(alignof(RTreeNode) == cache_line_size);
+    RTreeNode::BoxArray box_array(5, Rectangle(0, 0, 1, 1));
+    assert(reinterpret_cast<std::uintptr_t>(box_array.data()) % cache_line_size == 0);
+    RTreeNode layout_node;
+    auto hot_end = reinterpret_cast<const char *>(&layout_node.entry_points + 1) - reinterpret_cast<const char *>(&layout_node);
+    assert(hot_end <= static_cast<std::ptrdiff_t>(cache_line_size)); // Flags and both entry array headers share one line
+    assert(reinterpret_cast<const char *>(&layout_node.buffer) > reinterpret_cast<const char *>(&layout_node.data_entries));
+
+    // Prefetching is only a hint: results must not depend on the distance
+    for (size_t distance : {0, 1, 16})
+    {
+        tree.set_prefetch_distance(distance);
+        assert(tree.count(query) == expected_hits);
+    }
+
+    std::cout << "Traversal Engine Query Tests Passed!\n";
+}
+
+void test_insert_descent_path()
+{
+    std::cout << "Running Insert Descent Path Tests...\n";
+    // Minimum fan-out makes the tree deep, so splits propagate through many levels
+    RTree tree(2, 3);
+    const int item_count = 500;
+    for (int i = item_count - 1; i >= 0; --i)
+    {
+        double x = (i * 37) % 101, y = (i * 53) % 97;
+        tree.insert(DataItem(i, "Item", i, Rectangle(x, y, x + 0.5, y + 0.5)));
+    }
+
+    // Every item must be reachable through correctly maintained MBRs
+    for (int i = 0; i < item_count; ++i)
+    {
+        double x = (i * 37) % 101, y = (i * 53) % 97;
+        std::vector<DataItem> results = tree.search_contained(Rectangle(x, y, x + 0.5, y + 0.5));
+        assert(contains_item_id(results, i));
+    }
+    assert(tree.count(Rectangle(-1, -1, 200, 200)) == static_cast<size_t>(item_count));
+
+    std::cout << "Insert Descent Path Tests Passed!\n";
+}
+
+void test_lazy_mbr_tightening()
+{
+    std::cout << "Running Lazy MBR Tightening Tests...\n";
+    RTree tree(2, 4);
+    for (int i = 0; i < 40; ++i)
+    {
+        tree.insert(DataItem(i, "Item", i, Rectangle(i, 0, i + 0.5, 1)));
+    }
+    tree.tighten(); // Explicit tightening at the end of a batch
+    assert(tree.count(Rectangle(10, 0, 19.9, 1)) == 10);
+
+    // Queries interleaved with inserts see every item (first read tightens)
+    for (int i = 40; i < 80; ++i)
+    {
+        tree.insert(DataItem(i, "Item", i, Rectangle(i, 0, i + 0.5, 1)));
+        assert(tree.count(Rectangle(i, 0, i + 0.25, 1)) == 1);
+    }
+
+    // An item far outside the current extent must grow every MBR on its path
+    tree.insert(DataItem(1000, "Outlier", 1, Rectangle(500, 500, 501, 501)));
+    std::vector<DataItem> results = tree.search(Rectangle(499, 499, 502, 502));
+    assert(results.size() == 1 && results[0].id == 1000);
+    assert(tree.count(Rectangle(-1, -1, 600, 600)) == 81);
+
+    std::cout << "Lazy MBR Tightening Tests Passed!\n";
+}
+
+void test_batch_insert()
+{
+    std::cout << "Running Batch Insert Tests...\n";
+    std::vector<DataItem> items;
+    for (int i = 0; i < 1000; ++i)
+    {
+        double x = (i * 7919) % 360 - 180.0, y = (i * 104729) % 180 - 90.0;
+        items.emplace_back(i, "Item", i * 100, Rectangle(x, y, x + 0.75, y + 0.75));
+    }
+
+    // Hilbert keys preserve locality: adjacent cells are adjacent on the curve
+    assert(hilbert_index(0, 0, 1) == 0 && hilbert_index(0, 1, 1) == 1);
+    assert(hilbert_index(1, 1, 1) == 2 && hilbert_index(1, 0, 1) == 3);
+
+    // A few items inserted one at a time, then the rest as batches of mixed sizes
+    RTree batched(2, 6);
+    RTree reference(2, 6);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        batched.insert(items[i]);
+    }
+    batched.insert_batch(std::span<const DataItem>(items).subspan(10, 500));
+    batched.insert_batch(std::span<const DataItem>());
+    batched.insert_batch(std::span<const DataItem>(items).subspan(510));
+    for (const auto &item : items)
+    {
+        reference.insert(item);
+    }
+
+    for (const Rectangle &query : {Rectangle(-180, -90, 180, 90), Rectangle(-10, -10, 10, 10), Rectangle(100, 20, 140, 45)})
+    {
+        assert(batched.count(query) == reference.count(query));
+        assert(batched.search_with_population(query, 50000).size() == reference.search_with_population(query, 50000).size());
+    }
+    assert(batched.count(Rectangle(-180, -90, 180, 90)) == items.size());
+
+    // One batch into an empty tree must split a single leaf many times over
+    RTree from_empty(2, 4);
+    from_empty.insert_batch(items);
+    for (const auto &item : items)
+    {
+        assert(contains_item_id(from_empty.search_contained(item.bounds), item.id));
+    }
+
+    std::cout << "Batch Insert Tests Passed!\n";
+}
+
+void test_buffered_insert()
+{
+    std::cout << "Running Buffered Insert Tests...\n";
+    RTree tree(2, 4);
+    tree.set_insert_buffering(16);
+    std::vector<DataItem> items;
+    for (int i = 0; i < 2000; ++i)
+    {
+        double x = (i * 31) % 200, y = (i * 17) % 100;
+        items.emplace_back(i, "Item", i, Rectangle(x, y, x + 0.5, y + 0.5));
+    }
+
+    // Queries interleaved with buffered inserts must see items still parked in buffers
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        tree.insert(items[i]);
+        if (i % 97 == 0)
+        {
+            assert(tree.count(Rectangle(-1, -1, 300, 300)) == i + 1);
+            assert(contains_item_id(tree.search_contained(items[i].bounds), items[i].id));
+        }
+    }
+    tree.insert_batch(std::span<const DataItem>(items).subspan(0, 0));
+    assert(tree.count(Rectangle(-1, -1, 300, 300)) == items.size());
+    assert(tree.search_with_population(Rectangle(-1, -1, 300, 300), 1500).size() == 500);
+
+    // Flushing (and leaving buffered mode) keeps every item
+    tree.flush_buffers();
+    assert(tree.count(Rectangle(-1, -1, 300, 300)) == items.size());
+    tree.set_insert_buffering(0);
+    assert(tree.insert_buffer_capacity() == 0);
+    for (const auto &item : items)
+    {
+        assert(contains_item_id(tree.search_contained(item.bounds), item.id));
+    }
+
+    std::cout << "Buffered Insert Tests Passed!\n";
+}
+
+void test_remove_and_bulk_load()
+{
+    std::cout << "Running Remove and Bulk Load Tests...\n";
+    std::vector<DataItem> items;
+    for (int i = 0; i < 1000; ++i)
+    {
+        double x = (i * 37) % 300, y = (i * 11) % 150;
+        items.emplace_back(i, "Item", i, Rectangle(x, y, x + 0.5, y + 0.5));
+    }
+    const Rectangle everything(-1, -1, 400, 400);
+
+    // Packed tree: same answers as an incrementally built one
+    RTree packed(2, 5);
+    packed.bulk_load(items);
+    assert(packed.size() == items.size());
+    RTree incremental(2, 5);
+    for (const auto &item : items)
+        incremental.insert(item);
+    for (const auto &query : {Rectangle(0, 0, 50, 50), Rectangle(100, 20, 180, 90), everything})
+    {
+        assert(packed.count(query) == incremental.count(query));
+    }
+
+    // Removing every other item, from both trees and from a buffered one
+    RTree buffered(2, 4);
+    buffered.set_insert_buffering(32);
+    buffered.insert_batch(items);
+    for (RTree *tree : {&packed, &incremental, &buffered})
+    {
+        for (const auto &item : items)
+        {
+            if (item.id % 2 == 0)
+                assert(tree->remove(item));
+        }
+        assert(!tree->remove(items[0])); // Already gone
+        assert(tree->count(everything) == items.size() / 2);
+        for (const auto &item : items)
+        {
+            assert(contains_item_id(tree->search(item.bounds), item.id) == (item.id % 2 == 1));
+        }
+    }
+
+    // Removing everything leaves an empty, reusable tree
+    for (const auto &item : items)
+        incremental.remove(item);
+    assert(incremental.empty() && incremental.size() == 0);
+    incremental.insert(items[3]);
+    assert(incremental.count(everything) == 1);
+
+    std::cout << "Remove and Bulk Load Tests Passed!\n";
+}
+
+void test_lsm_rtree()
+{
+    std::cout << "Running LSM R-Tree Tests...\n";
+    const Rectangle everything(-1, -1, 400, 400);
+    for (bool background : {false, true})
+    {
+        LsmRTree index(64, 2, background);
+        for (int i = 0; i < 1000; ++i)
+        {
+            double x = (i * 37) % 300, y = (i * 11) % 150;
+            index.insert(DataItem(i, "Item", i, Rectangle(x, y, x + 0.5, y + 0.5)));
+        }
+        assert(index.run_count() >= 1 && index.memtable_size() < 64);
+        assert(index.count(everything) == 1000);
+
+        // Deletes hide items in older runs; re-inserting an id replaces it
+        for (int i = 0; i < 1000; i += 3)
+            index.remove(i);
+        index.insert(DataItem(1, "Moved", 5000000, Rectangle(350, 350, 351, 351)));
+        assert(index.count(everything) == 1000 - 334);
+        auto moved = index.search(Rectangle(349, 349, 352, 352));
+        assert(moved.size() == 1 && moved[0].id == 1 && moved[0].name == "Moved");
+        assert(index.search_with_population(everything, 4000000).size() == 1);
+
+        // Compaction leaves one run with the same contents
+        index.compact();
+        assert(index.run_count() == 1 && index.memtable_size() == 0);
+        assert(index.count(everything) == 1000 - 334);
+        assert(index.search(Rectangle(349, 349, 352, 352)).size() == 1);
+        index.remove(1);
+        assert(index.search(Rectangle(349, 349, 352, 352)).empty());
+    }
+
+    std::cout << "LSM R-Tree Tests Passed!\n";
+}
+
+void test_durable_rtree()
+{
+    std::cout << "Running Durable R-Tree Tests...\n";
+    const std::string directory = (std::filesystem::temp_directory_path() / "rtree_durable_test").string();
+    std::filesystem::remove_all(directory);
+    const Rectangle everything(-1, -1, 400, 400);
+    auto item_at = [](int i)
+    {
+        double x = (i * 37) % 300, y = (i * 11) % 150;
+        return DataItem(i, "Item " + std::to_string(i), i, Rectangle(x, y, x + 0.5, y + 0.5));
+    };
+
+    {
+        DurableRTree store(directory, 16, 1000000);
+        for (int i = 0; i < 500; ++i)
+            store.insert(item_at(i));
+        for (int i = 0; i < 500; i += 5)
+            assert(store.remove(i));
+        assert(!store.remove(0));
+        store.insert(DataItem(1, "Moved", 7, Rectangle(350, 350, 351, 351)));
+        assert(store.durable_lsn() < store.last_lsn()); // Last group still pending
+    } // Destruction commits the pending group
+
+    // Recovery replays the whole log; a torn record at the end is discarded
+    {
+        std::ofstream log(directory + "/wal.log", std::ios::binary | std::ios::app);
+        const char torn[] = {0x30, 0x00, 0x00, 0x00, 0x12, 0x34, 0x56, 0x78, 'x', 'y'};
+        log.write(torn, sizeof(torn));
+    }
+    {
+        DurableRTree store(directory, 16, 1000000);
+        assert(store.recovered_records() == 601);
+        assert(store.size() == 400 && store.tree().count(everything) == 400);
+        auto moved = store.tree().search(Rectangle(349, 349, 352, 352));
+        assert(moved.size() == 1 && moved[0].name == "Moved");
+        assert(store.tree().search(item_at(5).bounds).empty());
+
+        // A checkpoint empties the log; later changes are replayed on top of it
+        store.checkpoint();
+        store.remove(1);
+        store.insert(item_at(5));
+        store.sync();
+        assert(store.durable_lsn() == store.last_lsn());
+    }
+    {
+        DurableRTree store(directory, 16, 1000000);
+        assert(store.recovered_records() == 2);
+        assert(store.size() == 400);
+        assert(store.tree().search(Rectangle(349, 349, 352, 352)).empty());
+        assert(contains_item_id(store.tree().search(item_at(5).bounds), 5));
+        assert(store.tree().search_with_population(everything, 490).size() == 8);
+    }
+
+    // Automatic checkpoints bound the log replayed on restart
+    std::filesystem::remove_all(directory);
+    {
+        DurableRTree store(directory, 8, 100);
+        for (int i = 0; i < 1050; ++i)
+            store.insert(item_at(i));
+    }
+    {
+        DurableRTree store(directory, 8, 100);
+        assert(store.recovered_records() == 50);
+        assert(store.tree().count(Rectangle(-1, -1, 400, 400)) == 1050);
+    }
+    std::filesystem::remove_all(directory);
+
+    std::cout << "Durable R-Tree Tests Passed!\n";
+}
+
+void test_paged_rtree()
+{
+    std::cout << "Running Paged R-Tree Tests...\n";
+    const std::string path = (std::filesystem::temp_directory_path() / "rtree_paged_test.pages").string();
+    std::vector<DataItem> items;
+    RTree reference(4, 16);
+    for (int i = 0; i < 5000; ++i)
+    {
+        double x = (i * 37) % 300, y = (i * 11) % 150;
+        items.emplace_back(i, "Item " + std::to_string(i), i, Rectangle(x, y, x + 0.5, y + 0.5));
+        reference.insert(items.back());
+    }
+
+    bool rejected = false;
+    try
+    {
+        PagedRTree::build(path, items, 3000);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+
+    PagedRTree::build(path, items, 4096);
+    PagedRTree tree(path, 8); // Far fewer pool frames than pages
+    assert(tree.size() == items.size() && tree.page_size() == 4096);
+    assert(tree.height() == 2 && tree.page_count() > 8);
+
+    for (const auto &query : {Rectangle(0, 0, 50, 50), Rectangle(100, 20, 180, 90), Rectangle(-1, -1, 400, 400), Rectangle(500, 500, 600, 600)})
+    {
+        auto expected = reference.search(query);
+        auto found = tree.search(query);
+        assert(found.size() == expected.size() && tree.count(query) == expected.size());
+        for (const auto &item : found)
+        {
+            assert(item.name == "Item " + std::to_string(item.id) && item.population == item.id);
+        }
+        assert(tree.search_with_population(query, 2500).size() == reference.search_with_population(query, 2500).size());
+    }
+
+    // A small window only reads the pages on its path
+    tree.pool().reset_stats();
+    assert(tree.count(Rectangle(10, 10, 11, 11)) == reference.count(Rectangle(10, 10, 11, 11)));
+    assert(tree.pool().reads() + tree.pool().hits() < 10);
+
+    // Pinned pages cannot be evicted
+    BufferPool &pool = tree.pool();
+    std::vector<PageId> pinned;
+    for (PageId id = 0; id < pool.capacity(); ++id)
+    {
+        pool.pin(id);
+        pinned.push_back(id);
+    }
+    bool exhausted = false;
+    try
+    {
+        pool.pin(pool.capacity());
+    }
+    catch (const std::runtime_error &)
+    {
+        exhausted = true;
+    }
+    assert(exhausted);
+    for (PageId id : pinned)
+        pool.unpin(id);
+    assert(tree.count(Rectangle(-1, -1, 400, 400)) == items.size());
+
+    // Corrupt headers and nodes are rejected instead of being paged with. Each
+    // case patches a copy of the file and opens and queries it.
+    const std::string corrupt = path + ".corrupt";
+    auto rejected_with = [&](std::streamoff offset, const std::vector<unsigned char> &bytes)
+    {
+        std::filesystem::copy_file(path, corrupt, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::copy_file(path + ".names", corrupt + ".names", std::filesystem::copy_options::overwrite_existing);
+        {
+            std::fstream file(corrupt, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+        bool threw = false;
+        try
+        {
+            PagedRTree broken(corrupt, 8);
+            broken.count(Rectangle(-1, -1, 400, 400));
+        }
+        catch (const std::runtime_error &)
+        {
+            threw = true;
+        }
+        std::filesystem::remove(corrupt);
+        std::filesystem::remove(corrupt + ".names");
+        return threw;
+    };
+    std::uint64_t root_page = 0;
+    {
+        std::ifstream header(path, std::ios::binary);
+        header.seekg(16);
+        header.read(reinterpret_cast<char *>(&root_page), sizeof(root_page));
+    }
+    const std::streamoff root_offset = static_cast<std::streamoff>(root_page * 4096);
+    assert(!rejected_with(0, {})); // An unmodified copy opens and queries fine
+    assert(rejected_with(8, std::vector<unsigned char>(8, 0))); // Page size 0
+    assert(rejected_with(16, std::vector<unsigned char>(8, 0xff))); // Root past the end
+    assert(rejected_with(root_offset + 2, {0xff, 0xff})); // More entries than fit the page
+    assert(rejected_with(root_offset + 8 + 32, std::vector<unsigned char>(8, 0x7f))); // First child past the end
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".names");
+
+    std::cout << "Paged R-Tree Tests Passed!\n";
+}
+
+void test_async_page_prefetch()
+{
+    std::cout << "Running Async Page Prefetch Tests...\n";
+    const std::string path = (std::filesystem::temp_directory_path() / "rtree_async_test.pages").string();
+    std::vector<DataItem> items;
+    for (int i = 0; i < 20000; ++i)
+    {
+        double x = (i * 37) % 1000, y = (i * 11) % 500;
+        items.emplace_back(i, "Item", i, Rectangle(x, y, x + 0.5, y + 0.5));
+    }
+    PagedRTree::build(path, items, 4096);
+
+    PagedRTree sync_tree(path, 16, 0);
+    PagedRTree async_tree(path, 16, 2);
+    assert(!sync_tree.pool().async_reads() && async_tree.pool().async_reads());
+    assert(async_tree.height() == 3);
+
+    // Same answers; the wide queries fan out, so children are read ahead
+    for (const auto &query : {Rectangle(0, 0, 1000, 500), Rectangle(100, 100, 400, 300), Rectangle(10, 10, 11, 11)})
+    {
+        assert(async_tree.count(query) == sync_tree.count(query));
+        assert(async_tree.search_with_population(query, 10000).size() == sync_tree.search_with_population(query, 10000).size());
+    }
+    assert(sync_tree.pool().prefetches() == 0);
+    assert(async_tree.pool().prefetches() > 0);
+
+    // Prefetched pages are ordinary cached pages once loaded
+    std::vector<PageId> ids{1, 2, 3};
+    async_tree.pool().prefetch(ids);
+    for (PageId id : ids)
+    {
+        async_tree.pool().pin(id);
+        async_tree.pool().unpin(id);
+    }
+    assert(async_tree.count(Rectangle(0, 0, 1000, 500)) == items.size());
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".names");
+
+    std::cout << "Async Page Prefetch Tests Passed!\n";
+}
+
+void test_compressed_leaves()
+{
+    std::cout << "Running Compressed Leaf Tests...\n";
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coordinate(-50.0, 50.0);
+    std::vector<DataItem> decimal_items, raw_items;
+    for (int i = 0; i < 300; ++i)
+    {
+        // Values with two decimals, as parsed from CSV, and arbitrary doubles
+        auto two_places = [](double value)
+        { return std::round(value * 100) / 100; };
+        double x = coordinate(rng), y = coordinate(rng);
+        decimal_items.emplace_back(i * 7 - 1000, "Place " + std::to_string(i), i * 1000L,
+                                   Rectangle(two_places(x), two_places(y), two_places(x + 0.25), two_places(y + 1.5)));
+        double u = coordinate(rng), v = coordinate(rng);
+        raw_items.emplace_back(i, i % 3 ? "" : "Raw", -i, Rectangle(u, v, u + coordinate(rng) / 1000 + 0.05, v + 1e-9));
+    }
+    const Rectangle queries[] = {Rectangle(-10, -10, 10, 10), Rectangle(0.25, -3.5, 7.13, 20), Rectangle(-50, -50, 50, 50),
+                                 Rectangle(decimal_items[5].bounds.max_corner[0], -60, 60, decimal_items[5].bounds.min_corner[1]), Rectangle(70, 70, 80, 80)};
+
+    for (const auto *items : {&decimal_items, &raw_items})
+    {
+        CompressedLeaf leaf = CompressedLeaf::encode(*items);
+        assert(leaf.decimal() == (items == &decimal_items));
+        assert(leaf.memory_bytes() < items->size() * (sizeof(DataItem) + sizeof(Rectangle)));
+
+        // Lossless round trip, also through the serialized bytes
+        std::vector<DataItem> decoded = CompressedLeaf::from_bytes(leaf.bytes()).decode();
+        assert(decoded.size() == items->size());
+        for (size_t i = 0; i < decoded.size(); ++i)
+        {
+            const DataItem &a = (*items)[i], &b = decoded[i];
+            assert(a.id == b.id && a.name == b.name && a.population == b.population);
+            assert(a.bounds.min_corner[0] == b.bounds.min_corner[0] && a.bounds.max_corner[0] == b.bounds.max_corner[0]);
+            assert(a.bounds.min_corner[1] == b.bounds.min_corner[1] && a.bounds.max_corner[1] == b.bounds.max_corner[1]);
+        }
+
+        // Scans match a brute-force filter, including boxes that only touch the query
+        for (const auto &query : queries)
+        {
+            for (long min_population : {std::numeric_limits<long>::min(), -100L, 150000L})
+            {
+                std::vector<std::uint32_t> matches;
+                leaf.scan(query, min_population, matches);
+                size_t expected = 0;
+                for (const auto &item : *items)
+                    expected += item.bounds.intersects(query) && item.population >= min_population;
+                assert(matches.size() == expected);
+                for (std::uint32_t i : matches)
+                    assert((*items)[i].bounds.intersects(query) && (*items)[i].population >= min_population);
+            }
+        }
+    }
+    assert(CompressedLeaf::encode({}).size() == 0);
+
+    // The compressed tree answers like the pointer-based one
+    RTree reference(4, 16);
+    for (const auto &item : decimal_items)
+        reference.insert(item);
+    CompressedRTree tree(decimal_items, 32, 4);
+    assert(tree.size() == decimal_items.size() && tree.leaf_count() == 10);
+    for (const auto &query : queries)
+    {
+        assert(tree.count(query) == reference.count(query));
+        assert(tree.search_with_population(query, 150000).size() == reference.search_with_population(query, 150000).size());
+    }
+    assert(CompressedRTree({}).count(queries[2]) == 0);
+
+    std::cout << "Compressed Leaf Tests Passed!\n";
+}
+
+void test_snapshot_diff()
+{
+    std::cout << "Running Snapshot Diff Tests...\n";
+    std::vector<DataItem> items;
+    for (int i = 0; i < 3000; ++i)
+    {
+        double x = -179 + (i * 37) % 358, y = -89 + (i * 11) % 178;
+        items.emplace_back(i, "Item " + std::to_string(i), i * 10L, Rectangle(x, y, x + 0.5, y + 0.5));
+    }
+    BucketSnapshot v1(items, 1);
+
+    // Version 2: a few updates, moves, deletes and inserts
+    std::vector<DataItem> next = items;
+    next[10].population = 1;
+    next[20].bounds = Rectangle(100, 10, 101, 11);
+    next.erase(next.begin() + 500, next.begin() + 505);
+    next.emplace_back(9000, "New", 5, Rectangle(-10, -10, -9, -9));
+    BucketSnapshot v2(next, 2);
+
+    // A replica seeded from the full snapshot and its own tree
+    std::vector<char> full = v1.serialize();
+    BucketSnapshot replica = BucketSnapshot::deserialize(full);
+    assert(replica.version() == 1 && replica.items().size() == items.size());
+    RTree replica_tree(4, 16);
+    replica_tree.insert_batch(replica.items());
+
+    // The delta is a small fraction of the full snapshot
+    std::vector<char> delta = v1.diff(v2);
+    assert(delta.size() * 20 < full.size());
+    assert(v2.diff(v2).size() < 100);
+
+    replica.apply(delta, &replica_tree);
+    assert(replica.version() == 2 && replica.serialize() == v2.serialize());
+    assert(replica_tree.size() == next.size());
+    RTree reference(4, 16);
+    reference.insert_batch(next);
+    for (const auto &query : {Rectangle(-180, -90, 180, 90), Rectangle(99, 9, 102, 12), Rectangle(-11, -11, 0, 0)})
+    {
+        assert(replica_tree.count(query) == reference.count(query));
+        assert(replica_tree.search_with_population(query, 10000).size() == reference.search_with_population(query, 10000).size());
+    }
+
+    // Deltas only apply to the version they were made from, and corruption is caught
+    bool rejected = false;
+    try
+    {
+        replica.apply(delta);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+    BucketSnapshot other = BucketSnapshot::deserialize(full);
+    delta[delta.size() / 2] ^= 1;
+    rejected = false;
+    try
+    {
+        other.apply(delta);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected && other.version() == 1);
+
+    // Items nudged across bucket boundaries, in both directions along the
+    // curve: each must end up in the tree once, with its new bounds
+    std::vector<DataItem> nudged = items;
+    for (auto &item : nudged)
+    {
+        item.bounds = Rectangle(item.bounds.min_corner.x + 0.3, item.bounds.min_corner.y + 0.3,
+                                item.bounds.max_corner.x + 0.3, item.bounds.max_corner.y + 0.3);
+    }
+    BucketSnapshot nudged_snapshot(nudged, 2);
+    BucketSnapshot nudge_replica = BucketSnapshot::deserialize(full);
+    RTree nudge_tree(2, 4);
+    nudge_tree.insert_batch(nudge_replica.items());
+    nudge_replica.apply(v1.diff(nudged_snapshot), &nudge_tree);
+    assert(nudge_tree.size() == nudged.size());
+    for (const auto &item : nudge_tree.search(Rectangle(-180, -90, 180, 90)))
+    {
+        assert(item.bounds.min_corner.x == nudged[item.id].bounds.min_corner.x);
+        assert(item.bounds.min_corner.y == nudged[item.id].bounds.min_corner.y);
+    }
+
+    std::cout << "Snapshot Diff Tests Passed!\n";
+}
+
+void test_versioned_snapshots()
+{
+    std::cout << "Running Versioned Snapshot Tests...\n";
+    RTree tree(2, 4);
+    const Rectangle world(-180, -90, 180, 90);
+    std::vector<DataItem> items;
+    for (int i = 0; i < 2000; ++i)
+    {
+        double x = -179 + (i * 37) % 358, y = -89 + (i * 11) % 178;
+        items.emplace_back(i, "Item " + std::to_string(i), i * 10L, Rectangle(x, y, x + 0.5, y + 0.5));
+    }
+    tree.insert_batch(std::span<const DataItem>(items).first(1900));
+    size_t single_tree_nodes = tree.retained_node_count();
+    std::uint64_t v1 = tree.commit_version();
+    assert(v1 == 1 && tree.has_version(v1) && tree.version_count() == 1);
+    assert(tree.retained_node_count() == single_tree_nodes); // Committing copies nothing
+
+    // One insert copies only the path it modifies
+    tree.insert(items[1900]);
+    assert(tree.retained_node_count() <= single_tree_nodes + 12);
+
+    // Version 2: more inserts and some removals
+    for (int i = 1901; i < 1950; ++i)
+        tree.insert(items[i]);
+    for (int i = 0; i < 20; ++i)
+        assert(tree.remove(items[i]));
+    std::uint64_t v2 = tree.commit_version();
+    assert(v2 == 2);
+
+    // Further changes to the live tree, including buffered inserts
+    tree.set_insert_buffering(8);
+    tree.insert_batch(std::span<const DataItem>(items).subspan(1950));
+    tree.set_insert_buffering(0);
+    assert(tree.remove(items[100]));
+
+    // Each version still sees exactly its own contents
+    auto v1_items = tree.search(world, v1);
+    assert(v1_items.size() == 1900 && tree.count(world, v1) == 1900);
+    assert(contains_item_id(v1_items, 0) && !contains_item_id(v1_items, 1900));
+    auto v2_items = tree.search(world, v2);
+    assert(v2_items.size() == 1930);
+    assert(!contains_item_id(v2_items, 0) && contains_item_id(v2_items, 100) && contains_item_id(v2_items, 1949));
+    assert(tree.count(world) == 1979 && !contains_item_id(tree.search(world), 100));
+    assert(tree.count(Rectangle(items[5].bounds), v1) >= 1 && tree.count(Rectangle(items[5].bounds), v2) == 0);
+
+    // Shared nodes keep three versions below two full copies
+    assert(tree.retained_node_count() < 2 * single_tree_nodes);
+
+    // Bounded retention drops the oldest version
+    tree.set_version_retention(1);
+    assert(!tree.has_version(v1) && tree.has_version(v2));
+    bool threw = false;
+    try
+    {
+        tree.search(world, v1);
+    }
+    catch (const std::out_of_range &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    std::uint64_t v3 = tree.commit_version();
+    assert(v3 == 3 && !tree.has_version(v2) && tree.version_count() == 1);
+    assert(tree.search(world, v3).size() == 1979);
+
+    // Releasing the last version frees its nodes
+    assert(tree.release_version(v3) && !tree.release_version(v3));
+    assert(tree.retained_node_count() <= single_tree_nodes * 2);
+    tree.insert(items[100]);
+    assert(tree.count(world) == 1980);
+
+    // Re-packing or condensing the live tree leaves a version's items intact,
+    // including those in nodes only reachable through a shared parent
+    auto payloads_intact = [](const std::vector<DataItem> &found)
+    {
+        return std::all_of(found.begin(), found.end(), [](const DataItem &item)
+                           { return item.name == "Item " + std::to_string(item.id) && item.population == item.id * 10L; });
+    };
+    RTree condensed(2, 4);
+    condensed.insert_batch(std::span<const DataItem>(items).first(200));
+    std::uint64_t before_removals = condensed.commit_version();
+    for (int i = 0; i < 150; ++i)
+        assert(condensed.remove(items[i]));
+    auto kept = condensed.search(world, before_removals);
+    assert(kept.size() == 200 && payloads_intact(kept));
+    assert(condensed.count(world) == 50 && payloads_intact(condensed.search(world)));
+
+    RTree repacked(2, 4);
+    repacked.insert_batch(std::span<const DataItem>(items).first(200));
+    std::uint64_t before_repack = repacked.commit_version();
+    repacked.set_fan_out(FanOut{4, 16, 8, 32});
+    kept = repacked.search(world, before_repack);
+    assert(kept.size() == 200 && payloads_intact(kept));
+    assert(payloads_intact(repacked.search(world)));
+    std::cout << "Versioned Snapshot Tests Passed!\n";
+}
+
+void test_temporal_index()
+{
+    std::cout << "Running Temporal Index Tests...\n";
+    TemporalRTree index(2, 6);
+    const Rectangle world(-180, -90, 180, 90);
+
+    // 500 cities, each with a population figure per year from 2000 to 2009
+    std::vector<TemporalDataItem> cities;
+    for (int i = 0; i < 500; ++i)
+    {
+        double x = -179 + (i * 37) % 358, y = -89 + (i * 11) % 178;
+        cities.emplace_back(i, "City " + std::to_string(i), 1000L * i, Rectangle(x, y, x + 0.5, y + 0.5), 2000.0);
+    }
+    index.insert_batch(cities);
+    for (int year = 2001; year < 2010; ++year)
+    {
+        for (int i = 0; i < 500; ++i)
+            assert(index.update_population(i, 1000L * i + year, year));
+    }
+    assert(index.size() == 5000);
+
+    // A time slice sees exactly one version per city, with that year's figure
+    auto slice = index.search_at(world, 2004.5);
+    assert(slice.size() == 500);
+    for (const auto &item : slice)
+        assert(item.population == 1000L * item.id + 2004 && item.valid_from == 2004 && item.valid_to == 2005);
+    assert(index.count_at(world, 2000) == 500 && index.count_at(world, 1999.9) == 0);
+    assert(index.count_at(world, 2050) == 500); // Latest versions are open-ended
+    assert(index.search_at(world, 2009)[0].valid_to == TemporalDataItem::forever);
+
+    // Interval ends are exclusive: at 2005 only the 2005 version is valid
+    auto boundary = index.search_at(cities[7].bounds, 2005);
+    assert(contains_item_id(boundary, 7));
+    for (const auto &item : boundary)
+        assert(item.valid_from == 2005);
+
+    // Space and time together
+    assert(index.search_at(Rectangle(cities[3].bounds), 2002).size() >= 1);
+    assert(index.search_with_population_at(world, 2003, 400000).size() == 102);
+    auto range = index.search_during(cities[9].bounds, 2002, 2004);
+    assert(std::count_if(range.begin(), range.end(), [](const TemporalDataItem &item)
+                         { return item.id == 9; }) == 3);
+
+    // Closing removes an item from later slices only
+    assert(!index.close(42, 2007)); // Only the latest version can be closed
+    assert(index.close(42, 2009.5));
+    assert(!contains_item_id(index.search_at(world, 2010), 42));
+    assert(contains_item_id(index.search_at(world, 2009.2), 42));
+    assert(!index.update_population(42, 1, 2010) && !index.close(4242, 2010));
+
+    // Correcting a figure at the start of its version does not add a version
+    assert(index.update_population(1, 77, 2009) && index.size() == 5000);
+    assert(index.search_with_population_at(cities[1].bounds, 2009, 77).size() == 1);
+
+    bool threw = false;
+    try
+    {
+        index.insert(TemporalDataItem(1000, "Empty", 0, cities[0].bounds, 2010, 2010));
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    // A bad item later in a batch leaves the earlier ones unstored
+    const double open_end = index.open_end();
+    std::vector<TemporalDataItem> mixed{TemporalDataItem(2000, "New", 1, cities[0].bounds, 2010),
+                                        TemporalDataItem(3, "City 3", 1, cities[3].bounds, 1e6),
+                                        TemporalDataItem(2001, "Empty", 0, cities[0].bounds, 2011, 2011)};
+    threw = false;
+    try
+    {
+        index.insert_batch(mixed);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw && index.size() == 5000 && index.open_end() == open_end);
+    assert(!index.update_population(2000, 1, 2010) && !contains_item_id(index.search_at(world, 2010), 2000));
+    assert(index.update_population(3, 3009, 2009) && index.size() == 5000); // 2009 is still its latest version
+
+    // Epoch-second timestamps, far beyond the open end the index started with
+    TemporalRTree epoch(2, 6);
+    const double start = 1.7e9, day = 86400;
+    std::vector<TemporalDataItem> sensors;
+    for (int i = 0; i < 200; ++i)
+        sensors.emplace_back(i, "Sensor " + std::to_string(i), i, cities[i].bounds, start + i * day);
+    epoch.insert_batch(sensors);
+    assert(epoch.open_end() > start + 200 * day);
+    assert(epoch.count_at(world, start + 100.5 * day) == 101);
+    assert(epoch.count_at(world, start - 1) == 0 && epoch.count_at(world, 1e12) == 200);
+    assert(epoch.update_population(5, 55, start + 300 * day));
+    assert(epoch.search_with_population_at(cities[5].bounds, start + 301 * day, 55).size() == 1);
+    assert(epoch.search_with_population_at(cities[5].bounds, start + 299 * day, 55).empty());
+
+    // A time past the current open end re-indexes what is already stored
+    assert(epoch.close(7, 1e11));
+    assert(epoch.open_end() > 1e11);
+    assert(contains_item_id(epoch.search_at(world, 5e10), 7) && !contains_item_id(epoch.search_at(world, 2e11), 7));
+    assert(epoch.count_at(world, 2e11) == 199 && epoch.search_during(world, start, start + 10 * day).size() == 11);
+    std::cout << "Temporal Index Tests Passed!\n";
+}
+
+void test_tpr_tree()
+{
+    std::cout << "Running TPR-Tree Tests...\n";
+    TPRTree tree(10.0, 2, 6);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> position(0, 1000), speed(-5, 5);
+    std::vector<MovingItem> objects;
+    for (int i = 0; i < 1500; ++i)
+    {
+        double x = position(rng), y = position(rng);
+        objects.emplace_back(i, "Vehicle " + std::to_string(i), i, Rectangle(x, y, x + 1, y + 1), Point(speed(rng), speed(rng)), 0.0);
+        tree.update(objects.back());
+    }
+    assert(tree.size() == 1500 && tree.height() > 2);
+
+    // Brute-force answers from the motions themselves
+    auto expected_at = [&](const Rectangle &query, double t)
+    {
+        size_t hits = 0;
+        for (const auto &object : objects)
+            hits += object.bounds_at(t).intersects(query);
+        return hits;
+    };
+    auto check_slices = [&](double from)
+    {
+        for (int q = 0; q < 40; ++q)
+        {
+            double x = position(rng), y = position(rng);
+            Rectangle query(x, y, x + 80, y + 80);
+            double t = from + q % 20;
+            assert(tree.count_at(query, t) == expected_at(query, t));
+            for (const auto &item : tree.search_at(query, t))
+                assert(item.bounds_at(t).intersects(query));
+        }
+    };
+    check_slices(0);
+
+    // Only the vehicles that change course are updated
+    for (int i = 0; i < 1500; i += 10)
+    {
+        MovingItem &object = objects[i];
+        object = MovingItem(object.id, object.name, object.population, object.bounds_at(15), Point(speed(rng), speed(rng)), 15.0);
+        tree.update(object);
+    }
+    assert(tree.now() == 15 && tree.size() == 1500);
+    check_slices(15);
+
+    // A range query finds everything seen by any time slice inside it
+    Rectangle area(400, 400, 450, 450);
+    auto during = tree.search_during(area, 20, 30);
+    for (double t = 20; t <= 30; t += 0.5)
+        for (const auto &item : tree.search_at(area, t))
+            assert(contains_item_id(during, item.id));
+    assert(during.size() < 1500);
+
+    // Removal
+    for (int i = 0; i < 1500; i += 3)
+        assert(tree.remove(i));
+    assert(!tree.remove(0) && tree.size() == 1000);
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [](const MovingItem &object)
+                                 { return object.id % 3 == 0; }),
+                  objects.end());
+    check_slices(15);
+
+    // The past is not indexed
+    bool threw = false;
+    try
+    {
+        tree.search_at(area, 10);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "TPR-Tree Tests Passed!\n";
+}
+
+void test_standing_queries()
+{
+    std::cout << "Running Standing Query Tests...\n";
+    MonitoredRTree monitored(2, 4);
+    using Kind = StandingQueryDelta::Kind;
+    int europe = monitored.register_query(Rectangle(-10, 35, 40, 70));
+    int big_cities = monitored.register_query(Rectangle(-180, -90, 180, 90), 1000000);
+
+    std::vector<DataItem> cities{DataItem(1, "Paris", 2100000, Rectangle(2.2, 48.8, 2.5, 48.9)),
+                                 DataItem(2, "Lyon", 500000, Rectangle(4.8, 45.7, 4.9, 45.8))};
+    monitored.insert_batch(cities);
+    monitored.insert(DataItem(3, "Tokyo", 14000000, Rectangle(139.6, 35.6, 139.8, 35.8)));
+    auto deltas = monitored.drain_deltas();
+    assert(deltas.size() == 4); // Paris twice, Lyon, Tokyo
+    assert(deltas[0].query_id == europe && deltas[0].kind == Kind::enter && deltas[0].item.id == 1);
+    assert(deltas[1].query_id == big_cities && deltas[1].item.id == 1);
+    assert(deltas[2].query_id == europe && deltas[2].item.id == 2);
+    assert(deltas[3].query_id == big_cities && deltas[3].item.id == 3);
+    assert(monitored.drain_deltas().empty());
+
+    // Lyon grows past the threshold: enters one query, updates in the other
+    monitored.insert(DataItem(2, "Lyon", 1200000, Rectangle(4.8, 45.7, 4.9, 45.8)));
+    deltas = monitored.drain_deltas();
+    assert(deltas.size() == 2);
+    assert(deltas[0].query_id == europe && deltas[0].kind == Kind::update && deltas[0].item.population == 1200000);
+    assert(deltas[1].query_id == big_cities && deltas[1].kind == Kind::enter);
+
+    // Paris moves out of Europe (for the sake of the test), then is deleted
+    monitored.insert(DataItem(1, "Paris", 2100000, Rectangle(-70, 40, -69, 41)));
+    deltas = monitored.drain_deltas();
+    assert(deltas.size() == 2 && deltas[0].kind == Kind::exit && deltas[0].item.bounds.min_corner.x == 2.2);
+    assert(deltas[1].kind == Kind::update);
+    assert(monitored.remove(1) && !monitored.remove(1));
+    deltas = monitored.drain_deltas();
+    assert(deltas.size() == 1 && deltas[0].query_id == big_cities && deltas[0].kind == Kind::exit);
+
+    // Applying the deltas reproduces re-running the queries
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<double> coord(-60, 60);
+    std::uniform_int_distribution<long> population(0, 2000000);
+    std::map<int, std::set<int>> tracked;
+    for (int query_id : {europe, big_cities})
+        for (const auto &item : monitored.results(query_id))
+            tracked[query_id].insert(item.id);
+    for (int step = 0; step < 2000; ++step)
+    {
+        int id = 10 + step % 300;
+        if (step % 7 == 0)
+        {
+            monitored.remove(id);
+        }
+        else
+        {
+            double x = coord(rng), y = coord(rng);
+            monitored.insert(DataItem(id, "", population(rng), Rectangle(x, y, x + 1, y + 1)));
+        }
+        for (const auto &delta : monitored.drain_deltas())
+        {
+            if (delta.kind == Kind::enter)
+                assert(tracked[delta.query_id].insert(delta.item.id).second);
+            else if (delta.kind == Kind::exit)
+                assert(tracked[delta.query_id].erase(delta.item.id) == 1);
+            else
+                assert(tracked[delta.query_id].count(delta.item.id) == 1);
+        }
+    }
+    for (int query_id : {europe, big_cities})
+    {
+        auto current = monitored.results(query_id);
+        assert(current.size() == tracked[query_id].size());
+        for (const auto &item : current)
+            assert(tracked[query_id].count(item.id) == 1);
+    }
+
+    assert(monitored.unregister_query(europe) && monitored.query_count() == 1);
+    monitored.insert(DataItem(5000, "", 0, Rectangle(0, 50, 1, 51)));
+    assert(monitored.drain_deltas().empty());
+    std::cout << "Standing Query Tests Passed!\n";
+}
+
+void test_query_index()
+{
+    std::cout << "Running Reverse Query Index Tests...\n";
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<double> coord(-100, 100), size(0.5, 20);
+    std::uniform_int_distribution<long> population(0, 1000);
+
+    std::vector<Subscription> fences;
+    for (int i = 0; i < 3000; ++i)
+    {
+        double x = coord(rng), y = coord(rng);
+        fences.push_back({i, Rectangle(x, y, x + size(rng), y + size(rng)), i % 4 == 0 ? population(rng) : std::numeric_limits<long>::min()});
+    }
+    QueryIndex index(2, 8);
+    index.add_batch(std::span<const Subscription>(fences).first(2000)); // Packed
+    for (size_t i = 2000; i < fences.size(); ++i)
+        index.add(fences[i]); // Incremental
+    assert(index.size() == 3000 && index.find(17) && index.find(17)->rect.min_corner.x == fences[17].rect.min_corner.x);
+
+    // Every event matches exactly the fences a linear scan finds
+    auto check_events = [&](const std::vector<Subscription> &live)
+    {
+        std::vector<int> reused;
+        for (int e = 0; e < 300; ++e)
+        {
+            double x = coord(rng), y = coord(rng);
+            DataItem event(100000 + e, "", population(rng), Rectangle(x, y, x, y));
+            std::vector<int> expected;
+            for (const auto &fence : live)
+                if (fence.matches(event))
+                    expected.push_back(fence.id);
+            std::sort(expected.begin(), expected.end());
+            assert(index.match(event) == expected);
+            reused.clear();
+            assert(index.match(event, reused) == expected.size());
+        }
+    };
+    check_events(fences);
+
+    // Removal and duplicate ids
+    for (int i = 0; i < 3000; i += 2)
+        assert(index.remove(i));
+    assert(!index.remove(0) && !index.find(0) && index.size() == 1500);
+    fences.erase(std::remove_if(fences.begin(), fences.end(), [](const Subscription &fence)
+                                { return fence.id % 2 == 0; }),
+                 fences.end());
+    check_events(fences);
+    bool threw = false;
+    try
+    {
+        index.add({1, Rectangle(0, 0, 1, 1)});
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw && index.size() == 1500);
+    std::cout << "Reverse Query Index Tests Passed!\n";
+}
+
+void test_index_backends()
+{
+    std::cout << "Running Spatial Index Backend Tests...\n";
+    std::mt19937 rng(31);
+    std::uniform_real_distribution<double> lon(-200, 200), lat(-100, 100), small(0, 2), large(10, 60);
+    std::uniform_int_distribution<long> population(0, 1000);
+
+    // Points, small boxes, a few large boxes, a stack of identical points,
+    // and items partly or fully outside the world extent
+    std::vector<DataItem> items;
+    for (int i = 0; i < 3000; ++i)
+    {
+        double x = lon(rng), y = lat(rng);
+        double w = i % 3 == 0 ? 0 : (i % 50 == 0 ? large(rng) : small(rng));
+        double h = i % 3 == 0 ? 0 : (i % 50 == 0 ? large(rng) : small(rng));
+        if (i % 100 == 1)
+            x = y = w = h = 0;
+        items.emplace_back(i, "", population(rng), Rectangle(x, y, x + w, y + h));
+    }
+    RTree reference(2, 8);
+    reference.insert_batch(items);
+
+    std::vector<std::unique_ptr<SpatialIndex>> indexes;
+    for (const auto &name : spatial_index_names())
+        indexes.push_back(make_spatial_index(name));
+    indexes.push_back(std::make_unique<GridIndex>(Rectangle(-50, -50, 50, 50), 7, 5));
+    indexes.push_back(std::make_unique<QuadtreeIndex>(Rectangle(-180, -90, 180, 90), 4, 6));
+    indexes.push_back(std::make_unique<HilbertArrayIndex>(4));
+
+    for (auto &index : indexes)
+    {
+        assert(index->empty());
+        // Half in one batch, the rest one by one (exercising the unsorted tails)
+        index->insert_batch(std::span<const DataItem>(items).first(1500));
+        for (size_t i = 1500; i < items.size(); ++i)
+            index->insert(items[i]);
+        assert(index->size() == items.size() && !index->empty());
+
+        for (int q = 0; q < 300; ++q)
+        {
+            double x = lon(rng), y = lat(rng), size = q % 10 == 0 ? 150 : small(rng) * 5;
+            Rectangle query = q % 7 == 0 ? Rectangle(x, y, x, y) : Rectangle(x, y, x + size, y + size);
+            long min_population = population(rng);
+            std::vector<int> expected = sorted_ids(reference.search(query));
+            assert(sorted_ids(index->search(query)) == expected);
+            assert(index->count(query) == expected.size());
+            assert(sorted_ids(index->search_with_population(query, min_population)) == sorted_ids(reference.search_with_population(query, min_population)));
+        }
+        // The stacked points and an inverted query
+        assert(index->count(Rectangle(0, 0, 0, 0)) == reference.count(Rectangle(0, 0, 0, 0)));
+        assert(index->count(Rectangle(1, 1, 0, 0)) == 0);
+    }
+
+    bool rejected = false;
+    try
+    {
+        make_spatial_index("btree");
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+    std::cout << "Spatial Index Backend Tests Passed!\n";
+}
+
+void test_point_leaves()
+{
+    std::cout << "Running Point Leaf Tests...\n";
+    std::mt19937 rng(41);
+    std::uniform_int_distribution<int> cell(0, 99); // Grid coordinates, so queries hit points exactly on their edges
+    std::vector<DataItem> points;
+    for (int i = 0; i < 2000; ++i)
+    {
+        double x = cell(rng), y = cell(rng);
+        points.emplace_back(i, "", i % 100, Rectangle(x, y, x, y));
+    }
+    auto brute = [](const std::vector<DataItem> &items, auto &&pred)
+    {
+        std::vector<int> ids;
+        for (const auto &item : items)
+            if (pred(item))
+                ids.push_back(item.id);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+    auto check = [&](const RTree &tree, const std::vector<DataItem> &items)
+    {
+        for (int q = 0; q < 100; ++q)
+        {
+            double x = cell(rng), y = cell(rng), w = cell(rng) % 20;
+            Rectangle query(x, y, x + w, y + w);
+            std::vector<int> expected = brute(items, [&](const DataItem &item)
+                                              { return item.bounds.intersects(query); });
+            assert(sorted_ids(tree.search(query)) == expected);
+            assert(tree.count(query) == expected.size());
+            assert(sorted_ids(tree.search_contained(query)) == brute(items, [&](const DataItem &item)
+                                                              { return query.contains(item.bounds); }));
+            assert(sorted_ids(tree.search_with_population(query, 50)) == brute(items, [&](const DataItem &item)
+                                                                        { return item.population >= 50 && item.bounds.intersects(query); }));
+        }
+    };
+
+    // A pure point layer packs every leaf as points
+    RTree tree(4, 16);
+    tree.bulk_load(points);
+    assert(tree.point_leaf_count() == (points.size() + 14) / 15); // bulk_load fills leaves to 15
+    check(tree, points);
+
+    // Point inserts and removals keep the point layout; a box turns its leaf back
+    std::vector<DataItem> items = points;
+    for (int i = 0; i < 300; ++i)
+    {
+        double x = cell(rng), y = cell(rng);
+        items.emplace_back(2000 + i, "", i % 100, Rectangle(x, y, x, y));
+        tree.insert(items.back());
+    }
+    for (int i = 0; i < 2000; i += 3)
+        assert(tree.remove(items[i]));
+    std::vector<DataItem> kept;
+    for (size_t i = 0; i < items.size(); ++i)
+        if (i >= 2000 || i % 3 != 0)
+            kept.push_back(items[i]);
+    size_t point_leaves = tree.point_leaf_count();
+    assert(point_leaves > 0);
+    check(tree, kept);
+    std::uint64_t version = tree.commit_version();
+    kept.emplace_back(5000, "", 7, Rectangle(10, 10, 30, 30));
+    tree.insert(kept.back());
+    assert(tree.point_leaf_count() == point_leaves - 1);
+    check(tree, kept);
+    assert(tree.count(Rectangle(0, 0, 100, 100), version) == kept.size() - 1);
+
+    // Mixed leaves stay boxes
+    std::vector<DataItem> mixed = points;
+    for (auto &item : mixed)
+        if (item.id % 2 == 0)
+            item.bounds.max_corner.x += 0.5;
+    RTree mixed_tree(4, 16);
+    mixed_tree.bulk_load(mixed);
+    assert(mixed_tree.point_leaf_count() == 0);
+    check(mixed_tree, mixed);
+
+    // Integer points
+    GridRTree grid(4, 16);
+    using GridRect = BasicRectangle<std::int32_t, 2>;
+    std::vector<BasicDataItem<std::int32_t, 2>> grid_points;
+    for (std::int32_t i = 0; i < 500; ++i)
+        grid_points.emplace_back(i, "", 0, GridRect(i % 25, i / 25, i % 25, i / 25));
+    grid.bulk_load(grid_points);
+    assert(grid.point_leaf_count() > 0 && grid.count(GridRect(0, 0, 4, 4)) == 25);
+    std::cout << "Point Leaf Tests Passed!\n";
+}
+
+void test_grid_forest()
+{
+    std::cout << "Running Grid Forest Tests...\n";
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<double> lon(-190, 190), lat(-95, 95), small(0, 1), large(5, 40);
+    std::uniform_int_distribution<long> population(0, 1000);
+    std::vector<DataItem> items;
+    for (int i = 0; i < 4000; ++i)
+    {
+        double x = lon(rng), y = lat(rng);
+        double w = i % 40 == 0 ? large(rng) : small(rng), h = i % 40 == 0 ? large(rng) : small(rng);
+        items.emplace_back(i, "", population(rng), Rectangle(x, y, x + w, y + h));
+    }
+    auto check = [&](const GridForest &forest, const RTree &reference)
+    {
+        assert(forest.size() == reference.size());
+        for (int q = 0; q < 200; ++q)
+        {
+            double x = lon(rng), y = lat(rng), size = q % 10 == 0 ? 120 : small(rng) * 8;
+            Rectangle query(x, y, x + size, y + size);
+            std::vector<int> expected = sorted_ids(reference.search(query));
+            assert(sorted_ids(forest.search(query)) == expected); // Each item once, despite replication
+            assert(forest.count(query) == expected.size());
+            assert(sorted_ids(forest.search_with_population(query, 500)) == sorted_ids(reference.search_with_population(query, 500)));
+        }
+        assert(forest.count(Rectangle(-1000, -1000, 1000, 1000)) == reference.size());
+    };
+
+    RTree reference(4, 16);
+    reference.bulk_load(items);
+
+    // Fixed world grid; items past the extent land in the border cells
+    GridForest fixed(Rectangle(-180, -90, 180, 90), 16, 8);
+    fixed.insert_batch(std::span<const DataItem>(items).first(3000));
+    for (size_t i = 3000; i < items.size(); ++i)
+        fixed.insert(items[i]);
+    assert(fixed.stored_entries() > fixed.size()); // The large items span several cells
+    check(fixed, reference);
+
+    // Grid fitted to the data
+    GridForest fitted;
+    fitted.bulk_load(items, 100);
+    assert(fitted.cells_x() * fitted.cells_y() >= 40);
+    assert(fitted.extent().min_corner.x < -185 && fitted.extent().max_corner.x > 185);
+    check(fitted, reference);
+
+    // Removal takes an item out of every cell it spans
+    for (size_t i = 0; i < items.size(); i += 5)
+    {
+        assert(fitted.remove(items[i]) && reference.remove(items[i]));
+        assert(!fitted.remove(items[i]));
+    }
+    check(fitted, reference);
+    std::cout << "Grid Forest Tests Passed!\n";
+}
+
+void test_cell_cover()
+{
+    std::cout << "Running Cell Cover Tests...\n";
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<double> lon(-180, 180), lat(-90, 90), size(0, 30);
+    std::vector<DataItem> points;
+    for (int i = 0; i < 5000; ++i)
+    {
+        double x = lon(rng), y = lat(rng);
+        points.emplace_back(i, "", i, Rectangle(x, y, x, y));
+    }
+    CellCoverIndex index;
+    index.insert_batch(points);
+    for (int q = 0; q < 300; ++q)
+    {
+        double x = lon(rng), y = lat(rng), w = size(rng) / (1 + q % 50);
+        Rectangle query(x, y, x + w, y + w / 2);
+        std::vector<CellCoverIndex::KeyRange> ranges = index.cell_ranges(query);
+        // A handful of sorted, disjoint ranges, and the points in them are exactly the candidates
+        assert(!ranges.empty() && ranges.size() <= 64);
+        for (size_t i = 0; i < ranges.size(); ++i)
+            assert(ranges[i].begin < ranges[i].end && (i == 0 || ranges[i - 1].end < ranges[i].begin));
+        size_t expected = std::count_if(points.begin(), points.end(), [&](const DataItem &item)
+                                        { return query.contains(item.bounds.min_corner); });
+        assert(index.count(query) == expected);
+    }
+    assert(index.cell_ranges(Rectangle(500, 500, 501, 501)).empty());
+    assert(index.cell_ranges(Rectangle(1, 1, 0, 0)).empty());
+    assert(index.cell_ranges(Rectangle(-180, -90, 180, 90)).size() == 1); // The whole curve
+    std::cout << "Cell Cover Tests Passed!\n";
+}
+
+void test_fan_out_tuning()
+{
+    std::cout << "Running Fan-Out Tuning Tests...\n";
+    std::mt19937 rng(53);
+    std::uniform_real_distribution<double> coord(0, 100), size(0, 2);
+    std::vector<DataItem> items;
+    for (int i = 0; i < 3000; ++i)
+    {
+        double x = coord(rng), y = coord(rng);
+        items.emplace_back(i, "Item " + std::to_string(i), i, Rectangle(x, y, x + size(rng), y + size(rng)));
+    }
+    auto largest_leaf = [](const RTree &tree)
+    {
+        std::stringstream structure;
+        tree.print_structure(structure);
+        size_t largest = 0;
+        for (std::string line; std::getline(structure, line);)
+            if (line.find("[LEAF") != std::string::npos)
+                largest = std::max<size_t>(largest, std::stoul(line.substr(line.find("Size: ") + 6)));
+        return largest;
+    };
+    auto check = [&](const RTree &tree, const std::vector<DataItem> &live)
+    {
+        for (int q = 0; q < 50; ++q)
+        {
+            double x = coord(rng), y = coord(rng);
+            Rectangle query(x, y, x + 10, y + 10);
+            size_t expected = std::count_if(live.begin(), live.end(), [&](const DataItem &item)
+                                            { return item.bounds.intersects(query); });
+            assert(tree.count(query) == expected);
+        }
+    };
+
+    // Leaves and internal nodes keep their own capacities through inserts and removals
+    RTree tree(FanOut{2, 4, 10, 32});
+    assert(tree.fan_out().max_leaf_entries == 32 && tree.fan_out().max_entries == 4);
+    for (const auto &item : items)
+        tree.insert(item);
+    assert(largest_leaf(tree) < 32 && largest_leaf(tree) > 4);
+    std::vector<DataItem> live;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (i % 4 == 0)
+            assert(tree.remove(items[i]));
+        else
+            live.push_back(items[i]);
+    }
+    check(tree, live);
+
+    // Changing the fan-out re-packs the contents; versions keep their nodes
+    std::uint64_t version = tree.commit_version();
+    tree.set_fan_out(FanOut{3, 8, 3, 8});
+    assert(tree.size() == live.size() && largest_leaf(tree) < 8);
+    check(tree, live);
+    assert(tree.count(Rectangle(-10, -10, 200, 200), version) == live.size());
+    auto retained = tree.search(Rectangle(-10, -10, 200, 200), version);
+    assert(sorted_ids(retained) == sorted_ids(live));
+    assert(std::all_of(retained.begin(), retained.end(), [&](const DataItem &item)
+                       { return item.name == items[item.id].name && item.population == item.id; }));
+    RTree adjusted(FanOut{5, 6, 1, 1}); // Adjusted to min >= 2 and max >= 2 * min
+    assert(adjusted.fan_out().max_entries == 10 && adjusted.fan_out().max_leaf_entries == 4);
+
+    // Candidates fill whole cache lines; tuning measures every candidate once
+    CacheInfo cache = detect_cache_info();
+    assert(cache.line_size > 0 && cache.l1_data_size > 0);
+    CacheInfo fixed{64, 32 * 1024, 1 << 20, 8 << 20};
+    assert((fan_out_candidates(fixed, sizeof(Rectangle)) == std::vector<size_t>{4, 8, 16, 32, 64, 128}));
+    assert((fan_out_candidates(fixed, sizeof(Point)) == std::vector<size_t>{8, 16, 32, 64, 128, 256}));
+    std::vector<Rectangle> queries;
+    for (int q = 0; q < 100; ++q)
+    {
+        double x = coord(rng), y = coord(rng);
+        queries.emplace_back(x, y, x + 5, y + 5);
+    }
+    auto [tuned_tree, tuning] = bulk_load_tuned(items, queries, 1000);
+    RTree &tuned = *tuned_tree;
+    std::vector<size_t> leaf_sizes = fan_out_candidates(cache, sizeof(Rectangle)), internal_sizes = leaf_sizes;
+    size_t measured_twice = std::count(internal_sizes.begin(), internal_sizes.end(), size_t(16)); // In both sweeps
+    assert(tuning.trials.size() == leaf_sizes.size() + internal_sizes.size() - measured_twice);
+    auto winner = std::min_element(tuning.trials.begin(), tuning.trials.end(), [](const FanOutTrial &a, const FanOutTrial &b)
+                                   { return a.query_ms < b.query_ms; });
+    assert(tuning.best.max_entries == winner->fan_out.max_entries && tuning.best.max_leaf_entries == winner->fan_out.max_leaf_entries);
+    assert(tuned.fan_out().max_leaf_entries == tuning.best.max_leaf_entries && tuned.size() == items.size());
+    check(tuned, items);
+    std::cout << "Fan-Out Tuning Tests Passed!\n";
+}
+
 int main()
 {
     std::cout << "===== Starting R-Tree Tests =====\n"
               << std::endl;
 
     test_rectangle_operations();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_templated_geometry();
     std::cout << "\n---------------------------------\n"
               << std::endl;
     test_rtree_basic_operations();
     std::cout << "\n---------------------------------\n"
               << std::endl;
     test_rtree_population_query();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_traversal_queries();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_insert_descent_path();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_lazy_mbr_tightening();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_batch_insert();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_buffered_insert();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_remove_and_bulk_load();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_lsm_rtree();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_durable_rtree();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_paged_rtree();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_async_page_prefetch();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_compressed_leaves();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_snapshot_diff();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_versioned_snapshots();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_temporal_index();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_tpr_tree();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_standing_queries();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_query_index();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_index_backends();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_point_leaves();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_grid_forest();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_cell_cover();
+    std::cout << "\n---------------------------------\n"
+              << std::endl;
+    test_fan_out_tuning();
 
     std::cout << "\n===== All R-Tree Tests Completed Successfully! =====\n"
               << std::endl;
@@ -0,0 +1,398 @@
+#include "tpr_tree.h"
+
+#include <algorithm> // For std::sort, std::min, std::max
+#include <array>
+#include <iterator>  // For std::back_inserter
+#include <cmath>     // For std::abs
+#include <stdexcept> // For std::invalid_argument, std::runtime_error
+
+// Node boxes are re-expressed at later times by floating-point arithmetic, so
+// a node may end up a few ulps short of an item lying exactly on its border.
+// Internal entries are therefore tested against the query (or the item being
+// looked up) grown by this relative tolerance.
+static const double border_tolerance = 1e-9;
+
+static Rectangle padded(const Rectangle &rect)
+{
+    Rectangle result = rect;
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        result.min_corner[i] -= border_tolerance * (1 + std::abs(rect.min_corner[i]));
+        result.max_corner[i] += border_tolerance * (1 + std::abs(rect.max_corner[i]));
+    }
+    return result;
+}
+
+Rectangle MovingItem::bounds_at(double t) const
+{
+    double dt = t - reference_time;
+    return Rectangle(bounds.min_corner.x + velocity.x * dt, bounds.min_corner.y + velocity.y * dt,
+                     bounds.max_corner.x + velocity.x * dt, bounds.max_corner.y + velocity.y * dt);
+}
+
+// --- Motion Boxes ---
+
+TPRTree::MotionBox TPRTree::MotionBox::of(const MovingItem &item)
+{
+    return {item.bounds, item.velocity, item.velocity, item.reference_time};
+}
+
+TPRTree::MotionBox TPRTree::MotionBox::empty(double t)
+{
+    return {Rectangle::empty(), Point(), Point(), t};
+}
+
+Rectangle TPRTree::MotionBox::at(double t) const
+{
+    if (!box.is_valid())
+        return box; // The empty box stays empty
+    double dt = t - ref;
+    return Rectangle(box.min_corner.x + vmin.x * dt, box.min_corner.y + vmin.y * dt,
+                     box.max_corner.x + vmax.x * dt, box.max_corner.y + vmax.y * dt);
+}
+
+void TPRTree::MotionBox::expand(const MotionBox &other, double t)
+{
+    if (!box.is_valid())
+    {
+        *this = {other.at(t), other.vmin, other.vmax, t};
+        return;
+    }
+    // Both boxes bound their contents from t on, so their union at t with the
+    // extreme velocities of both does too
+    box = Rectangle::combine(at(t), other.at(t));
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        vmin[i] = std::min(vmin[i], other.vmin[i]);
+        vmax[i] = std::max(vmax[i], other.vmax[i]);
+    }
+    ref = t;
+}
+
+bool TPRTree::MotionBox::contains(const MotionBox &other, double t) const
+{
+    bool inside = padded(at(t)).contains(other.at(t));
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        inside &= vmin[i] <= other.vmin[i] && vmax[i] >= other.vmax[i];
+    }
+    return inside;
+}
+
+bool TPRTree::MotionBox::intersects_during(const Rectangle &query, double from, double to) const
+{
+    if (from == to)
+        return at(from).intersects(query);
+
+    // Each edge moves linearly, so every overlap condition a + b * (t - ref) <= c
+    // holds on a half-line of times; intersect those with [from, to]
+    double lo = from, hi = to;
+    auto constrain = [&](double a, double b, double c)
+    {
+        if (b > 0)
+            hi = std::min(hi, ref + (c - a) / b);
+        else if (b < 0)
+            lo = std::max(lo, ref + (c - a) / b);
+        else if (a > c)
+            hi = -std::numeric_limits<double>::infinity();
+    };
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        constrain(box.min_corner[i], vmin[i], query.max_corner[i]);    // Lower edge <= query max
+        constrain(-box.max_corner[i], -vmax[i], -query.min_corner[i]); // Upper edge >= query min
+    }
+    return lo <= hi;
+}
+
+double TPRTree::MotionBox::integrated_area(double t, double horizon) const
+{
+    Rectangle start = at(t);
+    if (!start.is_valid())
+        return 0;
+    double wx = start.max_corner.x - start.min_corner.x, wy = start.max_corner.y - start.min_corner.y;
+    double gx = vmax.x - vmin.x, gy = vmax.y - vmin.y; // Growth rate of each extent
+    double h = horizon;
+    return wx * wy * h + (wx * gy + wy * gx) * h * h / 2 + gx * gy * h * h * h / 3;
+}
+
+TPRTree::MotionBox TPRTree::Node::bounds(double t) const
+{
+    MotionBox result = MotionBox::empty(t);
+    for (const auto &box : entry_boxes)
+    {
+        result.expand(box, t);
+    }
+    return result;
+}
+
+// --- Construction ---
+
+TPRTree::TPRTree(double horizon, size_t min_entries, size_t max_entries)
+    : horizon_(horizon), min_entries_(min_entries), max_entries_(max_entries), root_(std::make_unique<Node>())
+{
+    if (!(horizon >= 0))
+        throw std::invalid_argument("TPRTree: horizon must not be negative");
+    if (min_entries == 0 || max_entries < 2 * min_entries)
+        throw std::invalid_argument("TPRTree: need 0 < min_entries <= max_entries / 2");
+}
+
+int TPRTree::height() const
+{
+    int levels = 1;
+    for (const Node *node = root_.get(); !node->is_leaf; node = node->children.front().get())
+        ++levels;
+    return levels;
+}
+
+void TPRTree::advance_to(double t)
+{
+    now_ = std::max(now_, t);
+}
+
+// --- Updates ---
+
+void TPRTree::update(const MovingItem &item)
+{
+    advance_to(item.reference_time);
+    remove(item.id);
+    motions_.emplace(item.id, MotionBox::of(item));
+    insert_item(item);
+}
+
+bool TPRTree::remove(int id)
+{
+    auto motion = motions_.find(id);
+    if (motion == motions_.end())
+        return false;
+
+    std::vector<PathStep> path;
+    Node *leaf = find_leaf(root_.get(), motion->second, id, path);
+    if (!leaf)
+        throw std::runtime_error("TPRTree: item " + std::to_string(id) + " is not where its motion says");
+    motions_.erase(motion);
+
+    auto entry = std::find_if(leaf->items.begin(), leaf->items.end(), [&](const MovingItem &item)
+                              { return item.id == id; });
+    leaf->entry_boxes.erase(leaf->entry_boxes.begin() + (entry - leaf->items.begin()));
+    leaf->items.erase(entry);
+
+    // Condense the path: dissolve underfull nodes and tighten the boxes of the
+    // others to the current time
+    std::vector<MovingItem> orphans;
+    for (size_t k = path.size(); k-- > 0;)
+    {
+        Node *parent = path[k].node;
+        size_t index = path[k].child_index;
+        Node *child = parent->children[index].get();
+        if (child->size() < min_entries_)
+        {
+            collect_items(child, orphans);
+            parent->children.erase(parent->children.begin() + index);
+            parent->entry_boxes.erase(parent->entry_boxes.begin() + index);
+        }
+        else
+        {
+            parent->entry_boxes[index] = child->bounds(now_);
+        }
+    }
+    while (!root_->is_leaf && root_->children.size() == 1)
+    {
+        std::unique_ptr<Node> only_child = std::move(root_->children.front());
+        root_ = std::move(only_child);
+    }
+    if (!root_->is_leaf && root_->children.empty())
+    {
+        root_ = std::make_unique<Node>();
+    }
+
+    for (const auto &item : orphans)
+    {
+        insert_item(item);
+    }
+    return true;
+}
+
+void TPRTree::insert_item(const MovingItem &item)
+{
+    MotionBox box = MotionBox::of(item);
+    std::vector<PathStep> path;
+    Node *node = root_.get();
+    while (!node->is_leaf)
+    {
+        size_t child_index = choose_subtree(node, box);
+        node->entry_boxes[child_index].expand(box, now_);
+        path.push_back({node, child_index});
+        node = node->children[child_index].get();
+    }
+    node->items.push_back(item);
+    node->entry_boxes.push_back(box);
+
+    // Split overflowing nodes on the way back up
+    std::unique_ptr<Node> split_off = node->size() > max_entries_ ? split_node(node) : nullptr;
+    for (size_t k = path.size(); k-- > 0 && split_off;)
+    {
+        Node *parent = path[k].node;
+        size_t index = path[k].child_index;
+        parent->entry_boxes[index] = parent->children[index]->bounds(now_);
+        parent->entry_boxes.push_back(split_off->bounds(now_));
+        parent->children.push_back(std::move(split_off));
+        split_off = parent->size() > max_entries_ ? split_node(parent) : nullptr;
+    }
+    if (split_off)
+    {
+        auto new_root = std::make_unique<Node>();
+        new_root->is_leaf = false;
+        new_root->entry_boxes.push_back(root_->bounds(now_));
+        new_root->children.push_back(std::move(root_));
+        new_root->entry_boxes.push_back(split_off->bounds(now_));
+        new_root->children.push_back(std::move(split_off));
+        root_ = std::move(new_root);
+    }
+}
+
+// Least growth of the box integrated over the horizon, then least integrated area
+size_t TPRTree::choose_subtree(const Node *node, const MotionBox &box) const
+{
+    size_t best = 0;
+    double best_increase = std::numeric_limits<double>::infinity();
+    double best_area = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < node->entry_boxes.size(); ++i)
+    {
+        const MotionBox &entry = node->entry_boxes[i];
+        double area = entry.integrated_area(now_, horizon_);
+        MotionBox grown = entry;
+        grown.expand(box, now_);
+        double increase = grown.integrated_area(now_, horizon_) - area;
+        if (increase < best_increase || (increase == best_increase && area < best_area))
+        {
+            best = i;
+            best_increase = increase;
+            best_area = area;
+        }
+    }
+    return best;
+}
+
+// Halve node along the axis where its entries are most spread out halfway
+// through the horizon
+std::unique_ptr<TPRTree::Node> TPRTree::split_node(Node *node)
+{
+    const double mid = now_ + horizon_ / 2;
+    const size_t count = node->size();
+    std::vector<std::array<double, 2>> centers(count);
+    Rectangle spread = Rectangle::empty();
+    for (size_t k = 0; k < count; ++k)
+    {
+        Rectangle r = node->entry_boxes[k].at(mid);
+        centers[k] = {r.min_corner.x / 2 + r.max_corner.x / 2, r.min_corner.y / 2 + r.max_corner.y / 2};
+        spread.expand(Rectangle(centers[k][0], centers[k][1], centers[k][0], centers[k][1]));
+    }
+    size_t axis = spread.max_corner.x - spread.min_corner.x >= spread.max_corner.y - spread.min_corner.y ? 0 : 1;
+    std::vector<size_t> order(count);
+    for (size_t k = 0; k < count; ++k)
+        order[k] = k;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+              { return centers[a][axis] < centers[b][axis]; });
+
+    // Rebuild both halves in sorted order
+    auto sibling = std::make_unique<Node>();
+    sibling->is_leaf = node->is_leaf;
+    Node kept;
+    kept.is_leaf = node->is_leaf;
+    size_t split_index = std::max(min_entries_, count / 2);
+    for (size_t rank = 0; rank < count; ++rank)
+    {
+        size_t k = order[rank];
+        Node &target = rank < split_index ? kept : *sibling;
+        target.entry_boxes.push_back(node->entry_boxes[k]);
+        if (node->is_leaf)
+            target.items.push_back(std::move(node->items[k]));
+        else
+            target.children.push_back(std::move(node->children[k]));
+    }
+    *node = std::move(kept);
+    return sibling;
+}
+
+TPRTree::Node *TPRTree::find_leaf(Node *node, const MotionBox &box, int id, std::vector<PathStep> &path) const
+{
+    if (node->is_leaf)
+    {
+        bool found = std::any_of(node->items.begin(), node->items.end(), [&](const MovingItem &item)
+                                 { return item.id == id; });
+        return found ? node : nullptr;
+    }
+    for (size_t i = 0; i < node->children.size(); ++i)
+    {
+        if (!node->entry_boxes[i].contains(box, now_))
+            continue;
+        path.push_back({node, i});
+        if (Node *leaf = find_leaf(node->children[i].get(), box, id, path))
+            return leaf;
+        path.pop_back();
+    }
+    return nullptr;
+}
+
+void TPRTree::collect_items(Node *node, std::vector<MovingItem> &out)
+{
+    std::move(node->items.begin(), node->items.end(), std::back_inserter(out));
+    for (auto &child : node->children)
+    {
+        collect_items(child.get(), out);
+    }
+}
+
+// --- Queries ---
+
+template <typename Visitor>
+void TPRTree::traverse(const Rectangle &query_rect, double from, double to, Visitor &&visit) const
+{
+    if (from < now_)
+        throw std::invalid_argument("TPRTree: queries cannot look before now()");
+    if (to < from)
+        return;
+    Rectangle node_query = padded(query_rect);
+    std::vector<const Node *> stack{root_.get()};
+    while (!stack.empty())
+    {
+        const Node *node = stack.back();
+        stack.pop_back();
+        for (size_t i = 0; i < node->entry_boxes.size(); ++i)
+        {
+            if (node->is_leaf)
+            {
+                if (node->entry_boxes[i].intersects_during(query_rect, from, to))
+                    visit(node->items[i]);
+            }
+            else if (node->entry_boxes[i].intersects_during(node_query, from, to))
+            {
+                stack.push_back(node->children[i].get());
+            }
+        }
+    }
+}
+
+std::vector<MovingItem> TPRTree::search_at(const Rectangle &query_rect, double t) const
+{
+    std::vector<MovingItem> results;
+    traverse(query_rect, t, t, [&](const MovingItem &item)
+             { results.push_back(item); });
+    return results;
+}
+
+size_t TPRTree::count_at(const Rectangle &query_rect, double t) const
+{
+    size_t matches = 0;
+    traverse(query_rect, t, t, [&](const MovingItem &)
+             { ++matches; });
+    return matches;
+}
+
+std::vector<MovingItem> TPRTree::search_during(const Rectangle &query_rect, double from, double to) const
+{
+    std::vector<MovingItem> results;
+    traverse(query_rect, from, to, [&](const MovingItem &item)
+             { results.push_back(item); });
+    return results;
+}
@@ -0,0 +1,130 @@
+#ifndef TPR_TREE_H
+#define TPR_TREE_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <memory>        // For std::unique_ptr
+#include <unordered_map> // Current motion of each id
+
+// --- Moving Item ---
+// An item moving at a constant velocity: `bounds` is its extent at
+// `reference_time`, and every coordinate moves by velocity * dt.
+struct MovingItem
+{
+    int id;
+    std::string name;
+    long population;
+    Rectangle bounds;
+    Point velocity;        // Units per time unit along x and y
+    double reference_time; // Time at which the item had `bounds`
+
+    MovingItem(int id_ = 0, std::string name_ = "", long pop_ = 0, Rectangle b_ = Rectangle(),
+               Point velocity_ = Point(), double reference_time_ = 0)
+        : id(id_), name(std::move(name_)), population(pop_), bounds(b_), velocity(velocity_), reference_time(reference_time_) {}
+
+    // Extent at time t
+    Rectangle bounds_at(double t) const;
+};
+
+// --- Time-Parameterized R-Tree (TPR-tree) ---
+// Indexes moving items by time-parameterized bounding boxes: each entry box
+// stores its extent at a reference time plus the lowest and highest velocity
+// of its lower and upper edges, so it bounds its contents at every later
+// time. Items only need an update when their motion changes, not whenever
+// they move, and queries can ask where items will be at a future time.
+//
+// The tree keeps a clock (now()), advanced by updates. Node boxes are rebuilt
+// at the current time along every modified path, and insertion chooses the
+// subtree whose box grows least when integrated over [now, now + horizon],
+// so boxes stay tight for the time queries are expected to look ahead.
+// Queries must not ask about times before now().
+class TPRTree
+{
+public:
+    explicit TPRTree(double horizon = 60, size_t min_entries = 4, size_t max_entries = 16);
+
+    TPRTree(const TPRTree &) = delete;
+    TPRTree &operator=(const TPRTree &) = delete;
+
+    // Insert item, or replace the stored motion of item.id. Moves the clock
+    // forward to item.reference_time if that is later.
+    void update(const MovingItem &item);
+
+    // Delete the item with the given id; false if it is not stored
+    bool remove(int id);
+
+    // Move the clock forward (never backwards)
+    void advance_to(double t);
+    double now() const { return now_; }
+
+    // Items intersecting query_rect at time t (t >= now(), else std::invalid_argument)
+    std::vector<MovingItem> search_at(const Rectangle &query_rect, double t) const;
+    size_t count_at(const Rectangle &query_rect, double t) const;
+
+    // Items intersecting query_rect at some time in [from, to] (from >= now())
+    std::vector<MovingItem> search_during(const Rectangle &query_rect, double from, double to) const;
+
+    size_t size() const { return motions_.size(); }
+    int height() const;
+
+private:
+    // Time-parameterized box: extent at ref, plus velocity bounds of the
+    // lower (vmin) and upper (vmax) edges. Bounds its contents for t >= ref.
+    struct MotionBox
+    {
+        Rectangle box;
+        Point vmin;
+        Point vmax;
+        double ref = 0;
+
+        static MotionBox of(const MovingItem &item);
+        static MotionBox empty(double t);
+
+        Rectangle at(double t) const;
+        // Grow to bound other as well, re-expressed at time t (>= both refs)
+        void expand(const MotionBox &other, double t);
+        // Contains other at time t and at all later times
+        bool contains(const MotionBox &other, double t) const;
+        // Intersects query at some time in [from, to]
+        bool intersects_during(const Rectangle &query, double from, double to) const;
+        // Area integrated over [t, t + horizon]
+        double integrated_area(double t, double horizon) const;
+    };
+
+    struct Node
+    {
+        bool is_leaf = true;
+        std::vector<MotionBox> entry_boxes; // entry_boxes[i] bounds children[i] or items[i]
+        std::vector<std::unique_ptr<Node>> children;
+        std::vector<MovingItem> items;
+
+        size_t size() const { return is_leaf ? items.size() : children.size(); }
+        MotionBox bounds(double t) const; // Box of all entries, expressed at t
+    };
+
+    struct PathStep
+    {
+        Node *node;
+        size_t child_index;
+    };
+
+    void insert_item(const MovingItem &item);
+    size_t choose_subtree(const Node *node, const MotionBox &box) const;
+    std::unique_ptr<Node> split_node(Node *node);
+    Node *find_leaf(Node *node, const MotionBox &box, int id, std::vector<PathStep> &path) const;
+    static void collect_items(Node *node, std::vector<MovingItem> &out);
+
+    // Calls visit(item) for every item meeting query_rect during [from, to]
+    template <typename Visitor>
+    void traverse(const Rectangle &query_rect, double from, double to, Visitor &&visit) const;
+
+    double horizon_;
+    size_t min_entries_;
+    size_t max_entries_;
+    double now_ = -std::numeric_limits<double>::infinity();
+    std::unique_ptr<Node> root_;
+    std::unordered_map<int, MotionBox> motions_; // Box of every stored id, to find it again
+};
+
+#endif // TPR_TREE_H
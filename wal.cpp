@@ -0,0 +1,316 @@
+#include "wal.h"
+#include "leaf_codec.h"
+
+#include <array>
+#include <cstring>    // For std::memcpy
+#include <cerrno>     // For EINTR
+#include <fstream>    // For reading whole files
+#include <iterator>   // For std::istreambuf_iterator
+#include <stdexcept>  // For runtime_error
+#include <filesystem> // For the snapshot's parent directory
+#include <fcntl.h>    // For open
+#include <unistd.h>   // For write, fsync, ftruncate, close
+
+// --- Helper Functions ---
+
+std::uint32_t crc32_ieee(const char *data, size_t size)
+{
+    static const std::array<std::uint32_t, 256> table = []
+    {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t i = 0; i < 256; ++i)
+        {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFFu] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+namespace
+{
+    template <typename V>
+    void put(std::vector<char> &out, const V &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(V));
+    }
+
+    // Bounds-checked reader over a byte range
+    struct Reader
+    {
+        const char *pos;
+        const char *end;
+
+        template <typename V>
+        bool get(V &value)
+        {
+            if (static_cast<size_t>(end - pos) < sizeof(V))
+                return false;
+            std::memcpy(&value, pos, sizeof(V));
+            pos += sizeof(V);
+            return true;
+        }
+    };
+
+    void put_item(std::vector<char> &out, const DataItem &item)
+    {
+        put(out, static_cast<std::int32_t>(item.id));
+        put(out, static_cast<std::int64_t>(item.population));
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            put(out, item.bounds.min_corner[i]);
+            put(out, item.bounds.max_corner[i]);
+        }
+        put(out, static_cast<std::uint32_t>(item.name.size()));
+        out.insert(out.end(), item.name.begin(), item.name.end());
+    }
+
+    bool get_item(Reader &in, DataItem &item)
+    {
+        std::int32_t id;
+        std::int64_t population;
+        std::uint32_t name_size;
+        if (!in.get(id) || !in.get(population))
+            return false;
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            if (!in.get(item.bounds.min_corner[i]) || !in.get(item.bounds.max_corner[i]))
+                return false;
+        }
+        if (!in.get(name_size) || static_cast<size_t>(in.end - in.pos) < name_size)
+            return false;
+        item.id = id;
+        item.population = static_cast<long>(population);
+        item.name.assign(in.pos, name_size);
+        in.pos += name_size;
+        return true;
+    }
+
+    // Write all of data, retrying short writes
+    void write_all(int fd, const char *data, size_t size, const std::string &path)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error("Could not write to file: " + path);
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void sync_fd(int fd, const std::string &path)
+    {
+        if (::fsync(fd) != 0)
+            throw std::runtime_error("Could not fsync file: " + path);
+    }
+
+    std::vector<char> read_file(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+}
+
+// --- Write-Ahead Log ---
+
+WriteAheadLog::WriteAheadLog(const std::string &path, size_t group_commit_records)
+    : path_(path), group_commit_records_(std::max<size_t>(group_commit_records, 1))
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0)
+        throw std::runtime_error("Could not open write-ahead log: " + path);
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    try
+    {
+        commit();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "ERROR: Losing uncommitted log records: " << e.what() << std::endl;
+    }
+    ::close(fd_);
+}
+
+std::uint64_t WriteAheadLog::recover(std::uint64_t min_lsn, const std::function<void(const WalRecord &)> &apply)
+{
+    std::vector<char> log = read_file(path_);
+    Reader in{log.data(), log.data() + log.size()};
+    std::uint64_t last = min_lsn;
+    const char *intact_end = in.pos;
+    while (true)
+    {
+        std::uint32_t size, crc;
+        if (!in.get(size) || !in.get(crc) || static_cast<size_t>(in.end - in.pos) < size || crc32_ieee(in.pos, size) != crc)
+            break;
+        Reader payload{in.pos, in.pos + size};
+        WalRecord record;
+        std::uint8_t op;
+        if (!payload.get(record.lsn) || !payload.get(op) || !get_item(payload, record.item))
+            break;
+        record.op = static_cast<WalOp>(op);
+        apply(record);
+        last = std::max(last, record.lsn);
+        in.pos += size;
+        intact_end = in.pos;
+    }
+
+    // Drop a torn tail so new records follow the last intact one
+    size_t intact_size = static_cast<size_t>(intact_end - log.data());
+    if (intact_size < log.size())
+    {
+        std::cerr << "Warning: Discarding " << log.size() - intact_size << " bytes of torn write-ahead log tail." << std::endl;
+        if (::ftruncate(fd_, static_cast<off_t>(intact_size)) != 0)
+            throw std::runtime_error("Could not truncate write-ahead log: " + path_);
+        sync_fd(fd_, path_);
+    }
+
+    next_lsn_ = last + 1;
+    durable_lsn_ = last;
+    return last;
+}
+
+std::uint64_t WriteAheadLog::append(WalOp op, const DataItem &item)
+{
+    std::uint64_t lsn = next_lsn_++;
+
+    // Reserve the frame header, then fill it in once the payload size is known
+    size_t frame = pending_.size();
+    pending_.resize(frame + 2 * sizeof(std::uint32_t));
+    put(pending_, lsn);
+    put(pending_, static_cast<std::uint8_t>(op));
+    put_item(pending_, item);
+    const char *payload = pending_.data() + frame + 2 * sizeof(std::uint32_t);
+    std::uint32_t size = static_cast<std::uint32_t>(pending_.data() + pending_.size() - payload);
+    std::uint32_t crc = crc32_ieee(payload, size);
+    std::memcpy(pending_.data() + frame, &size, sizeof(size));
+    std::memcpy(pending_.data() + frame + sizeof(size), &crc, sizeof(crc));
+
+    if (++pending_records_ >= group_commit_records_)
+        commit();
+    return lsn;
+}
+
+void WriteAheadLog::commit()
+{
+    if (pending_records_ == 0)
+        return;
+    write_all(fd_, pending_.data(), pending_.size(), path_);
+    sync_fd(fd_, path_);
+    pending_.clear();
+    pending_records_ = 0;
+    durable_lsn_ = last_lsn();
+}
+
+void WriteAheadLog::reset()
+{
+    // Pending records are covered by the checkpoint too, so they need not be written
+    pending_.clear();
+    pending_records_ = 0;
+    durable_lsn_ = last_lsn();
+    if (::ftruncate(fd_, 0) != 0)
+        throw std::runtime_error("Could not truncate write-ahead log: " + path_);
+    sync_fd(fd_, path_);
+}
+
+// --- Snapshots ---
+
+// Items are stored in CompressedLeaf blocks of snapshot_block_items consecutive items
+static const char snapshot_magic[8] = {'R', 'T', 'S', 'N', 'A', 'P', '0', '2'};
+static const size_t snapshot_block_items = 256;
+
+void write_snapshot(const std::string &path, std::uint64_t lsn, const std::vector<DataItem> &items)
+{
+    std::vector<char> body;
+    put(body, lsn);
+    put(body, static_cast<std::uint64_t>(items.size()));
+    std::span<const DataItem> all(items);
+    for (size_t begin = 0; begin < items.size(); begin += snapshot_block_items)
+    {
+        CompressedLeaf block = CompressedLeaf::encode(all.subspan(begin, std::min(snapshot_block_items, items.size() - begin)));
+        put(body, static_cast<std::uint64_t>(block.bytes().size()));
+        body.insert(body.end(), block.bytes().begin(), block.bytes().end());
+    }
+    std::uint32_t crc = crc32_ieee(body.data(), body.size());
+
+    std::string temp_path = path + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Could not create snapshot: " + temp_path);
+    try
+    {
+        write_all(fd, snapshot_magic, sizeof(snapshot_magic), temp_path);
+        write_all(fd, body.data(), body.size(), temp_path);
+        write_all(fd, reinterpret_cast<const char *>(&crc), sizeof(crc), temp_path);
+        sync_fd(fd, temp_path);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Could not replace snapshot: " + path);
+
+    // Make the rename itself durable
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    int dir_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (dir_fd >= 0)
+    {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+bool read_snapshot(const std::string &path, std::uint64_t &lsn, std::vector<DataItem> &items)
+{
+    if (!std::filesystem::exists(path))
+        return false;
+
+    std::vector<char> file = read_file(path);
+    const size_t overhead = sizeof(snapshot_magic) + sizeof(std::uint32_t);
+    std::uint32_t crc;
+    if (file.size() < overhead)
+        throw std::runtime_error("Not a snapshot file: " + path);
+    if (std::memcmp(file.data(), snapshot_magic, sizeof(snapshot_magic)) != 0)
+        throw std::runtime_error("Not a snapshot file: " + path);
+    std::memcpy(&crc, file.data() + file.size() - sizeof(crc), sizeof(crc));
+    Reader in{file.data() + sizeof(snapshot_magic), file.data() + file.size() - sizeof(crc)};
+    if (crc32_ieee(in.pos, static_cast<size_t>(in.end - in.pos)) != crc)
+        throw std::runtime_error("Snapshot checksum mismatch: " + path);
+
+    std::uint64_t count;
+    if (!in.get(lsn) || !in.get(count))
+        throw std::runtime_error("Truncated snapshot: " + path);
+    items.clear();
+    items.reserve(count);
+    while (items.size() < count)
+    {
+        std::uint64_t block_size;
+        if (!in.get(block_size) || static_cast<std::uint64_t>(in.end - in.pos) < block_size)
+            throw std::runtime_error("Truncated snapshot: " + path);
+        std::vector<DataItem> block = CompressedLeaf::from_bytes({in.pos, static_cast<size_t>(block_size)}).decode();
+        std::move(block.begin(), block.end(), std::back_inserter(items));
+        in.pos += block_size;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include "rtree.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>    // For fixed-width on-disk fields
+#include <functional> // For the replay callback
+
+// --- Write-Ahead Log ---
+// Append-only log of index modifications. Each record is framed as
+//   [u32 payload length][u32 CRC-32 of payload][payload]
+// with the payload holding the record's LSN, operation and item. Integers and
+// doubles are stored in native byte order, so files are not portable between
+// architectures with different endianness.
+//
+// Records are buffered and written with a single write + fsync once
+// group_commit_records of them are pending (or on commit()), so one fsync
+// covers a whole group of operations. A crash loses at most the records of
+// the group that was not yet committed. A torn write at the end of the file
+// fails its length or CRC check and is cut off during recovery.
+
+enum class WalOp : std::uint8_t
+{
+    insert = 1, // New item
+    update = 2, // Replaces the item with the same id
+    remove = 3  // Deletes item.id (bounds locate it in the tree)
+};
+
+struct WalRecord
+{
+    std::uint64_t lsn = 0; // Log sequence number, increasing by one per record
+    WalOp op = WalOp::insert;
+    DataItem item;
+};
+
+class WriteAheadLog
+{
+public:
+    // Opens (or creates) the log file at path
+    explicit WriteAheadLog(const std::string &path, size_t group_commit_records = 64);
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+    ~WriteAheadLog(); // Commits pending records
+
+    // Calls apply for every intact record in file order, cuts off a torn tail
+    // and continues numbering after the last record (or after min_lsn, if
+    // that is later). Returns the LSN of the last record (or min_lsn).
+    std::uint64_t recover(std::uint64_t min_lsn, const std::function<void(const WalRecord &)> &apply);
+
+    // Buffers a record and returns its LSN; commits when the group is full
+    std::uint64_t append(WalOp op, const DataItem &item);
+
+    // Write and fsync all pending records
+    void commit();
+
+    // Empty the log, pending records included, once a checkpoint covers them all
+    void reset();
+
+    std::uint64_t last_lsn() const { return next_lsn_ - 1; }
+    std::uint64_t durable_lsn() const { return durable_lsn_; }
+    size_t pending_records() const { return pending_records_; }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    size_t group_commit_records_;
+    std::vector<char> pending_; // Encoded records not yet written
+    size_t pending_records_ = 0;
+    std::uint64_t next_lsn_ = 1;
+    std::uint64_t durable_lsn_ = 0;
+};
+
+// --- Snapshots ---
+// A checkpoint stores every item plus the LSN of the last log record it
+// includes. Snapshots are written to a temporary file, fsynced and renamed
+// over the old one, so a crash leaves either the old or the new snapshot.
+// Items are stored in CompressedLeaf blocks (see leaf_codec.h); older
+// snapshots with one record per item are rejected by read_snapshot.
+
+void write_snapshot(const std::string &path, std::uint64_t lsn, const std::vector<DataItem> &items);
+
+// Returns false if there is no snapshot at path; throws std::runtime_error if it is corrupt
+bool read_snapshot(const std::string &path, std::uint64_t &lsn, std::vector<DataItem> &items);
+
+// CRC-32 (IEEE 802.3 polynomial) of a byte range
+std::uint32_t crc32_ieee(const char *data, size_t size);
+
+#endif // WAL_H